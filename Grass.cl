@@ -2,6 +2,12 @@
 #define PI     3.14159265
 #define TWO_PI 6.28318531
 
+//build option -D GRASS_KERNEL_FLOAT4 : blade transforms as float3 columns in registers and one
+//vstore16 per segment, else the Matrix4x4 reference path ( 64 byte structs, scalar stores)
+
+//grass_kernel loops over the segments of its blade, grass_segment_kernel ( same arguments) runs one
+//work item per ( blade, segment) for more items on small grids, see GRASS_SEGMENT_GROUP
+
 /* ___________________ structure declarations _____________________ */
 
 #pragma pack(1)
@@ -26,6 +32,42 @@ typedef struct
     float m[4][4];
 }Matrix4x4;
 
+//analytic wind, same layout as GrassTypes.h
+typedef struct
+{
+    float direction[2];
+    float strength;
+    float frequency;
+    float speed;
+    float gustFrequency;
+} GRASS_PROCEDURAL_WIND;
+
+//visible tile, same layout as GrassTypes.h
+typedef struct
+{
+    int   x;
+    int   z;
+    int   width;
+    int   height;
+    int   firstVertex;
+    int   level;
+    int   segments;
+    int   coarseSegments;
+    float morph;
+}GRASS_LOD_TILE;
+
+//per blade part of the float3 column path, shared by the segments of a blade
+typedef struct
+{
+    float3 position;
+    float3 base[3];             //segment 0 : tangent to local * facing
+    float3 transformation[3];   //other segments : with bend and wind
+    float  width;
+    float  height;
+    float  forward;
+    float  unused;              //size a multiple of 16, float3 stay aligned in arrays despite pack(1)
+}GRASS_BLADE_FRAME;
+
 
 /* ___________________ global variable definition _____________________ */
 
@@ -44,9 +86,39 @@ __constant float windStrength = 0.345f;
 
 __constant int COLOR_CHANNELS = 4;
 
+//packed wind map : red / green bytes in 8 x 8 texel blocks ( GRASS_WIND_TEXEL_OFFSET in GrassTypes.h)
+#define GRASS_WIND_BLOCK_SHIFT      3
+
+//grass_segment_kernel work group, consecutive ( blade, segment) items of one tile ( same value in GrassWorkGroupTuner.h)
+#define GRASS_SEGMENT_GROUP         128
+
+#ifdef GRASS_WIND_IMAGE
+//build option -D GRASS_WIND_IMAGE : same red / green bytes as a CL_RG unorm8 image, texel centers
+//at ( x + 0.5) / width and wrap around like getTexel(), filtered by the sampler
+__constant sampler_t windSampler = CLK_NORMALIZED_COORDS_TRUE | CLK_ADDRESS_REPEAT | CLK_FILTER_LINEAR;
+#endif
+
+//blade root source, kernel argument 'rootSource'
+#define GRASS_ROOTS_MESH            0   //VERTEX array 'vertices'
+#define GRASS_ROOTS_GRID            1   //flat procedural grid 'gridParams', 'vertices' unused
+#define GRASS_ROOTS_GRID_HEIGHTS    2   //procedural grid, root height from 'gridHeights'
+
+//wind source, kernel argument 'windSource'
+#define GRASS_WIND_TEXTURE          0   //packed 'distortionMapData'
+#define GRASS_WIND_PROCEDURAL       1   //'windModel', no texture reads
+
+//per blade random draws, grassRandom() stream ( same values in GrassTypes.h)
+#define GRASS_RANDOM_FACING         0
+#define GRASS_RANDOM_BEND           1
+#define GRASS_RANDOM_WIDTH          2
+#define GRASS_RANDOM_HEIGHT         3
+#define GRASS_RANDOM_FORWARD        4
+#define GRASS_RANDOM_STREAMS        5
+
 
 /* _______________________ function definition _________________________ */
 
+//rotation of 'angle' around ( x, y, z), column major like RotationMatrix() in GrassField.cpp
 Matrix4x4 RotationMatrix( float angle, float x, float y, float z)
 {
     //code
@@ -56,23 +128,64 @@ Matrix4x4 RotationMatrix( float angle, float x, float y, float z)
     
     Matrix4x4 rotMat;
     
-    rotMat.m[0][0] = x*x*t +   c;   rotMat.m[1][0] =  y*x*t + z*s;    rotMat.m[2][0] =   x*z*t - y*s;   rotMat.m[3][0] =  0.0f;
-    rotMat.m[0][1] = x*y*t - z*s;   rotMat.m[1][1] =  y*y*t +   c;    rotMat.m[2][1] =   y*z*t + x*s;   rotMat.m[3][1] =  0.0f;
-    rotMat.m[0][2] = x*z*t + y*s;   rotMat.m[1][2] =  y*z*t - x*s;    rotMat.m[2][2] =   z*z*t +   c;   rotMat.m[3][2] =  0.0f;
+    rotMat.m[0][0] = x*x*t +   c;   rotMat.m[1][0] =  x*y*t - z*s;    rotMat.m[2][0] =   x*z*t + y*s;   rotMat.m[3][0] =  0.0f;
+    rotMat.m[0][1] = y*x*t + z*s;   rotMat.m[1][1] =  y*y*t +   c;    rotMat.m[2][1] =   y*z*t - x*s;   rotMat.m[3][1] =  0.0f;
+    rotMat.m[0][2] = x*z*t - y*s;   rotMat.m[1][2] =  y*z*t + x*s;    rotMat.m[2][2] =   z*z*t +   c;   rotMat.m[3][2] =  0.0f;
     rotMat.m[0][3] =        0.0f;   rotMat.m[1][3] =         0.0f;    rotMat.m[2][3] =          0.0f;   rotMat.m[3][3] =  1.0f;
     
     return( rotMat);
 }
 
+//RotationMatrix() as three float3 columns, the w row / column of a rotation is always 0 0 0 1
+void rotationColumns( float angle, float3 axis, float3 column[3])
+{
+    //code
+    float s = sin( angle);
+    float c = cos( angle);
+    float t = 1.0f - c;
+
+    float x = axis.x;
+    float y = axis.y;
+    float z = axis.z;
+
+    column[0] = (float3)( x*x*t +   c,  y*x*t + z*s,  x*z*t - y*s);
+    column[1] = (float3)( x*y*t - z*s,  y*y*t +   c,  y*z*t + x*s);
+    column[2] = (float3)( x*z*t + y*s,  y*z*t - x*s,  z*z*t +   c);
+}
+
+//a * b of column matrices, column k of the result is a applied to column k of b
+void columnsMul( const float3 a[3], const float3 b[3], float3 result[3])
+{
+    //code
+    for( int k = 0; k < 3; k++)
+    {
+        result[k] = a[0] * b[k].x + a[1] * b[k].y + a[2] * b[k].z;
+    }
+}
+
 float vjd_fract( float x)
 {
     return( x - floor(x));
 }
 
-float vjd_random( float3 coord)
+//integer hash ( same as GrassHash() in GrassTypes.h)
+uint grassHash( uint x)
 {
-    float3 v = (float3)(12.9898f, 78.233f, 53.539f);
-    return( vjd_fract( (float)sin( dot( coord, v) ) * 43758.5453f));
+    //code
+    x = x ^ ( x >> 16);
+    x = x * 0x7feb352dU;
+    x = x ^ ( x >> 15);
+    x = x * 0x846ca68bU;
+    x = x ^ ( x >> 16);
+
+    return( x);
+}
+
+//random number in [0, 1) of draw 'stream' of blade 'blade' ( same as GrassRandom() in GrassTypes.h)
+float grassRandom( uint blade, uint stream)
+{
+    //code
+    return( (float)( grassHash( blade * GRASS_RANDOM_STREAMS + stream) >> 8) * ( 1.0f / 16777216.0f));
 }
 
 Matrix4x4 matMul( Matrix4x4 m1, Matrix4x4 m2)
@@ -158,20 +271,253 @@ float4 matVecMul( Matrix4x4 mat, float4 v)
 
 
 
-float4 getTexel( float2 uv, __global float *imageData, int width, int height)
+//red / green of packed wind texel ( x, y), 0 - 255
+float2 getPackedTexel( __global const uchar *packed, int x, int y, int blockColumns)
+{
+    //code
+    const int blockMask = (1 << GRASS_WIND_BLOCK_SHIFT) - 1;
+    int offset = ( ( ( y >> GRASS_WIND_BLOCK_SHIFT) * blockColumns + ( x >> GRASS_WIND_BLOCK_SHIFT)) << ( 2 * GRASS_WIND_BLOCK_SHIFT))
+                 + ( (y & blockMask) << GRASS_WIND_BLOCK_SHIFT) + ( x & blockMask);
+
+    return( convert_float2( vload2( offset, packed)));
+}
+
+
+//bilinear sample of the packed wind map, texel centers at ( x + 0.5) / width, wraps around
+//( same operation order as getTexel() in GrassField.cpp)
+float4 getTexel( float2 uv, __global const uchar *packed, int width, int height)
+{
+    //code
+    int blockColumns = ( width + (1 << GRASS_WIND_BLOCK_SHIFT) - 1) >> GRASS_WIND_BLOCK_SHIFT;
+
+    float fx = vjd_fract(uv.x) * width - 0.5f;
+    float fy = vjd_fract(uv.y) * height - 0.5f;
+    float x0f = floor( fx);
+    float y0f = floor( fy);
+    float wx = fx - x0f;
+    float wy = fy - y0f;
+
+    int x0 = (int)x0f;
+    int y0 = (int)y0f;
+    x0 += ( x0 < 0) ? width : 0;
+    y0 += ( y0 < 0) ? height : 0;
+
+    int x1 = ( x0 + 1 < width) ? x0 + 1 : 0;
+    int y1 = ( y0 + 1 < height) ? y0 + 1 : 0;
+
+    float2 c00 = getPackedTexel( packed, x0, y0, blockColumns);
+    float2 c10 = getPackedTexel( packed, x1, y0, blockColumns);
+    float2 c01 = getPackedTexel( packed, x0, y1, blockColumns);
+    float2 c11 = getPackedTexel( packed, x1, y1, blockColumns);
+
+    float2 c0 = c00 + ( c10 - c00) * wx;
+    float2 c1 = c01 + ( c11 - c01) * wx;
+
+    return( (float4)( ( c0 + ( c1 - c0) * wy) / 255.0f, 0.0f, 1.0f));
+}
+
+
+//dot of the hashed gradient of lattice point ( x, y) and the offset d from it ( same as GrassField.cpp)
+float windGradient( int x, int y, float2 d)
+{
+    //code
+    uint h = ( (uint)x * 0x27d4eb2dU) ^ ( (uint)y * 0x165667b1U);
+    h = h ^ ( h >> 15);
+    h = h * 0x2c1b3c6dU;
+    h = h ^ ( h >> 12);
+
+    float2 g = (float2)( (float)( h & 0xFF), (float)( ( h >> 8) & 0xFF)) * ( 1.0f / 127.5f) - 1.0f;
+
+    return( g.x * d.x + g.y * d.y);
+}
+
+
+//2D gradient noise in about [-1, 1]
+float gradientNoise( float2 p)
+{
+    //code
+    float2 p0 = floor( p);
+    float2 f = p - p0;
+    int ix = (int)p0.x;
+    int iy = (int)p0.y;
+
+    float n00 = windGradient( ix, iy, f);
+    float n10 = windGradient( ix + 1, iy, f - (float2)( 1.0f, 0.0f));
+    float n01 = windGradient( ix, iy + 1, f - (float2)( 0.0f, 1.0f));
+    float n11 = windGradient( ix + 1, iy + 1, f - (float2)( 1.0f, 1.0f));
+
+    float2 u = f * f * f * ( f * ( f * 6.0f - 15.0f) + 10.0f);
+
+    return( mix( mix( n00, n10, u.x), mix( n01, n11, u.x), u.y));
+}
+
+
+//wind at world ( x, z) as the red / green a texel would hold, GrassSampleProceduralWind() in GrassField.cpp
+float4 proceduralWind( GRASS_PROCEDURAL_WIND wind, float2 xz, float time)
+{
+    //code
+    float2 dir = (float2)( wind.direction[0], wind.direction[1]);
+    float drift = wind.speed * time;
+
+    float2 q = ( xz - dir * drift) * wind.frequency;
+
+    float base = gradientNoise( q) + 0.5f * gradientNoise( q * 2.0f + (float2)( 19.1f, 7.3f));
+    float sway = gradientNoise( q + (float2)( 41.7f, 13.9f));
+
+    float phase = ( dot( xz, dir) - drift) * wind.gustFrequency;
+    float front = max( sin( TWO_PI * ( phase - floor( phase))), 0.0f);
+    float gust = front * front;
+
+    float along = wind.strength * ( 0.4f + 0.3f * base + 0.6f * gust);
+    float across = wind.strength * 0.3f * sway;
+
+    float2 windXZ = dir * along + (float2)( -dir.y, dir.x) * across;
+
+    return( (float4)( clamp( 0.5f + 0.5f * windXZ, 0.0f, 1.0f), 0.0f, 1.0f));
+}
+
+
+//forward curve at t, moved towards the piecewise linear curve of the coarser level by tile.morph
+float curveForward( float t, GRASS_LOD_TILE tile)
+{
+    //code
+    float curve = pow( t, 2.0f * grassBladeCurvatureAmount);
+
+    if( tile.morph > 0.0f)
+    {
+        int coarseSpans = tile.coarseSegments - 1;
+        float u = t * coarseSpans;
+        int k = min( (int)u, coarseSpans - 1);
+
+        float c0 = pow( (float)k / coarseSpans, 2.0f * grassBladeCurvatureAmount);
+        float c1 = pow( (float)(k + 1) / coarseSpans, 2.0f * grassBladeCurvatureAmount);
+
+        curve = mix( curve, mix( c0, c1, u - k), tile.morph);
+    }
+
+    return( curve);
+}
+
+
+//root of blade ( x, y), grid index 'index', with its normal and tangent
+float3 bladeRoot( __global VERTEX *vertices, unsigned int rootSource, float4 gridParams, __global float *gridHeights,
+    unsigned int x, unsigned int y, int index, float3 *normal, float3 *tangent)
+{
+    //variable declarations
+    float3 position;
+
+    //code
+    if( rootSource == GRASS_ROOTS_MESH)
+    {
+        position = (float3) (vertices[index].position[0], vertices[index].position[1], vertices[index].position[2]);
+        *normal = (float3) (vertices[index].normal[0], vertices[index].normal[1], vertices[index].normal[2]);
+        *tangent = (float3) (vertices[index].tangent[0], vertices[index].tangent[1], vertices[index].tangent[2]);
+    }
+    else
+    {
+            //same layout as CreateMesh() / CreateGrid(), no per vertex input
+        position.x = (gridParams.x + x) * gridParams.z;
+        position.y = ( rootSource == GRASS_ROOTS_GRID_HEIGHTS) ? gridHeights[index] : 0.0f;
+        position.z = (gridParams.y - y) * gridParams.z;
+
+        *normal = (float3) ( 0.0f, 1.0f, 0.0f);
+        *tangent = (float3) ( 1.0f, 0.0f, 0.0f);
+    }
+
+    return( position);
+}
+
+//wind at the root, -windStrength .. windStrength
+float2 bladeWind( float3 position, float time, unsigned int windSource, GRASS_PROCEDURAL_WIND windModel,
+    __global const uchar *distortionMapData, int map_width, int map_height
+#ifdef GRASS_WIND_IMAGE
+    , read_only image2d_t windImage
+#endif
+)
+{
+    //variable declarations
+    float4 color;
+
+    //code
+    if( windSource == GRASS_WIND_PROCEDURAL)
+    {
+        color = proceduralWind( windModel, position.xz, time);
+    }
+    else
+    {
+        float2 uv = position.xz * windScale + windOffset + windFrequency * time;
+#ifdef GRASS_WIND_IMAGE
+        color = read_imagef( windImage, windSampler, uv);
+#else
+        color = getTexel( uv, distortionMapData, map_width, map_height);
+#endif
+    }
+
+    return( (color.xy * (float2)(2.0, 2.0) - (float2)(1.0, 1.0)) * windStrength);
+}
+
+//random shape and rotations of blade 'index' as float3 columns, same products as the mat4 path
+GRASS_BLADE_FRAME bladeFrame( int index, float3 position, float3 normal, float3 tangent, float2 windSample)
 {
+    //variable declarations
+    GRASS_BLADE_FRAME blade;
+    float3 tangentToLocal[3], facing[3], bend[3], wind[3];
+    float3 bent[3], windBent[3];
+
     //code
-    int x = floor( vjd_fract(uv.x) * ( width - 1));
-    int y = floor( vjd_fract(uv.y) * ( height - 1));
+        //drawn from the blade grid index, same values as GrassField::rebuild()
+    float facingAngle = grassRandom( index, GRASS_RANDOM_FACING) * TWO_PI;
+    float bendAngle = grassRandom( index, GRASS_RANDOM_BEND) * grassBendRotationRandom * PI * 0.5;
+    float3 windDirection = normalize( (float3)(windSample.x, windSample.y, 0.0) );
+
+    tangentToLocal[0] = tangent;
+    tangentToLocal[1] = cross( normal, tangent);
+    tangentToLocal[2] = normal;
+
+    rotationColumns( facingAngle, (float3)( 0.0f, 0.0f, 1.0f), facing);
+    rotationColumns( bendAngle, (float3)( -1.0f, 0.0f, 0.0f), bend);
+    rotationColumns( PI * windSample.x, windDirection, wind);
 
-    float4 sample = (float4)( 0.0, 0.0, 0.0, 0.0);
+        //matMul( a, b) is b * a
+    columnsMul( tangentToLocal, facing, blade.base);
+    columnsMul( facing, bend, bent);
+    columnsMul( wind, bent, windBent);
+    columnsMul( tangentToLocal, windBent, blade.transformation);
 
-    sample.x = *(imageData + (COLOR_CHANNELS * ( y * width + x) + 0));
-    sample.y = *(imageData + (COLOR_CHANNELS * ( y * width + x) + 1));
-    sample.z = *(imageData + (COLOR_CHANNELS * ( y * width + x) + 2));
-    sample.w = *(imageData + (COLOR_CHANNELS * ( y * width + x) + 3));
+    blade.position = position;
+    blade.width  = ( grassRandom( index, GRASS_RANDOM_WIDTH) * 2.0 - 1.0) * grassBladeWidthRandom + grassBladeWidth;
+    blade.height = ( grassRandom( index, GRASS_RANDOM_HEIGHT) * 2.0 - 1.0) * grassBladeHeightRandom + grassBladeHeight;
+    blade.forward = grassRandom( index, GRASS_RANDOM_FORWARD) * grassBladeForwardAmount;
+    blade.unused = 0.0f;
 
-    return( sample);
+    return( blade);
+}
+
+//the two vertices of segment 'i', adjacent GRASS_VERTEX for one 64 byte store
+float16 segmentVertices( const GRASS_BLADE_FRAME *blade, int i, GRASS_LOD_TILE tile)
+{
+    //variable declarations
+    float16 vertices;
+
+    //code
+    float3 column0 = ( i == 0) ? blade->base[0] : blade->transformation[0];
+    float3 column1 = ( i == 0) ? blade->base[1] : blade->transformation[1];
+    float3 column2 = ( i == 0) ? blade->base[2] : blade->transformation[2];
+    float t = (float)i / (float)(tile.segments - 1);     //tip at t = 1 whatever the level
+
+    float segmentWidth = blade->width * ( 1 - t);
+    float segmentHeight = blade->height * t;
+    float segmentForward = curveForward( t, tile) * blade->forward;
+
+        //both edges share the forward / height part, the width goes left and right
+    float3 center = blade->position + column1 * segmentForward + column2 * segmentHeight;
+    float3 across = column0 * segmentWidth;
+    float3 localNormal = column2 * segmentForward - column1;
+
+    vertices.s01234567 = (float8)( center + across, localNormal, 0.0f, t);
+    vertices.s89abcdef = (float8)( center - across, localNormal, 1.0f, t);
+
+    return( vertices);
 }
 
 
@@ -186,34 +532,88 @@ __kernel void grass_kernel(
     __global VERTEX       *vertices,           //vertices information                           [ __IN__ ]
     unsigned int           mesh_width,         //mesh width                                     [ __IN__ ]
     unsigned int           mesh_height,        //mesh height                                    [ __IN__ ]
-    unsigned int           grassBladeSegment,  //segment per grass blade                        [ __IN__ ]
-    __global float        *distortionMapData,  //distortion map normalized data [0.0 - 1.0]     [ __IN__ ]
+    __global GRASS_LOD_TILE *tiles,            //visible tiles, one per global id (1)           [ __IN__ ]
+    __global const uchar  *distortionMapData,  //packed distortion map, red / green bytes       [ __IN__ ]
              int           map_width,          //distortion map width                           [ __IN__ ]
              int           map_height,         //distortion map height                          [ __IN__ ]
-             float         time                //animation time                                 [ __IN__ ]
+             float         time,               //animation time                                 [ __IN__ ]
+    unsigned int           rootSource,         //GRASS_ROOTS_*                                  [ __IN__ ]
+             float4        gridParams,         //procedural grid left, top, spacing (grid units) [ __IN__ ]
+    __global float        *gridHeights,        //root height per blade (GRASS_ROOTS_GRID_HEIGHTS) [ __IN__ ]
+    unsigned int           windSource,         //GRASS_WIND_*                                   [ __IN__ ]
+    GRASS_PROCEDURAL_WIND  windModel,          //analytic wind (GRASS_WIND_PROCEDURAL)          [ __IN__ ]
+    unsigned int           tile_count          //tiles in 'tiles', global id (1) is padded to the work group [ __IN__ ]
+#ifdef GRASS_WIND_IMAGE
+    , read_only image2d_t  windImage           //wind map image, 'distortionMapData' unused    [ __IN__ ]
+#endif
 )
 {
     //variable declarations
+    if( get_global_id(1) >= tile_count)
+        return;
+
+    GRASS_LOD_TILE tile = tiles[ get_global_id(1)];
+
+    const int grassBladeSegment = tile.segments;
     const int verticesPerBlade = 2 * grassBladeSegment;
 
-    unsigned int x = get_global_id(0);
-    unsigned int y = get_global_id(1);
+        //blade of the tile, row by row
+    unsigned int bladeInTile = get_global_id(0);
+    unsigned int x = tile.x + bladeInTile % tile.width;
+    unsigned int y = tile.z + bladeInTile / tile.width;
 
-    if( x >= mesh_width || y >= mesh_height)
+    if( bladeInTile >= tile.width * tile.height)
         return;
 
     int index = y * mesh_width + x;
-    float angle;
-    float3 position, normal, tangent;
+    float3 normal, tangent;
     //Matrix4x4 tangentToLocalMatrix, facingRotationMatrix, bendRotationMatrix;
 
     //code
-    position = (float3) (vertices[index].position[0], vertices[index].position[1], vertices[index].position[2]);
-    normal = (float3) (vertices[index].normal[0], vertices[index].normal[1], vertices[index].normal[2]);
-    tangent = (float3) (vertices[index].tangent[0], vertices[index].tangent[1], vertices[index].tangent[2]);
+    float3 position = bladeRoot( vertices, rootSource, gridParams, gridHeights, x, y, index, &normal, &tangent);
+
+    //Wind Effect
+    float2 windSample = bladeWind( position, time, windSource, windModel, distortionMapData, map_width, map_height
+#ifdef GRASS_WIND_IMAGE
+        , windImage
+#endif
+    );
+
+#ifdef GRASS_KERNEL_FLOAT4
+    //blade constant rotations as float3 columns, kept in registers
+    GRASS_BLADE_FRAME blade = bladeFrame( index, position, normal, tangent, windSample);
 
+    __global float *outBlade = (__global float *)( outGrassData + tile.firstVertex + ( verticesPerBlade * bladeInTile));
+
+    for( int i = 0; i < grassBladeSegment; i++)
+    {
+        vstore16( segmentVertices( &blade, i, tile), i, outBlade);
+    }
+#else
     float3 biNormal = cross( normal, tangent);
 
+    //random rotation of vertex but constistent between frame
+        //drawn from the blade grid index, same values as GrassField::rebuild()
+    float facingAngle = grassRandom( index, GRASS_RANDOM_FACING) * TWO_PI;
+
+    //rotate along X-axis
+    float bendAngle = grassRandom( index, GRASS_RANDOM_BEND) * grassBendRotationRandom * PI * 0.5;
+
+    // float remap_value = remap( sin( 3.0*time*windFrequency.x), -1, 1, -87, 2);
+
+    // float3 windNormal = ((color.xyz) * (float3)(2.0) - (float3)(1.0)) - (float3)( remap_value, remap_value, remap_value);
+    // float3 windDirection = normalize( (float3)(windSample.x, windSample.y, 0.0) + windNormal );    
+
+    float3 windDirection = normalize( (float3)(windSample.x, windSample.y, 0.0) );
+
+
+    float width  = ( grassRandom( index, GRASS_RANDOM_WIDTH) * 2.0 - 1.0) * grassBladeWidthRandom + grassBladeWidth;
+    float height = ( grassRandom( index, GRASS_RANDOM_HEIGHT) * 2.0 - 1.0) * grassBladeHeightRandom + grassBladeHeight;
+    float forward =  grassRandom( index, GRASS_RANDOM_FORWARD) * grassBladeForwardAmount;
+
+    float t;
+    float segmentWidth, segmentHeight, segmentForward;
+
     Matrix4x4 tangentToLocalMatrix;
     
     tangentToLocalMatrix.m[0][0] = tangent.x;      tangentToLocalMatrix.m[1][0] = biNormal.x;      tangentToLocalMatrix.m[2][0] = normal.x;      tangentToLocalMatrix.m[3][0] = 0.0;
@@ -229,55 +629,27 @@ __kernel void grass_kernel(
     //     0.0, 0.0, 0.0, 1.0
     // };
 
-    //random rotation of vertex but constistent between frame
-    // angle = vjd_random( vertices[index].position.xyz) * TWO_PI;
-
-    angle = vjd_random( position.xyz) * PI;
-    Matrix4x4 facingRotationMatrix = RotationMatrix( angle, 0.0, 0.0, 1.0);
-
-    //rotate along X-axis
-    angle = vjd_random( position.zzx) * grassBendRotationRandom * PI * 0.5;
-    Matrix4x4 bendRotationMatrix = RotationMatrix( angle, -1.0, 0.0, 0.0);
-
-
-    //Wind Effect
-    float2 uv = position.xz * windScale + windOffset + windFrequency * time;
-    float4 color = getTexel( uv, distortionMapData, map_width, map_height);
-    float2 windSample = (color.xy * (float2)(2.0, 2.0) - (float2)(1.0, 1.0));// * windStrength;
-
-    // float remap_value = remap( sin( 3.0*time*windFrequency.x), -1, 1, -87, 2);
-
-    // float3 windNormal = ((color.xyz) * (float3)(2.0) - (float3)(1.0)) - (float3)( remap_value, remap_value, remap_value);
-    // float3 windDirection = normalize( (float3)(windSample.x, windSample.y, 0.0) + windNormal );    
-
-    float3 windDirection = normalize( (float3)(windSample.x, windSample.y, 0.0) );
+    Matrix4x4 facingRotationMatrix = RotationMatrix( facingAngle, 0.0, 0.0, 1.0);
+    Matrix4x4 bendRotationMatrix = RotationMatrix( bendAngle, -1.0, 0.0, 0.0);
     Matrix4x4 windTransformMatrix = RotationMatrix( PI * windSample.x, windDirection.x, windDirection.y, windDirection.z);
 
-
-    float width  = ( vjd_random( position.xzy) * 2.0 - 1.0) * grassBladeWidthRandom + grassBladeWidth;
-    float height = ( vjd_random( position.zyx) * 2.0 - 1.0) * grassBladeHeightRandom + grassBladeHeight;
-    float forward =  vjd_random( position.yyz) * grassBladeForwardAmount;
-
-    float t;
-    float segmentWidth, segmentHeight, segmentForward;
     float4 tangentPoint, localPosition;
     float4 tangentNormal, localNormal;
+    int vertexIndex;
 
     Matrix4x4 baseTransformationMatrix = matMul( facingRotationMatrix, tangentToLocalMatrix);
     Matrix4x4 transformationMatrix = matMul( matMul( matMul( bendRotationMatrix, facingRotationMatrix), windTransformMatrix), tangentToLocalMatrix);
 
-    int vertexIndex;
-
     for( int i = 0; i < grassBladeSegment; i++)
     {
 
         Matrix4x4 M = ( i == 0) ? baseTransformationMatrix : transformationMatrix;
-        t = (float)i / (float)(grassBladeSegment);
+        t = (float)i / (float)(grassBladeSegment - 1);     //tip at t = 1 whatever the level
 
         segmentWidth = width * ( 1 - t);
         segmentHeight = height * t;
         //segmentForward = forward * t;
-        segmentForward = pow( t, 4.0f * grassBladeCurvatureAmount) * forward;
+        segmentForward = curveForward( t, tile) * forward;
 
         //////////////////////////////////////
         tangentPoint = (float4)( segmentWidth, segmentForward, segmentHeight, 0.0);
@@ -288,7 +660,7 @@ __kernel void grass_kernel(
         // localNormal = matVecMul( M, (float4)(tangentNormal.xyz + windNormal, 0.0));
         localNormal = matVecMul( M, (float4)(tangentNormal.xyz, 0.0));
 
-        vertexIndex = (verticesPerBlade * index) + (2 * i);
+        vertexIndex = tile.firstVertex + (verticesPerBlade * bladeInTile) + (2 * i);
 
         outGrassData[ vertexIndex + 0].position[0] = localPosition.x;
         outGrassData[ vertexIndex + 0].position[1] = localPosition.y;
@@ -319,5 +691,84 @@ __kernel void grass_kernel(
         outGrassData[ vertexIndex + 1].texcoord[1] = t;
 
     }
+#endif
 }
 
+
+//one work item per ( blade, segment) of a tile, items of a blade are consecutive so item 'item' writes
+//vertices 2 * item and 2 * item + 1 of the tile. Work groups of GRASS_SEGMENT_GROUP x 1, the items
+//of a group set up their few blades once in local memory
+__kernel __attribute__(( reqd_work_group_size( GRASS_SEGMENT_GROUP, 1, 1)))
+void grass_segment_kernel( 
+    __global GRASS_VERTEX *outGrassData,       //out buffer                                     [ __OUT__ ]
+    __global VERTEX       *vertices,           //vertices information                           [ __IN__ ]
+    unsigned int           mesh_width,         //mesh width                                     [ __IN__ ]
+    unsigned int           mesh_height,        //mesh height                                    [ __IN__ ]
+    __global GRASS_LOD_TILE *tiles,            //visible tiles, one per global id (1)           [ __IN__ ]
+    __global const uchar  *distortionMapData,  //packed distortion map, red / green bytes       [ __IN__ ]
+             int           map_width,          //distortion map width                           [ __IN__ ]
+             int           map_height,         //distortion map height                          [ __IN__ ]
+             float         time,               //animation time                                 [ __IN__ ]
+    unsigned int           rootSource,         //GRASS_ROOTS_*                                  [ __IN__ ]
+             float4        gridParams,         //procedural grid left, top, spacing (grid units) [ __IN__ ]
+    __global float        *gridHeights,        //root height per blade (GRASS_ROOTS_GRID_HEIGHTS) [ __IN__ ]
+    unsigned int           windSource,         //GRASS_WIND_*                                   [ __IN__ ]
+    GRASS_PROCEDURAL_WIND  windModel,          //analytic wind (GRASS_WIND_PROCEDURAL)          [ __IN__ ]
+    unsigned int           tile_count          //tiles in 'tiles'                               [ __IN__ ]
+#ifdef GRASS_WIND_IMAGE
+    , read_only image2d_t  windImage           //wind map image, 'distortionMapData' unused    [ __IN__ ]
+#endif
+)
+{
+    //variable declarations
+        //levels have at least 2 segments, so a group touches at most GRASS_SEGMENT_GROUP / 2 + 1 blades
+    __local GRASS_BLADE_FRAME frames[ GRASS_SEGMENT_GROUP / 2 + 1];
+
+    //code
+        //whole groups return before the barrier, dimension 1 has a local size of 1
+    if( get_global_id(1) >= tile_count)
+        return;
+
+    GRASS_LOD_TILE tile = tiles[ get_global_id(1)];
+
+    unsigned int segments = tile.segments;
+    unsigned int items = tile.width * tile.height * segments;
+    unsigned int groupStart = get_group_id(0) * GRASS_SEGMENT_GROUP;
+
+        //the range is sized for the finest level, coarser tiles leave their last groups empty
+    if( groupStart >= items)
+        return;
+
+    unsigned int firstBlade = groupStart / segments;
+    unsigned int lastBlade = ( min( groupStart + GRASS_SEGMENT_GROUP, items) - 1) / segments;
+
+        //one item per blade of the group sets it up, the others read it after the barrier
+    unsigned int frame = get_local_id(0);
+    if( frame <= lastBlade - firstBlade)
+    {
+        unsigned int bladeInTile = firstBlade + frame;
+        unsigned int x = tile.x + bladeInTile % tile.width;
+        unsigned int y = tile.z + bladeInTile / tile.width;
+        int index = y * mesh_width + x;
+        float3 normal, tangent;
+
+        float3 position = bladeRoot( vertices, rootSource, gridParams, gridHeights, x, y, index, &normal, &tangent);
+        float2 windSample = bladeWind( position, time, windSource, windModel, distortionMapData, map_width, map_height
+#ifdef GRASS_WIND_IMAGE
+            , windImage
+#endif
+        );
+
+        frames[ frame] = bladeFrame( index, position, normal, tangent, windSample);
+    }
+
+    barrier( CLK_LOCAL_MEM_FENCE);
+
+    unsigned int item = get_global_id(0);
+    if( item >= items)
+        return;
+
+    GRASS_BLADE_FRAME blade = frames[ item / segments - firstBlade];
+
+    vstore16( segmentVertices( &blade, item % segments, tile), item, (__global float *)( outGrassData + tile.firstVertex));
+}
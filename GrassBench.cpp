@@ -0,0 +1,1685 @@
+/*
+ * Waving Grass Rendering : Headless CPU Bench
+ *
+ * Runs the CPU grass generator (GrassField) for N frames without any window
+ * or GPU and reports blades/sec, so the hot loop can be profiled on Linux.
+ *
+ *  usage: GrassBench [-grid N] [-frames N] [-wind file.bmp] [-layout mat4|compact|both]
+ *                    [-simd auto|scalar|avx2|avx512|all] [-threads N|all|scale] [-indices]
+ *                    [-roots mesh|grid|both] [-cull] [-lod] [-schedule] [-budget N]
+ *                    [-windmap float|rg8|bilinear|procedural|compare]
+ *                    [-backend cpu|compare] [-kernel file.cl] [-clvariant mat4|float4|both]
+ *                    [-clwind auto|buffer|image] [-clrange auto|blade|segment]
+ *                    [-cldevice index|name|list] [-clcache prefix] [-wgprofile file]
+ *                    [-tolerance X]
+ *                    [-trace file.json]
+ *
+ *  -layout both : run the mat4 (reference) and compact static layouts on the
+ *                 same grid, report both frame times and the max difference
+ *  -simd        : vector kernel of the compact layout (default auto = GrassSimdDefault(),
+ *                 AVX2 when supported, avx512 has to be asked for),
+ *                 'all' runs every supported kernel against the mat4 reference
+ *  -threads     : worker threads (default 1), 'all' = one per hardware thread,
+ *                 'scale' runs the compact layout at 1, 2, 4 .. hardware threads
+ *                 and prints per thread busy time and load imbalance
+ *  -indices     : also report index memory and build time of the full index
+ *                 buffer versus the shared GRASS_TEMPLATE_BLADES template
+ *  -roots       : blade roots read from CreateMesh() VERTEX data (default) or
+ *                 computed from a procedural GRASS_GRID, 'both' compares them
+ *  -cull        : simulate only the tiles in view of a fixed walk through camera,
+ *                 report visible blades and the frame time against the full field
+ *  -lod         : same camera, visible tiles also get a LOD level from their
+ *                 distance, report output vertices and frame time against -cull
+ *  -schedule    : same as -lod, then with time sliced updates of at most -budget
+ *                 blades per frame (default 0 = no limit), report the amortization
+ *  -windmap     : wind texels sampled from the RGBA float map (default), the packed
+ *                 8 x 8 block RG8 copy (nearest), the packed copy bilinearly filtered
+ *                 or the analytic GRASS_PROCEDURAL_WIND ( no texture), 'compare' runs
+ *                 all of them and reports wind bytes, frame times and differences
+ *  -backend     : 'compare' runs the mat4 reference, the compact layout at every supported
+ *                 SIMD level and grass_kernel of -kernel (default Grass.cl) on an OpenCL
+ *                 CPU device ( PoCL), on the same grid and wind ( packed bilinear map or
+ *                 -windmap procedural), prints one table of frame times and max differences
+ *                 and exits with 1 when a backend differs by more than -tolerance ( 1e-3).
+ *                 OpenCL runs once synchronously ( clFinish every frame) and once pipelined
+ *                 over BENCH_PIPELINE_DEPTH output buffers, each with its enqueue to result latency
+ *  -clvariant   : grass_kernel built as the Matrix4x4 reference, the float4 column variant
+ *                 ( -D GRASS_KERNEL_FLOAT4, what Main.cpp runs) or 'both' ( default), which
+ *                 also reports the kernel time speedup of float4 over mat4
+ *  -clwind      : grass_kernel samples the wind map from the packed buffer ( manual bilinear)
+ *                 or from a CL_RG image through the sampler ( -D GRASS_WIND_IMAGE, filtering
+ *                 hardware), 'auto' ( default) takes the image when the device supports it
+ *  -clrange     : force grass_kernel ( one work item per blade, driver local size) or
+ *                 grass_segment_kernel ( one per blade and segment), 'auto' ( default) runs
+ *                 the kernel of the -wgprofile entry, else grass_kernel
+ *  -cldevice    : OpenCL device by index or part of its name ( any platform and type),
+ *                 default the first CPU device, 'list' prints the devices and exits
+ *  -clcache     : OpenCL program binaries cached as <prefix>_<key>.bin, run twice to compare
+ *                 the cold ( source build) and warm ( cached binary) program time
+ *  -wgprofile   : kernel and local size from this work group profile, tuned over the
+ *                 GrassWorkGroupTuner.h candidates ( both kernels) and stored when the device
+ *                 and grid class have no entry yet ( default: driver choice, NULL local size)
+ *                 OpenCL needs GRASS_BENCH_OPENCL, build.sh sets it when CL/opencl.h is found,
+ *                 without it the OpenCL options other than -cldevice are usage errors
+ *  -trace       : write the timing zones of the run ( GrassProfiler.h) as a Chrome trace,
+ *                 plus a .csv next to it
+ *
+ * Created By Vijaykumar Dangi
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+#include "GrassField.h"
+#include "GrassProfiler.h"
+
+#ifdef GRASS_BENCH_OPENCL
+#include <CL/opencl.h>
+#include "GrassProgramCache.h"
+#include "GrassWorkGroupTuner.h"
+#include "GrassOpenCL.h"
+#endif
+
+#define STB_IMAGE_IMPLEMENTATION
+#define STB_IMAGE_STATIC
+#include "stb_image/stb_image.h"
+
+//macro
+#define  GRASS_BLADE_SEGMENTS   12
+#define  BENCH_PIXEL_SCALE      1303.7f     //1080 pixel high viewport, 45 degree vertical field of view : 540 / tan( 22.5)
+#define  BENCH_TOLERANCE        1.0e-3f     //-backend compare : max vertex difference a backend may have against mat4
+#define  BENCH_PIPELINE_DEPTH   2           //-backend compare : output buffers of the pipelined OpenCL run
+#define  BENCH_CL_VARIANTS      2           //-clvariant : grass_kernel Matrix4x4 reference and float4 columns
+
+    //grass_kernel arguments, same as Main.cpp
+#define  GRASS_ROOTS_MESH           0
+#define  GRASS_ROOTS_GRID           1
+#define  GRASS_WIND_TEXTURE         0
+#define  GRASS_WIND_PROCEDURAL      1
+
+//global variable declaration
+FILE *gpLogFile = NULL;
+const char *gpClWindName = "auto";      //-clwind of every RunBenchCL()
+const char *gpClRangeName = "auto";     //-clrange of every RunBenchCL()
+const char *gpClDeviceName = NULL;      //-cldevice of every RunBenchCL(), NULL : first CPU device
+
+//grass_kernel variants and their program build options, the last one is what Main.cpp builds
+const char *benchVariantNames[ BENCH_CL_VARIANTS] = { "mat4", "float4"};
+const char *benchVariantOptions[ BENCH_CL_VARIANTS] = { "-cl-fast-relaxed-math", "-cl-fast-relaxed-math -D GRASS_KERNEL_FLOAT4"};
+
+//
+//LoadWindMap() :- load wind distortion map as normalized RGBA float texels
+//
+float *LoadWindMap( const char *fileName, int *width, int *height)
+{
+    //variable declarations
+    int channels;
+
+    //code
+        //Win32 LoadImage() returns BMP rows bottom-up, keep the same row order
+    stbi_set_flip_vertically_on_load( 1);
+
+    unsigned char *imageData = stbi_load( fileName, width, height, &channels, 0);
+    if( imageData == NULL)
+    {
+        return( NULL);
+    }
+
+    float *texels = (float *) malloc( (size_t)(*width) * (*height) * GRASS_COLOR_CHANNELS * sizeof(float));
+    if( texels == NULL)
+    {
+        stbi_image_free( imageData);
+        return( NULL);
+    }
+
+    for( int i = 0; i < (*width) * (*height); i++)
+    {
+        texels[ GRASS_COLOR_CHANNELS * i + 0] = (channels > 0) ? imageData[ channels * i + 0] / 255.0f : 0.0f;   //red
+        texels[ GRASS_COLOR_CHANNELS * i + 1] = (channels > 1) ? imageData[ channels * i + 1] / 255.0f : 0.0f;   //green
+        texels[ GRASS_COLOR_CHANNELS * i + 2] = (channels > 2) ? imageData[ channels * i + 2] / 255.0f : 0.0f;   //blue
+        texels[ GRASS_COLOR_CHANNELS * i + 3] = (channels > 3) ? imageData[ channels * i + 3] / 255.0f : 1.0f;   //alpha
+    }
+
+    stbi_image_free( imageData);
+
+    return( texels);
+}
+
+//bench result of one run
+typedef struct BENCH_RESULT
+{
+    double msPerFrame;
+    double bladesPerSec;
+    size_t staticBytes;
+
+        //summed over all frames
+    int threadCount;
+    GRASS_THREAD_STATS threadStats[ GRASS_MAX_THREADS];
+    double imbalance;       //mean of per frame imbalance
+
+    int visibleBlades;      //after cull()
+    int outputVertices;
+    double amortization;    //visible blades per regenerated blade
+    double latencyMs;       //OpenCL : kernel enqueue until the host sees it complete, mean
+    double programMs;       //OpenCL : create + build of the program
+    const char *programSource;      //OpenCL : GrassProgramSourceName()
+    size_t workGroup[2];    //OpenCL : local size of grass_kernel, 0 x 0 : driver choice
+    int workGroupKernel;    //OpenCL : GRASS_KERNEL_BLADE or GRASS_KERNEL_SEGMENT
+    const char *workGroupSource;    //OpenCL : "driver", "tuned" or "profile"
+    const char *windSource;         //OpenCL : "buffer", "image" or "procedural"
+} BENCH_RESULT;
+
+//
+//ResizeField() :- gridSize x gridSize blades on meshVertexData, NULL : procedural grid
+//
+int ResizeField( GrassField *grassField, int gridSize, const VERTEX *meshVertexData)
+{
+    //code
+    grassField->params.segments = GRASS_BLADE_SEGMENTS;
+
+    int status;
+    if( meshVertexData)
+    {
+        status = grassField->resize( gridSize, gridSize, meshVertexData);
+    }
+    else
+    {
+        GRASS_GRID grid;
+        CreateGrid( 0, 0, gridSize, gridSize, MESH_MULTIPLICANT, &grid);
+        status = grassField->resize( &grid);
+    }
+
+    if( status != 0)
+    {
+        fprintf( stderr, "GrassField::resize() Failed\n");
+    }
+
+    return( status);
+}
+
+//
+//RunBench() :- simulate frameCount frames, output of last frame stays in grassVertex
+//
+int RunBench( GRASS_LAYOUT layout, GRASS_SIMD_LEVEL simdLevel, int threadCount, int gridSize, int frameCount, const VERTEX *meshVertexData, const GRASS_WIND_MAP *windMap, const vmath::mat4 *viewProjection, const vmath::vec3 *eye, const GRASS_SCHEDULE_PARAMS *schedule, GRASS_VERTEX *grassVertex, size_t vertexCount, BENCH_RESULT *result)
+{
+    //code
+    GrassField grassField( layout);
+    grassField.setSimdLevel( simdLevel);
+    grassField.setThreadCount( threadCount);
+
+    if( schedule)
+    {
+        grassField.schedule = *schedule;
+    }
+
+    if( ResizeField( &grassField, gridSize, meshVertexData) != 0)
+    {
+        return(-1);
+    }
+
+    result->visibleBlades = grassField.cull( viewProjection, eye);
+    result->outputVertices = grassField.getOutputVertexCount();
+
+        //warm up (page in output buffer)
+    grassField.scheduleUpdates( BENCH_PIXEL_SCALE);
+    grassField.simulate( 0.0f, windMap, grassVertex, vertexCount);
+    grassField.resetScheduleStats();
+
+    long long bladesDone = 0;
+    double imbalanceSum = 0.0;
+
+    result->threadCount = grassField.getThreadCount();
+    memset( result->threadStats, 0, sizeof( result->threadStats));
+
+    std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+    for( int frame = 0; frame < frameCount; frame++)
+    {
+        GrassProfileBeginFrame();
+        grassField.scheduleUpdates( BENCH_PIXEL_SCALE);
+        bladesDone += grassField.simulate( frame * 0.016f, windMap, grassVertex, vertexCount);
+
+        const GRASS_THREAD_STATS *stats = grassField.getThreadStats();
+        for( int i = 0; i < result->threadCount; i++)
+        {
+            result->threadStats[i].busyMs += stats[i].busyMs;
+            result->threadStats[i].tasks += stats[i].tasks;
+            result->threadStats[i].stolen += stats[i].stolen;
+        }
+        imbalanceSum += grassField.getLoadImbalance();
+    }
+
+    double seconds = std::chrono::duration<double>( std::chrono::high_resolution_clock::now() - start).count();
+
+    result->msPerFrame = seconds * 1000.0 / frameCount;
+    result->bladesPerSec = bladesDone / seconds;
+    result->staticBytes = grassField.getStaticBytesPerBlade() * grassField.getBladeCount();
+    result->imbalance = imbalanceSum / frameCount;
+    result->amortization = grassField.getMeanAmortization();
+
+    return(0);
+}
+
+//
+//PrintResult()
+//
+void PrintResult( const char *name, const BENCH_RESULT *result)
+{
+    //code
+    printf( "%-8s: %9.3f ms/frame  %8.3f M blades/sec  static props %8.2f MB\n",
+        name, result->msPerFrame, result->bladesPerSec / 1.0e6, result->staticBytes / (1024.0 * 1024.0));
+}
+
+//
+//PrintThreadStats() :- per thread busy time per frame, tiles and stolen tiles
+//
+void PrintThreadStats( const BENCH_RESULT *result, int frameCount)
+{
+    //code
+    for( int i = 0; i < result->threadCount; i++)
+    {
+        printf( "    thread %2d : %8.3f ms/frame busy  %7.1f tiles/frame  %6.1f stolen/frame\n", i,
+            result->threadStats[i].busyMs / frameCount,
+            (double)result->threadStats[i].tasks / frameCount,
+            (double)result->threadStats[i].stolen / frameCount);
+    }
+}
+
+//
+//BenchIndices() :- what a grid resize costs for the index buffer in both modes
+//
+int BenchIndices( int gridSize, const VERTEX *meshVertexData)
+{
+    //code
+    GrassField grassField;
+    grassField.params.segments = GRASS_BLADE_SEGMENTS;
+
+    if( grassField.resize( gridSize, gridSize, meshVertexData) != 0)
+    {
+        fprintf( stderr, "GrassField::resize() Failed\n");
+        return(-1);
+    }
+
+    size_t fullCount = (size_t)grassField.getIndexCount();
+    size_t templateCount = (size_t)grassField.getIndexTemplateCount( GRASS_TEMPLATE_BLADES);
+    int maxDraws = grassField.getTileCount() * ( GRASS_TILE_SIZE * GRASS_TILE_SIZE / GRASS_TEMPLATE_BLADES + 1);
+
+    unsigned int *indices = (unsigned int *) malloc( MAX( fullCount, templateCount) * sizeof( unsigned int));
+    int *drawCounts = (int *) malloc( maxDraws * sizeof( int));
+    int *drawFirstIndex = (int *) malloc( maxDraws * sizeof( int));
+    int *drawBaseVertex = (int *) malloc( maxDraws * sizeof( int));
+    if( (indices == NULL) || (drawCounts == NULL) || (drawFirstIndex == NULL) || (drawBaseVertex == NULL))
+    {
+        fprintf( stderr, "malloc() Failed\n");
+        return(-1);
+    }
+
+        //full : every resize rewrites indices of all blades
+    std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+    grassField.fillIndices( indices, fullCount);
+    double fullMs = std::chrono::duration<double, std::milli>( std::chrono::high_resolution_clock::now() - start).count();
+
+        //template : built once, a resize only recomputes the draw list
+    start = std::chrono::high_resolution_clock::now();
+    grassField.fillIndexTemplate( indices, GRASS_TEMPLATE_BLADES);
+    double templateMs = std::chrono::duration<double, std::milli>( std::chrono::high_resolution_clock::now() - start).count();
+
+    start = std::chrono::high_resolution_clock::now();
+    int drawCount = grassField.fillTemplateDraws( GRASS_TEMPLATE_BLADES, drawCounts, drawFirstIndex, drawBaseVertex, maxDraws);
+    double drawsMs = std::chrono::duration<double, std::milli>( std::chrono::high_resolution_clock::now() - start).count();
+
+    printf( "indices full     : %9.2f MB, resize rebuild %8.3f ms, 1 draw\n",
+        fullCount * sizeof( unsigned int) / (1024.0 * 1024.0), fullMs);
+    printf( "indices template : %9.2f MB, resize rebuild %8.3f ms, %d draws ( template built once in %.3f ms)\n",
+        templateCount * sizeof( unsigned int) / (1024.0 * 1024.0), drawsMs, drawCount, templateMs);
+
+    free( drawBaseVertex);
+    free( drawFirstIndex);
+    free( drawCounts);
+    free( indices);
+
+    return(0);
+}
+
+//
+//MaxVertexDifference()
+//
+float MaxVertexDifference( const GRASS_VERTEX *a, const GRASS_VERTEX *b, size_t vertexCount)
+{
+    //code
+    float maxDiff = 0.0f;
+    for( size_t i = 0; i < vertexCount; i++)
+    {
+        const float *pa = &a[i].position[0];
+        const float *pb = &b[i].position[0];
+
+        for( int k = 0; k < 8; k++)     //position, normal, texcoord
+        {
+            maxDiff = MAX( maxDiff, fabsf( pa[k] - pb[k]));
+        }
+    }
+
+    return( maxDiff);
+}
+
+//
+//MaxVisibleDifference() :- MaxVertexDifference() over the tiles 'field' generated at full detail,
+//  'a' is the output of 'allField' ( nothing culled, level 0), 'b' the output of 'field'
+//
+float MaxVisibleDifference( const GrassField *allField, const GrassField *field, const GRASS_VERTEX *a, const GRASS_VERTEX *b)
+{
+    //code
+    const GRASS_LOD_TILE *allTiles = allField->getVisibleTiles();
+    const GRASS_LOD_TILE *tiles = field->getVisibleTiles();
+
+    int tilesX = allField->getTileColumnCount();
+
+    float maxDiff = 0.0f;
+    for( int i = 0; i < field->getVisibleTileCount(); i++)
+    {
+        const GRASS_LOD_TILE *tile = &tiles[i];
+        if( (tile->level != 0) || (tile->morph != 0.0f))
+        {
+            continue;
+        }
+
+        const GRASS_LOD_TILE *allTile = &allTiles[ ( tile->z / GRASS_TILE_SIZE) * tilesX + tile->x / GRASS_TILE_SIZE];
+        maxDiff = MAX( maxDiff, MaxVertexDifference( a + allTile->firstVertex, b + tile->firstVertex, (size_t)tile->width * tile->height * 2 * tile->segments));
+    }
+
+    return( maxDiff);
+}
+
+#ifdef GRASS_BENCH_OPENCL
+
+//OpenCL objects of one RunBenchCL()
+typedef struct BENCH_CL
+{
+    cl_context context;
+    cl_command_queue commandQueue;
+    cl_program program;
+    cl_kernel kernel;
+    cl_kernel segmentKernel;
+
+    cl_mem outputBuffer[ BENCH_PIPELINE_DEPTH];     //one per frame in flight
+    cl_mem vertexBuffer;
+    cl_mem tileBuffer;
+    cl_mem windBuffer;
+    cl_mem windImage;
+} BENCH_CL;
+
+//
+//LoadKernelSource() :- whole file as a NUL terminated string, free() it
+//
+char *LoadKernelSource( const char *fileName)
+{
+    //code
+    FILE *fp = fopen( fileName, "rb");
+    if( fp == NULL)
+    {
+        return( NULL);
+    }
+
+    fseek( fp, 0, SEEK_END);
+    long size = ftell( fp);
+    fseek( fp, 0, SEEK_SET);
+
+    char *source = (char *) malloc( size + 1);
+    if( (source == NULL) || (fread( source, 1, size, fp) != (size_t)size))
+    {
+        free( source);
+        fclose( fp);
+        return( NULL);
+    }
+
+    source[ size] = '\0';
+    fclose( fp);
+
+    return( source);
+}
+
+//
+//SelectDeviceCL() :- device of -cldevice, by default the first CPU device of any platform ( PoCL, Intel CPU runtime),
+//                    else the first device at all
+//
+cl_device_id SelectDeviceCL( void)
+{
+    //variable declarations
+    GRASS_CL_DEVICE devices[ GRASS_MAX_CL_DEVICES];
+
+    //code
+    int deviceCount = GrassEnumerateDevices( devices, GRASS_MAX_CL_DEVICES);
+    int selected = GrassSelectDevice( devices, deviceCount, gpClDeviceName, CL_DEVICE_TYPE_CPU);
+
+    return( (selected < 0) ? NULL : devices[ selected].device);
+}
+
+//
+//ReleaseBenchCL()
+//
+void ReleaseBenchCL( BENCH_CL *cl)
+{
+    //code
+    if( cl->windImage)
+        clReleaseMemObject( cl->windImage);
+    if( cl->windBuffer)
+        clReleaseMemObject( cl->windBuffer);
+    if( cl->tileBuffer)
+        clReleaseMemObject( cl->tileBuffer);
+    if( cl->vertexBuffer)
+        clReleaseMemObject( cl->vertexBuffer);
+    for( int i = 0; i < BENCH_PIPELINE_DEPTH; i++)
+    {
+        if( cl->outputBuffer[i])
+            clReleaseMemObject( cl->outputBuffer[i]);
+    }
+    if( cl->segmentKernel)
+        clReleaseKernel( cl->segmentKernel);
+    if( cl->kernel)
+        clReleaseKernel( cl->kernel);
+    if( cl->program)
+        clReleaseProgram( cl->program);
+    if( cl->commandQueue)
+        clReleaseCommandQueue( cl->commandQueue);
+    if( cl->context)
+        clReleaseContext( cl->context);
+
+    memset( cl, 0, sizeof( BENCH_CL));
+}
+
+//
+//RunBenchCL() :- grass_kernel of 'kernelFileName' on the same grid, tiles and wind as RunBench(),
+//  output of the last frame is read back into grassVertex, device time of each kernel into kernelStat
+//  pipelineDepth 1 : clFinish() after every kernel ( Main.cpp synchronous mode), 2 .. BENCH_PIPELINE_DEPTH :
+//  kernels go to rotating output buffers, the host only waits for the oldest frame in flight
+//  options : program build options, selects the kernel variant, GRASS_WIND_IMAGE_OPTION is added for the wind image
+//  cachePrefix : program binary cache ( GrassProgramCache.h), NULL builds from source
+//  workGroupProfile : local size from that profile ( GrassWorkGroupTuner.h), tuned and stored when it has
+//  no entry for the device and grid, every candidate then in *tuning. NULL : driver choice, no tuning
+//  return 0 on success, 1 when there is no OpenCL device, -1 on error
+//
+int RunBenchCL( const char *kernelFileName, const char *options, const char *cachePrefix, const char *workGroupProfile, int gridSize, int frameCount, const VERTEX *meshVertexData, const GRASS_WIND_MAP *windMap, GRASS_VERTEX *grassVertex, size_t vertexCount, int pipelineDepth, BENCH_RESULT *result, GRASS_WORK_GROUP_TUNING *tuning, GRASS_PROFILE_STAT *kernelStat, char *deviceName, size_t deviceNameSize)
+{
+    //variable declarations
+    BENCH_CL cl;
+    cl_int clResult;
+
+    //code
+    memset( &cl, 0, sizeof( BENCH_CL));
+    memset( tuning, 0, sizeof( GRASS_WORK_GROUP_TUNING));
+    deviceName[0] = '\0';
+
+        //grass_kernel reads only the packed wind map, always filtered
+    if( (windMap->procedural == false) && ( (windMap->packed == NULL) || (windMap->bilinear == false)))
+    {
+        fprintf( stderr, "RunBenchCL() : wind map has to be packed and bilinear or procedural\n");
+        return(-1);
+    }
+
+    cl_device_id device = SelectDeviceCL();
+    if( device == NULL)
+    {
+        return(1);
+    }
+
+    clGetDeviceInfo( device, CL_DEVICE_NAME, deviceNameSize, deviceName, NULL);
+
+    char buildOptions[ 256];
+    snprintf( buildOptions, sizeof( buildOptions), "%s", options);
+
+        //tiles and their output offsets, everything visible at level 0 like RunBench()
+    GrassField grassField;
+    if( ResizeField( &grassField, gridSize, meshVertexData) != 0)
+    {
+        return(-1);
+    }
+    grassField.cull( NULL);
+
+    const GRASS_LOD_TILE *tiles = grassField.getVisibleTiles();
+    int tileCount = grassField.getVisibleTileCount();
+    size_t outputBytes = (size_t)grassField.getOutputVertexCount() * sizeof( GRASS_VERTEX);
+
+    if( (size_t)grassField.getOutputVertexCount() > vertexCount)
+    {
+        fprintf( stderr, "RunBenchCL() : output buffer too small\n");
+        return(-1);
+    }
+
+    cl.context = clCreateContext( NULL, 1, &device, NULL, NULL, &clResult);
+    if( CL_SUCCESS != clResult)
+    {
+        fprintf( stderr, "OpenCL Error(%d): clCreateContext() Failed (%d)\n", __LINE__, clResult);
+        return(-1);
+    }
+
+    cl_queue_properties queueProperties[] = { CL_QUEUE_PROPERTIES, CL_QUEUE_PROFILING_ENABLE, 0};
+    cl.commandQueue = clCreateCommandQueueWithProperties( cl.context, device, queueProperties, &clResult);
+    if( CL_SUCCESS != clResult)
+    {
+        fprintf( stderr, "OpenCL Error(%d): clCreateCommandQueueWithProperties() Failed (%d)\n", __LINE__, clResult);
+        ReleaseBenchCL( &cl);
+        return(-1);
+    }
+
+        //wind image : forced, or 'auto' when the device has it, else the packed buffer
+    bool windImage = false;
+    if( windMap->procedural == false)
+    {
+        bool imageSupported = GrassWindImageSupported( cl.context, device);
+        if( (strcmp( gpClWindName, "image") == 0) && !imageSupported)
+        {
+            fprintf( stderr, "RunBenchCL() : \"%s\" has no CL_RG unorm8 image support\n", deviceName);
+            ReleaseBenchCL( &cl);
+            return(-1);
+        }
+        windImage = imageSupported && (strcmp( gpClWindName, "buffer") != 0);
+    }
+    if( windImage)
+    {
+        snprintf( buildOptions, sizeof( buildOptions), "%s%s", options, GRASS_WIND_IMAGE_OPTION);
+    }
+
+    char *source = LoadKernelSource( kernelFileName);
+    if( source == NULL)
+    {
+        fprintf( stderr, "Cannot load kernel \"%s\"\n", kernelFileName);
+        ReleaseBenchCL( &cl);
+        return(-1);
+    }
+
+        //same cache as Main.cpp
+    GRASS_PROGRAM_SOURCE programSource;
+    long long programStart = GrassProfileNow();
+
+    cl.program = GrassBuildProgramCached( cl.context, device, source, buildOptions, cachePrefix, &programSource, &clResult);
+    free( source);
+
+    double programMs = ( GrassProfileNow() - programStart) * 1.0e-6;
+
+    if( cl.program == NULL)
+    {
+        fprintf( stderr, "OpenCL Error(%d): clCreateProgramWithSource() Failed (%d)\n", __LINE__, clResult);
+        ReleaseBenchCL( &cl);
+        return(-1);
+    }
+
+    if( CL_SUCCESS != clResult)
+    {
+        fprintf( stderr, "OpenCL Error(%d): clBuildProgram() Failed (%d)\n", __LINE__, clResult);
+
+        size_t len = 0;
+        clGetProgramBuildInfo( cl.program, device, CL_PROGRAM_BUILD_LOG, 0, NULL, &len);
+
+        char *buffer = (char *) malloc( len + 1);
+        if( buffer)
+        {
+            clGetProgramBuildInfo( cl.program, device, CL_PROGRAM_BUILD_LOG, len, buffer, NULL);
+            buffer[ len] = '\0';
+            fprintf( stderr, "%s\n", buffer);
+            free( buffer);
+        }
+
+        ReleaseBenchCL( &cl);
+        return(-1);
+    }
+
+    cl.kernel = clCreateKernel( cl.program, "grass_kernel", &clResult);
+    if( CL_SUCCESS == clResult)
+    {
+        cl.segmentKernel = clCreateKernel( cl.program, "grass_segment_kernel", &clResult);
+    }
+    if( CL_SUCCESS != clResult)
+    {
+        fprintf( stderr, "OpenCL Error(%d): clCreateKernel() Failed (%d)\n", __LINE__, clResult);
+        ReleaseBenchCL( &cl);
+        return(-1);
+    }
+
+    for( int i = 0; (i < pipelineDepth) && (CL_SUCCESS == clResult); i++)
+    {
+        cl.outputBuffer[i] = clCreateBuffer( cl.context, CL_MEM_WRITE_ONLY, outputBytes, NULL, &clResult);
+    }
+    if( CL_SUCCESS == clResult)
+    {
+        cl.tileBuffer = clCreateBuffer( cl.context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, tileCount * sizeof( GRASS_LOD_TILE), (void *)tiles, &clResult);
+    }
+    if( (CL_SUCCESS == clResult) && meshVertexData)
+    {
+        cl.vertexBuffer = clCreateBuffer( cl.context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, (size_t)gridSize * gridSize * sizeof( VERTEX), (void *)meshVertexData, &clResult);
+    }
+    if( (CL_SUCCESS == clResult) && windImage)
+    {
+        cl.windImage = GrassCreateWindImage( cl.context, windMap, &clResult);
+    }
+    else if( (CL_SUCCESS == clResult) && (windMap->procedural == false))
+    {
+        cl.windBuffer = clCreateBuffer( cl.context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, GrassGetPackedWindBytes( windMap->width, windMap->height), (void *)windMap->packed, &clResult);
+    }
+    if( CL_SUCCESS != clResult)
+    {
+        fprintf( stderr, "OpenCL Error(%d): clCreateBuffer() Failed (%d)\n", __LINE__, clResult);
+        ReleaseBenchCL( &cl);
+        return(-1);
+    }
+
+        //everything but the time is fixed
+    GRASS_GRID grid;
+    CreateGrid( 0, 0, gridSize, gridSize, MESH_MULTIPLICANT, &grid);
+
+    cl_uint meshWidth = gridSize;
+    cl_uint meshHeight = gridSize;
+    cl_int mapWidth = windMap->width;
+    cl_int mapHeight = windMap->height;
+    cl_float time = 0.0f;
+    cl_uint rootSource = meshVertexData ? GRASS_ROOTS_MESH : GRASS_ROOTS_GRID;
+    cl_uint windSource = windMap->procedural ? GRASS_WIND_PROCEDURAL : GRASS_WIND_TEXTURE;
+
+    cl_float4 gridParams;
+    gridParams.s[0] = grid.left;
+    gridParams.s[1] = grid.top;
+    gridParams.s[2] = grid.spacing;
+    gridParams.s[3] = 0.0f;
+
+        //both kernels take the same arguments
+    clResult = CL_SUCCESS;
+    for( int i = 0; i < 2; i++)
+    {
+        cl_kernel kernel = ( i == 0) ? cl.kernel : cl.segmentKernel;
+
+        clResult |= clSetKernelArg( kernel, 0, sizeof( cl_mem), (void *)&cl.outputBuffer[0]);
+        clResult |= clSetKernelArg( kernel, 1, sizeof( cl_mem), meshVertexData ? (void *)&cl.vertexBuffer : NULL);
+        clResult |= clSetKernelArg( kernel, 2, sizeof( cl_uint), (void *)&meshWidth);
+        clResult |= clSetKernelArg( kernel, 3, sizeof( cl_uint), (void *)&meshHeight);
+        clResult |= clSetKernelArg( kernel, 4, sizeof( cl_mem), (void *)&cl.tileBuffer);
+        clResult |= clSetKernelArg( kernel, 5, sizeof( cl_mem), cl.windBuffer ? (void *)&cl.windBuffer : NULL);
+        clResult |= clSetKernelArg( kernel, 6, sizeof( cl_int), (void *)&mapWidth);
+        clResult |= clSetKernelArg( kernel, 7, sizeof( cl_int), (void *)&mapHeight);
+        clResult |= clSetKernelArg( kernel, 8, sizeof( cl_float), (void *)&time);
+        clResult |= clSetKernelArg( kernel, 9, sizeof( cl_uint), (void *)&rootSource);
+        clResult |= clSetKernelArg( kernel, 10, sizeof( cl_float4), (void *)&gridParams);
+        clResult |= clSetKernelArg( kernel, 11, sizeof( cl_mem), NULL);
+        clResult |= clSetKernelArg( kernel, 12, sizeof( cl_uint), (void *)&windSource);
+        clResult |= clSetKernelArg( kernel, 13, sizeof( GRASS_PROCEDURAL_WIND), (void *)&windMap->model);
+        if( windImage)
+        {
+            clResult |= clSetKernelArg( kernel, GRASS_KERNEL_ARG_WIND_IMAGE, sizeof( cl_mem), (void *)&cl.windImage);
+        }
+    }
+    if( CL_SUCCESS != clResult)
+    {
+        fprintf( stderr, "OpenCL Error(%d): clSetKernelArg() Failed\n", __LINE__);
+        ReleaseBenchCL( &cl);
+        return(-1);
+    }
+
+        //kernel and local size from the profile, else tuned on these tiles and stored, same as Main.cpp
+    GRASS_WORK_GROUP workGroup;
+    const char *workGroupSource = "driver";
+    int gridClass = GrassWorkGroupClass( gridSize, gridSize);
+    int segments = grassField.params.segments;
+
+    memset( &workGroup, 0, sizeof( GRASS_WORK_GROUP));
+    if( strcmp( gpClRangeName, "segment") == 0)
+    {
+        workGroup.kernel = GRASS_KERNEL_SEGMENT;
+        workGroup.local[0] = GRASS_SEGMENT_GROUP;
+        workGroup.local[1] = 1;
+        workGroupSource = "-clrange";
+    }
+    else if( (workGroupProfile != NULL) && (strcmp( gpClRangeName, "auto") == 0))
+    {
+        workGroupSource = "profile";
+        if( GrassLoadWorkGroup( workGroupProfile, device, buildOptions, gridClass, &workGroup) != 0)
+        {
+            clResult = GrassTuneWorkGroup( cl.commandQueue, cl.kernel, cl.segmentKernel, device, tileCount, segments, MAX( frameCount, 1), tuning);
+            if( CL_SUCCESS != clResult)
+            {
+                fprintf( stderr, "OpenCL Error(%d): GrassTuneWorkGroup() Failed (%d)\n", __LINE__, clResult);
+                ReleaseBenchCL( &cl);
+                return(-1);
+            }
+
+            workGroup = tuning->candidate[ tuning->best];
+            workGroupSource = "tuned";
+            if( GrassStoreWorkGroup( workGroupProfile, device, buildOptions, gridClass, &workGroup) != 0)
+            {
+                fprintf( stderr, "Cannot write \"%s\"\n", workGroupProfile);
+            }
+        }
+    }
+
+    cl_kernel runKernel = ( workGroup.kernel == GRASS_KERNEL_SEGMENT) ? cl.segmentKernel : cl.kernel;
+
+    cl_uint tileArg = tileCount;
+    clResult = clSetKernelArg( runKernel, GRASS_KERNEL_ARG_TILE_COUNT, sizeof( cl_uint), (void *)&tileArg);
+    if( CL_SUCCESS != clResult)
+    {
+        fprintf( stderr, "OpenCL Error(%d): clSetKernelArg() Failed (%d)\n", __LINE__, clResult);
+        ReleaseBenchCL( &cl);
+        return(-1);
+    }
+
+        //blades ( or blade segments) of a tile x tiles, padded to the work group
+    size_t globalWorkSize[2];
+    const size_t *localWorkSize = GrassWorkGroupRange( &workGroup, tileCount, segments, globalWorkSize);
+
+        //warm up ( first touch of the buffers), then one kernel per frame
+    cl_event kernelEvent[ BENCH_PIPELINE_DEPTH];
+    long long enqueueNs[ BENCH_PIPELINE_DEPTH];
+    double latencySum = 0.0;
+    int latencyCount = 0;
+    int lastBuffer = 0;
+
+    memset( kernelEvent, 0, sizeof( kernelEvent));
+
+    std::chrono::high_resolution_clock::time_point start;
+    for( int frame = -1; frame < frameCount + pipelineDepth - 1; frame++)
+    {
+            //the pipelined run drains its last frames without enqueuing new ones
+        if( frame < frameCount)
+        {
+            int buffer = ( frame + 1) % pipelineDepth;
+
+            time = MAX( frame, 0) * 0.016f;
+            clSetKernelArg( runKernel, 0, sizeof( cl_mem), (void *)&cl.outputBuffer[ buffer]);
+            clSetKernelArg( runKernel, 8, sizeof( cl_float), (void *)&time);
+
+            enqueueNs[ buffer] = GrassProfileNow();
+            clResult = clEnqueueNDRangeKernel( cl.commandQueue, runKernel, 2, NULL, globalWorkSize, localWorkSize, 0, NULL, &kernelEvent[ buffer]);
+            if( CL_SUCCESS != clResult)
+            {
+                fprintf( stderr, "OpenCL Error(%d): clEnqueueNDRangeKernel() Failed (%d)\n", __LINE__, clResult);
+                ReleaseBenchCL( &cl);
+                return(-1);
+            }
+            clFlush( cl.commandQueue);
+            lastBuffer = buffer;
+        }
+
+            //frame whose output the host would draw now, the oldest one in flight
+        int drawFrame = frame - ( pipelineDepth - 1);
+        if( drawFrame < -1)
+        {
+            continue;
+        }
+        int drawBuffer = ( drawFrame + 1) % pipelineDepth;
+
+        clWaitForEvents( 1, &kernelEvent[ drawBuffer]);
+        if( drawFrame == -1)
+        {
+            start = std::chrono::high_resolution_clock::now();
+        }
+        else
+        {
+            latencySum += ( GrassProfileNow() - enqueueNs[ drawBuffer]) * 1.0e-6;
+            latencyCount++;
+        }
+
+            //device clock, lined up with the host zones at the enqueue ( CL_PROFILING_COMMAND_QUEUED)
+        cl_ulong queued, start, end;
+        if( ( drawFrame >= 0) &&
+            ( clGetEventProfilingInfo( kernelEvent[ drawBuffer], CL_PROFILING_COMMAND_QUEUED, sizeof( cl_ulong), &queued, NULL) == CL_SUCCESS) &&
+            ( clGetEventProfilingInfo( kernelEvent[ drawBuffer], CL_PROFILING_COMMAND_START, sizeof( cl_ulong), &start, NULL) == CL_SUCCESS) &&
+            ( clGetEventProfilingInfo( kernelEvent[ drawBuffer], CL_PROFILING_COMMAND_END, sizeof( cl_ulong), &end, NULL) == CL_SUCCESS))
+        {
+            GrassProfileStatAdd( kernelStat, ( end - start) * 1.0e-6f);
+            GrassProfileRecordTrack( "grass_kernel", (long long)start + enqueueNs[ drawBuffer] - (long long)queued, (long long)end + enqueueNs[ drawBuffer] - (long long)queued, GRASS_PROFILE_TRACK_OPENCL);
+        }
+        clReleaseEvent( kernelEvent[ drawBuffer]);
+        kernelEvent[ drawBuffer] = NULL;
+    }
+
+    double seconds = std::chrono::duration<double>( std::chrono::high_resolution_clock::now() - start).count();
+
+    clResult = clEnqueueReadBuffer( cl.commandQueue, cl.outputBuffer[ lastBuffer], CL_TRUE, 0, outputBytes, grassVertex, 0, NULL, NULL);
+    ReleaseBenchCL( &cl);
+
+    if( CL_SUCCESS != clResult)
+    {
+        fprintf( stderr, "OpenCL Error(%d): clEnqueueReadBuffer() Failed (%d)\n", __LINE__, clResult);
+        return(-1);
+    }
+
+    memset( result, 0, sizeof( BENCH_RESULT));
+    result->msPerFrame = seconds * 1000.0 / frameCount;
+    result->bladesPerSec = (double)grassField.getBladeCount() * frameCount / seconds;
+    result->visibleBlades = grassField.getBladeCount();
+    result->outputVertices = grassField.getOutputVertexCount();
+    result->latencyMs = ( latencyCount > 0) ? latencySum / latencyCount : 0.0;
+    result->programMs = programMs;
+    result->programSource = GrassProgramSourceName( programSource);
+    result->workGroup[0] = workGroup.local[0];
+    result->workGroup[1] = workGroup.local[1];
+    result->workGroupSource = workGroupSource;
+    result->workGroupKernel = workGroup.kernel;
+    result->windSource = windMap->procedural ? "procedural" : ( windImage ? "image" : "buffer");
+
+    return(0);
+}
+
+#endif
+
+//command line, defaults are set by ParseOptions()
+typedef struct BENCH_OPTIONS
+{
+    int gridSize;
+    int frameCount;
+    const char *windFileName;
+    const char *layoutName;
+    const char *simdName;
+    const char *threadsName;
+    bool benchIndices;
+    const char *rootsName;
+    bool benchCull;
+    bool benchLod;
+    bool benchSchedule;
+    int bladeBudget;
+    const char *windMapName;
+    const char *backendName;
+#ifdef GRASS_BENCH_OPENCL
+    const char *kernelFileName;
+    const char *clCacheName;
+    const char *workGroupName;
+    const char *clVariantName;
+#endif
+    float tolerance;
+    const char *traceFileName;
+} BENCH_OPTIONS;
+
+//grid, wind maps and output every mode runs on, built by main()
+typedef struct BENCH_SETUP
+{
+    GRASS_SIMD_LEVEL simdLevel;
+    int threadCount;
+    int gridSize;
+    int frameCount;
+    VERTEX *meshVertexData;
+    const VERTEX *rootVertices;     //NULL : GrassField computes the roots, see RunBench()
+    GRASS_WIND_MAP windMap;         //-windmap
+    GRASS_WIND_MAP packedWindMap;   //RG8 copy, nearest
+    size_t floatWindBytes;
+    size_t packedWindBytes;
+    GRASS_VERTEX *grassVertex;
+    size_t vertexCount;
+} BENCH_SETUP;
+
+//
+//ParseOptions() :- return 0, -1 after printing the usage
+//
+int ParseOptions( int argc, char *argv[], BENCH_OPTIONS *options)
+{
+    //code
+    options->gridSize = 256;
+    options->frameCount = 100;
+    options->windFileName = "texture/Wind.bmp";
+    options->layoutName = "compact";
+    options->simdName = "auto";
+    options->threadsName = "1";
+    options->benchIndices = false;
+    options->rootsName = "mesh";
+    options->benchCull = false;
+    options->benchLod = false;
+    options->benchSchedule = false;
+    options->bladeBudget = 0;
+    options->windMapName = "float";
+    options->backendName = "cpu";
+#ifdef GRASS_BENCH_OPENCL
+    options->kernelFileName = "Grass.cl";
+    options->clCacheName = NULL;
+    options->workGroupName = NULL;
+    options->clVariantName = "both";
+#endif
+    options->tolerance = BENCH_TOLERANCE;
+    options->traceFileName = NULL;
+
+    for( int i = 1; i < argc; i++)
+    {
+        if( (strcmp( argv[i], "-grid") == 0) && (i + 1 < argc))
+        {
+            options->gridSize = atoi( argv[++i]);
+        }
+        else if( (strcmp( argv[i], "-frames") == 0) && (i + 1 < argc))
+        {
+            options->frameCount = atoi( argv[++i]);
+        }
+        else if( (strcmp( argv[i], "-wind") == 0) && (i + 1 < argc))
+        {
+            options->windFileName = argv[++i];
+        }
+        else if( (strcmp( argv[i], "-layout") == 0) && (i + 1 < argc))
+        {
+            options->layoutName = argv[++i];
+        }
+        else if( (strcmp( argv[i], "-simd") == 0) && (i + 1 < argc))
+        {
+            options->simdName = argv[++i];
+        }
+        else if( (strcmp( argv[i], "-threads") == 0) && (i + 1 < argc))
+        {
+            options->threadsName = argv[++i];
+        }
+        else if( (strcmp( argv[i], "-roots") == 0) && (i + 1 < argc))
+        {
+            options->rootsName = argv[++i];
+        }
+        else if( strcmp( argv[i], "-indices") == 0)
+        {
+            options->benchIndices = true;
+        }
+        else if( strcmp( argv[i], "-cull") == 0)
+        {
+            options->benchCull = true;
+        }
+        else if( strcmp( argv[i], "-lod") == 0)
+        {
+            options->benchLod = true;
+        }
+        else if( strcmp( argv[i], "-schedule") == 0)
+        {
+            options->benchLod = true;
+            options->benchSchedule = true;
+        }
+        else if( (strcmp( argv[i], "-budget") == 0) && (i + 1 < argc))
+        {
+            options->bladeBudget = atoi( argv[++i]);
+        }
+        else if( (strcmp( argv[i], "-windmap") == 0) && (i + 1 < argc))
+        {
+            options->windMapName = argv[++i];
+        }
+        else if( (strcmp( argv[i], "-backend") == 0) && (i + 1 < argc))
+        {
+            options->backendName = argv[++i];
+        }
+#ifdef GRASS_BENCH_OPENCL     //without OpenCL the options below are usage errors
+        else if( (strcmp( argv[i], "-kernel") == 0) && (i + 1 < argc))
+        {
+            options->kernelFileName = argv[++i];
+        }
+        else if( (strcmp( argv[i], "-clcache") == 0) && (i + 1 < argc))
+        {
+            options->clCacheName = argv[++i];
+        }
+        else if( (strcmp( argv[i], "-clvariant") == 0) && (i + 1 < argc))
+        {
+            options->clVariantName = argv[++i];
+        }
+        else if( (strcmp( argv[i], "-clwind") == 0) && (i + 1 < argc))
+        {
+            gpClWindName = argv[++i];
+        }
+        else if( (strcmp( argv[i], "-clrange") == 0) && (i + 1 < argc))
+        {
+            gpClRangeName = argv[++i];
+        }
+        else if( (strcmp( argv[i], "-wgprofile") == 0) && (i + 1 < argc))
+        {
+            options->workGroupName = argv[++i];
+        }
+#endif
+        else if( (strcmp( argv[i], "-cldevice") == 0) && (i + 1 < argc))
+        {
+            gpClDeviceName = argv[++i];
+        }
+        else if( (strcmp( argv[i], "-tolerance") == 0) && (i + 1 < argc))
+        {
+            options->tolerance = (float)atof( argv[++i]);
+        }
+        else if( (strcmp( argv[i], "-trace") == 0) && (i + 1 < argc))
+        {
+            options->traceFileName = argv[++i];
+        }
+        else
+        {
+            fprintf( stderr, "usage: %s [-grid N] [-frames N] [-wind file.bmp] [-layout mat4|compact|both] [-simd auto|scalar|avx2|avx512|all] [-threads N|all|scale] [-indices] [-roots mesh|grid|both] [-cull] [-lod] [-schedule] [-budget N] [-windmap float|rg8|bilinear|procedural|compare] [-backend cpu|compare] [-kernel file.cl] [-clvariant mat4|float4|both] [-clwind auto|buffer|image] [-clrange auto|blade|segment] [-cldevice index|name|list] [-clcache prefix] [-wgprofile file] [-tolerance X] [-trace file.json]\n", argv[0]);
+            return(-1);
+        }
+    }
+
+    return(0);
+}
+
+//
+//ListDevices() :- -cldevice list
+//
+void ListDevices( void)
+{
+    //code
+#ifdef GRASS_BENCH_OPENCL
+    GRASS_CL_DEVICE devices[ GRASS_MAX_CL_DEVICES];
+    int deviceCount = GrassEnumerateDevices( devices, GRASS_MAX_CL_DEVICES);
+
+    for( int i = 0; i < deviceCount; i++)
+    {
+        printf( "%2d  %-11s %-40s %s%s\n", i, GrassDeviceTypeName( devices[i].type), devices[i].name, devices[i].platformName, devices[i].glSharing ? ", GL sharing" : "");
+    }
+    if( deviceCount == 0)
+    {
+        printf( "no OpenCL device\n");
+    }
+#else
+    printf( "OpenCL not built\n");
+#endif
+}
+
+//
+//AllocVertices() :- reference output of a comparing mode, NULL on error
+//
+GRASS_VERTEX *AllocVertices( size_t vertexCount)
+{
+    //code
+    GRASS_VERTEX *vertices = (GRASS_VERTEX *) malloc( vertexCount * sizeof(GRASS_VERTEX));
+    if( vertices == NULL)
+    {
+        fprintf( stderr, "malloc() Failed\n");
+    }
+
+    return( vertices);
+}
+
+//
+//BenchBackends() :- -backend compare, return 0, -1 on error or when a backend is off by more than -tolerance
+//
+int BenchBackends( const BENCH_OPTIONS *options, const BENCH_SETUP *setup)
+{
+    //variable declarations
+    BENCH_RESULT mat4Result, compactResult;
+    GRASS_VERTEX *grassVertex = setup->grassVertex;
+    size_t vertexCount = setup->vertexCount;
+    float tolerance = options->tolerance;
+    int failed = 0;
+    float diff;
+
+    //code
+    GRASS_VERTEX *referenceVertex = AllocVertices( vertexCount);
+    if( referenceVertex == NULL)
+    {
+        return(-1);
+    }
+
+        //the wind grass_kernel samples
+    GRASS_WIND_MAP backendWindMap = setup->windMap;
+    if( setup->windMap.procedural == false)
+    {
+        backendWindMap = setup->packedWindMap;
+        backendWindMap.bilinear = true;
+    }
+
+    printf( "%-24s %10s %14s %16s\n", "backend", "ms/frame", "M blades/sec", "max vertex diff");
+
+    if( RunBench( GRASS_LAYOUT_MAT4, GRASS_SIMD_SCALAR, setup->threadCount, setup->gridSize, setup->frameCount, setup->rootVertices, &backendWindMap, NULL, NULL, NULL, referenceVertex, vertexCount, &mat4Result) != 0)
+        return(-1);
+    printf( "%-24s %10.3f %14.3f %16s\n", "cpu mat4", mat4Result.msPerFrame, mat4Result.bladesPerSec / 1.0e6, "reference");
+
+    for( int level = GRASS_SIMD_SCALAR; level <= GrassSimdDetect(); level++)
+    {
+        if( RunBench( GRASS_LAYOUT_COMPACT, (GRASS_SIMD_LEVEL)level, setup->threadCount, setup->gridSize, setup->frameCount, setup->rootVertices, &backendWindMap, NULL, NULL, NULL, grassVertex, vertexCount, &compactResult) != 0)
+            return(-1);
+
+        char name[64];
+        sprintf( name, "cpu compact %s", GrassSimdName( (GRASS_SIMD_LEVEL)level));
+
+        diff = MaxVertexDifference( referenceVertex, grassVertex, vertexCount);
+        failed |= ( diff > tolerance);
+        printf( "%-24s %10.3f %14.3f %16g%s\n", name, compactResult.msPerFrame, compactResult.bladesPerSec / 1.0e6, diff, ( diff > tolerance) ? "  FAIL" : "");
+    }
+
+#ifdef GRASS_BENCH_OPENCL
+    BENCH_RESULT openclResult;
+    GRASS_WORK_GROUP_TUNING tuning;
+    GRASS_PROFILE_STAT kernelStat;
+    char deviceName[ 256];
+    float variantKernelMs[ BENCH_CL_VARIANTS] = { 0.0f, 0.0f};
+    bool noDevice = false;
+
+    for( int variant = 0; ( variant < BENCH_CL_VARIANTS) && !noDevice; variant++)
+    {
+        if( ( strcmp( options->clVariantName, "both") != 0) && ( strcmp( options->clVariantName, benchVariantNames[ variant]) != 0))
+        {
+            continue;
+        }
+
+            //synchronous ( clFinish every frame) and pipelined
+        for( int depth = 1; depth <= BENCH_PIPELINE_DEPTH; depth++)
+        {
+            memset( &kernelStat, 0, sizeof( kernelStat));
+
+            memset( grassVertex, 0, vertexCount * sizeof( GRASS_VERTEX));
+            int status = RunBenchCL( options->kernelFileName, benchVariantOptions[ variant], options->clCacheName, options->workGroupName, setup->gridSize, setup->frameCount, setup->rootVertices, &backendWindMap,
+                                     grassVertex, vertexCount, depth, &openclResult, &tuning, &kernelStat, deviceName, sizeof( deviceName));
+            if( status < 0)
+            {
+                return(-1);
+            }
+            else if( status > 0)
+            {
+                printf( "%-24s %10s %14s %16s\n", "opencl", "-", "-", "no device");
+                noDevice = true;
+                break;
+            }
+
+            diff = MaxVertexDifference( referenceVertex, grassVertex, vertexCount);
+            failed |= ( diff > tolerance);
+            printf( "opencl %-6s %-10.10s %10.3f %14.3f %16g%s\n", benchVariantNames[ variant], deviceName, openclResult.msPerFrame, openclResult.bladesPerSec / 1.0e6, diff, ( diff > tolerance) ? "  FAIL" : "");
+
+            float minMs, avgMs, p99Ms;
+            GrassProfileStatSummary( &kernelStat, &minMs, &avgMs, &p99Ms);
+            if( depth == 1)
+            {
+                variantKernelMs[ variant] = avgMs;
+            }
+            printf( "  %-22s %10.3f ms latency, %d frame(s) in flight, kernel %.3f ms ( min %.3f, p99 %.3f)\n", ( depth == 1) ? "synchronous" : "pipelined",
+                openclResult.latencyMs, depth, avgMs, minMs, p99Ms);
+            printf( "  %-22s %10.3f ms from %s\n", "program", openclResult.programMs, openclResult.programSource);
+            printf( "  %-22s %10s\n", "wind map", openclResult.windSource);
+
+            for( int i = 0; i < tuning.count; i++)
+            {
+                char shape[32];
+                if( tuning.candidate[i].kernel == GRASS_KERNEL_SEGMENT)
+                    sprintf( shape, "segment %d", (int)tuning.candidate[i].local[0]);
+                else if( tuning.candidate[i].local[0] == 0)
+                    sprintf( shape, "driver");
+                else
+                    sprintf( shape, "%d x %d", (int)tuning.candidate[i].local[0], (int)tuning.candidate[i].local[1]);
+
+                if( tuning.candidate[i].ms < 0.0f)
+                    printf( "    work group %-11s %10s ms\n", shape, "-");
+                else
+                    printf( "    work group %-11s %10.3f ms%s\n", shape, tuning.candidate[i].ms, ( i == tuning.best) ? "  best" : "");
+            }
+            const char *rangeKernel = ( openclResult.workGroupKernel == GRASS_KERNEL_SEGMENT) ? "grass_segment_kernel" : "grass_kernel";
+            if( openclResult.workGroup[0] == 0)
+                printf( "  %-22s %10s from %s, %s\n", "work group", "driver", openclResult.workGroupSource, rangeKernel);
+            else
+                printf( "  %-22s %4d x %-3d from %s, %s\n", "work group", (int)openclResult.workGroup[0], (int)openclResult.workGroup[1], openclResult.workGroupSource, rangeKernel);
+        }
+    }
+
+        //synchronous kernel time, device clock
+    if( ( variantKernelMs[0] > 0.0f) && ( variantKernelMs[1] > 0.0f))
+    {
+        printf( "float4 kernel %.2fx faster than mat4 ( %.3f against %.3f ms)\n", variantKernelMs[0] / variantKernelMs[1], variantKernelMs[1], variantKernelMs[0]);
+    }
+#else
+    printf( "%-24s %10s %14s %16s\n", "opencl", "-", "-", "not built");
+#endif
+
+    printf( "tolerance %g, %s\n", tolerance, failed ? "FAILED" : "passed");
+
+    free( referenceVertex);
+
+    return( failed ? -1 : 0);
+}
+
+//
+//BenchWindMaps() :- -windmap compare, float / RG8 / bilinear / analytic wind
+//
+int BenchWindMaps( const BENCH_SETUP *setup)
+{
+    //variable declarations
+    BENCH_RESULT mat4Result, compactResult, packedResult, bilinearResult, proceduralResult;
+    GRASS_VERTEX *grassVertex = setup->grassVertex;
+    size_t vertexCount = setup->vertexCount;
+
+    //code
+    GRASS_VERTEX *referenceVertex = AllocVertices( vertexCount);
+    if( referenceVertex == NULL)
+    {
+        return(-1);
+    }
+
+    GRASS_WIND_MAP bilinearWindMap = setup->packedWindMap;
+    bilinearWindMap.bilinear = true;
+
+    if( RunBench( GRASS_LAYOUT_COMPACT, setup->simdLevel, setup->threadCount, setup->gridSize, setup->frameCount, setup->rootVertices, &setup->windMap, NULL, NULL, NULL, referenceVertex, vertexCount, &compactResult) != 0)
+        return(-1);
+    PrintResult( "float", &compactResult);
+    printf( "          wind map %.2f MB ( %d x %d RGBA float)\n", setup->floatWindBytes / (1024.0 * 1024.0), setup->windMap.width, setup->windMap.height);
+
+    if( RunBench( GRASS_LAYOUT_COMPACT, setup->simdLevel, setup->threadCount, setup->gridSize, setup->frameCount, setup->rootVertices, &setup->packedWindMap, NULL, NULL, NULL, grassVertex, vertexCount, &packedResult) != 0)
+        return(-1);
+    PrintResult( "rg8", &packedResult);
+    printf( "          wind map %.2f MB ( %.1fx smaller), %.2fx vs float, max vertex diff %g\n",
+        setup->packedWindBytes / (1024.0 * 1024.0), (double)setup->floatWindBytes / setup->packedWindBytes,
+        compactResult.msPerFrame / packedResult.msPerFrame, MaxVertexDifference( referenceVertex, grassVertex, vertexCount));
+
+        //bilinear against its own mat4 reference, the shape differs from nearest on purpose
+    if( RunBench( GRASS_LAYOUT_MAT4, GRASS_SIMD_SCALAR, setup->threadCount, setup->gridSize, setup->frameCount, setup->rootVertices, &bilinearWindMap, NULL, NULL, NULL, referenceVertex, vertexCount, &mat4Result) != 0)
+        return(-1);
+    if( RunBench( GRASS_LAYOUT_COMPACT, setup->simdLevel, setup->threadCount, setup->gridSize, setup->frameCount, setup->rootVertices, &bilinearWindMap, NULL, NULL, NULL, grassVertex, vertexCount, &bilinearResult) != 0)
+        return(-1);
+    PrintResult( "bilinear", &bilinearResult);
+    printf( "          %.2fx vs float, max vertex diff vs mat4 bilinear %g\n",
+        compactResult.msPerFrame / bilinearResult.msPerFrame, MaxVertexDifference( referenceVertex, grassVertex, vertexCount));
+
+    GRASS_WIND_MAP proceduralWindMap;
+    proceduralWindMap.procedural = true;
+
+    if( RunBench( GRASS_LAYOUT_MAT4, GRASS_SIMD_SCALAR, setup->threadCount, setup->gridSize, setup->frameCount, setup->rootVertices, &proceduralWindMap, NULL, NULL, NULL, referenceVertex, vertexCount, &mat4Result) != 0)
+        return(-1);
+    if( RunBench( GRASS_LAYOUT_COMPACT, setup->simdLevel, setup->threadCount, setup->gridSize, setup->frameCount, setup->rootVertices, &proceduralWindMap, NULL, NULL, NULL, grassVertex, vertexCount, &proceduralResult) != 0)
+        return(-1);
+    PrintResult( "analytic", &proceduralResult);
+    printf( "          wind map 0 MB, %.2fx vs float, %.2fx vs bilinear, max vertex diff vs mat4 procedural %g\n",
+        compactResult.msPerFrame / proceduralResult.msPerFrame, bilinearResult.msPerFrame / proceduralResult.msPerFrame,
+        MaxVertexDifference( referenceVertex, grassVertex, vertexCount));
+
+    free( referenceVertex);
+
+    return(0);
+}
+
+//
+//BenchCull() :- -cull / -lod / -schedule against the full field
+//
+int BenchCull( const BENCH_OPTIONS *options, const BENCH_SETUP *setup)
+{
+    //variable declarations
+    BENCH_RESULT compactResult, cullResult, lodResult;
+    GRASS_VERTEX *grassVertex = setup->grassVertex;
+    size_t vertexCount = setup->vertexCount;
+
+    //code
+    GRASS_VERTEX *referenceVertex = AllocVertices( vertexCount);
+    if( referenceVertex == NULL)
+    {
+        return(-1);
+    }
+
+        //standing at the field centre, eye height 2, looking along +z ( same projection as Main.cpp at 16:9)
+    vmath::vec3 eye( 0.0f, 2.0f, 0.0f);
+    vmath::mat4 viewProjection = vmath::perspective( 45.0f, 16.0f / 9.0f, 0.1f, 200.0f) *
+                                 vmath::lookat( eye, vmath::vec3( 0.0f, 0.0f, 30.0f), vmath::vec3( 0.0f, 1.0f, 0.0f));
+
+    if( RunBench( GRASS_LAYOUT_COMPACT, setup->simdLevel, setup->threadCount, setup->gridSize, setup->frameCount, setup->rootVertices, &setup->windMap, NULL, NULL, NULL, referenceVertex, vertexCount, &compactResult) != 0)
+        return(-1);
+    PrintResult( "all", &compactResult);
+
+    memset( grassVertex, 0, vertexCount * sizeof( GRASS_VERTEX));
+    if( RunBench( GRASS_LAYOUT_COMPACT, setup->simdLevel, setup->threadCount, setup->gridSize, setup->frameCount, setup->rootVertices, &setup->windMap, &viewProjection, NULL, NULL, grassVertex, vertexCount, &cullResult) != 0)
+        return(-1);
+    PrintResult( "culled", &cullResult);
+
+    GrassField allField, cullField;
+    if( (ResizeField( &allField, setup->gridSize, setup->rootVertices) != 0) || (ResizeField( &cullField, setup->gridSize, setup->rootVertices) != 0))
+        return(-1);
+    cullField.cull( &viewProjection);
+
+    printf( "          visible %d / %d blades ( %d / %d tiles, %.1f%%), %.2fx vs all, saved %.3f ms/frame, max vertex diff %g\n",
+        cullResult.visibleBlades, cullField.getBladeCount(), cullField.getVisibleTileCount(), cullField.getTileCount(),
+        100.0 * cullResult.visibleBlades / cullField.getBladeCount(),
+        compactResult.msPerFrame / cullResult.msPerFrame, compactResult.msPerFrame - cullResult.msPerFrame,
+        MaxVisibleDifference( &allField, &cullField, referenceVertex, grassVertex));
+
+    if( options->benchLod)
+    {
+        memset( grassVertex, 0, vertexCount * sizeof( GRASS_VERTEX));
+        if( RunBench( GRASS_LAYOUT_COMPACT, setup->simdLevel, setup->threadCount, setup->gridSize, setup->frameCount, setup->rootVertices, &setup->windMap, &viewProjection, &eye, NULL, grassVertex, vertexCount, &lodResult) != 0)
+            return(-1);
+        PrintResult( "lod", &lodResult);
+
+        cullField.cull( &viewProjection, &eye);
+
+        printf( "          output %d / %d vertices ( %.1f%%), %.2fx vs culled, %.2fx vs all, max vertex diff at level 0 %g\n",
+            lodResult.outputVertices, cullResult.outputVertices, 100.0 * lodResult.outputVertices / MAX( cullResult.outputVertices, 1),
+            cullResult.msPerFrame / lodResult.msPerFrame, compactResult.msPerFrame / lodResult.msPerFrame,
+            MaxVisibleDifference( &allField, &cullField, referenceVertex, grassVertex));
+
+        for( int level = 0; level < GRASS_LOD_LEVELS; level++)
+        {
+            printf( "          level %d : %2d segments, %8d blades\n", level, cullField.getLevelSegments( level), cullField.getLevelBladeCount( level));
+        }
+    }
+
+    if( options->benchSchedule)
+    {
+        GRASS_SCHEDULE_PARAMS schedule;
+        schedule.enabled = true;
+        schedule.bladeBudget = options->bladeBudget;
+
+        BENCH_RESULT scheduleResult;
+
+        if( RunBench( GRASS_LAYOUT_COMPACT, setup->simdLevel, setup->threadCount, setup->gridSize, setup->frameCount, setup->rootVertices, &setup->windMap, &viewProjection, &eye, &schedule, grassVertex, vertexCount, &scheduleResult) != 0)
+            return(-1);
+        PrintResult( "sliced", &scheduleResult);
+
+        printf( "          budget %d blades/frame ( 0 = no limit), max period %d, %.2f visible blades per regenerated blade, %.2fx vs lod\n",
+            schedule.bladeBudget, schedule.maxPeriod, scheduleResult.amortization, lodResult.msPerFrame / scheduleResult.msPerFrame);
+    }
+
+    free( referenceVertex);
+
+    return(0);
+}
+
+//
+//BenchRoots() :- -roots both, mesh roots against the procedural grid
+//
+int BenchRoots( const BENCH_SETUP *setup)
+{
+    //variable declarations
+    BENCH_RESULT compactResult;
+    GRASS_VERTEX *grassVertex = setup->grassVertex;
+    size_t vertexCount = setup->vertexCount;
+
+    //code
+    GRASS_VERTEX *referenceVertex = AllocVertices( vertexCount);
+    if( referenceVertex == NULL)
+    {
+        return(-1);
+    }
+
+    if( RunBench( GRASS_LAYOUT_COMPACT, setup->simdLevel, setup->threadCount, setup->gridSize, setup->frameCount, setup->meshVertexData, &setup->windMap, NULL, NULL, NULL, referenceVertex, vertexCount, &compactResult) != 0)
+        return(-1);
+    PrintResult( "mesh", &compactResult);
+    printf( "          root input %.2f MB\n", (double)setup->gridSize * setup->gridSize * sizeof( VERTEX) / (1024.0 * 1024.0));
+
+    if( RunBench( GRASS_LAYOUT_COMPACT, setup->simdLevel, setup->threadCount, setup->gridSize, setup->frameCount, NULL, &setup->windMap, NULL, NULL, NULL, grassVertex, vertexCount, &compactResult) != 0)
+        return(-1);
+    PrintResult( "grid", &compactResult);
+    printf( "          root input 0 MB, max vertex diff vs mesh %g\n", MaxVertexDifference( referenceVertex, grassVertex, vertexCount));
+
+    free( referenceVertex);
+
+    return(0);
+}
+
+//
+//BenchThreadScale() :- -threads scale, 1, 2, 4 .. hardware threads
+//
+int BenchThreadScale( const BENCH_SETUP *setup)
+{
+    //variable declarations
+    BENCH_RESULT compactResult, singleResult;
+    int maxThreads = CLAMP( (int)std::thread::hardware_concurrency(), 1, GRASS_MAX_THREADS);
+
+    //code
+    for( int threads = 1; ; threads = MIN( threads * 2, maxThreads))
+    {
+        if( RunBench( GRASS_LAYOUT_COMPACT, setup->simdLevel, threads, setup->gridSize, setup->frameCount, setup->rootVertices, &setup->windMap, NULL, NULL, NULL, setup->grassVertex, setup->vertexCount, &compactResult) != 0)
+            return(-1);
+
+        if( threads == 1)
+        {
+            singleResult = compactResult;
+        }
+
+        char name[32];
+        sprintf( name, "%d thr", threads);
+        PrintResult( name, &compactResult);
+        printf( "          %.2fx vs 1 thread, load imbalance %.3f (max / mean busy)\n",
+            singleResult.msPerFrame / compactResult.msPerFrame, compactResult.imbalance);
+        PrintThreadStats( &compactResult, setup->frameCount);
+
+        if( threads == maxThreads)
+            break;
+    }
+
+    return(0);
+}
+
+//
+//BenchSimdLevels() :- -simd all, every supported kernel against the mat4 reference
+//
+int BenchSimdLevels( const BENCH_SETUP *setup)
+{
+    //variable declarations
+    BENCH_RESULT mat4Result, compactResult;
+    GRASS_VERTEX *grassVertex = setup->grassVertex;
+    size_t vertexCount = setup->vertexCount;
+
+    //code
+    GRASS_VERTEX *referenceVertex = AllocVertices( vertexCount);
+    if( referenceVertex == NULL)
+    {
+        return(-1);
+    }
+
+    if( RunBench( GRASS_LAYOUT_MAT4, GRASS_SIMD_SCALAR, setup->threadCount, setup->gridSize, setup->frameCount, setup->rootVertices, &setup->windMap, NULL, NULL, NULL, referenceVertex, vertexCount, &mat4Result) != 0)
+        return(-1);
+    PrintResult( "mat4", &mat4Result);
+
+    for( int level = GRASS_SIMD_SCALAR; level <= GrassSimdDetect(); level++)
+    {
+        if( RunBench( GRASS_LAYOUT_COMPACT, (GRASS_SIMD_LEVEL)level, setup->threadCount, setup->gridSize, setup->frameCount, setup->rootVertices, &setup->windMap, NULL, NULL, NULL, grassVertex, vertexCount, &compactResult) != 0)
+            return(-1);
+
+        PrintResult( GrassSimdName( (GRASS_SIMD_LEVEL)level), &compactResult);
+        printf( "          %.2fx vs mat4, max vertex diff %g\n",
+            mat4Result.msPerFrame / compactResult.msPerFrame,
+            MaxVertexDifference( referenceVertex, grassVertex, vertexCount));
+    }
+
+    free( referenceVertex);
+
+    return(0);
+}
+
+//
+//BenchLayouts() :- -layout mat4 | compact | both
+//
+int BenchLayouts( const BENCH_OPTIONS *options, const BENCH_SETUP *setup)
+{
+    //variable declarations
+    BENCH_RESULT mat4Result, compactResult;
+    GRASS_VERTEX *grassVertex = setup->grassVertex;
+    size_t vertexCount = setup->vertexCount;
+
+    //code
+    if( strcmp( options->layoutName, "mat4") == 0)
+    {
+        if( RunBench( GRASS_LAYOUT_MAT4, GRASS_SIMD_SCALAR, setup->threadCount, setup->gridSize, setup->frameCount, setup->rootVertices, &setup->windMap, NULL, NULL, NULL, grassVertex, vertexCount, &mat4Result) != 0)
+            return(-1);
+        PrintResult( "mat4", &mat4Result);
+
+        return(0);
+    }
+
+    if( strcmp( options->layoutName, "compact") == 0)
+    {
+        if( RunBench( GRASS_LAYOUT_COMPACT, setup->simdLevel, setup->threadCount, setup->gridSize, setup->frameCount, setup->rootVertices, &setup->windMap, NULL, NULL, NULL, grassVertex, vertexCount, &compactResult) != 0)
+            return(-1);
+        PrintResult( "compact", &compactResult);
+
+        return(0);
+    }
+
+    GRASS_VERTEX *referenceVertex = AllocVertices( vertexCount);
+    if( referenceVertex == NULL)
+    {
+        return(-1);
+    }
+
+    if( RunBench( GRASS_LAYOUT_MAT4, GRASS_SIMD_SCALAR, setup->threadCount, setup->gridSize, setup->frameCount, setup->rootVertices, &setup->windMap, NULL, NULL, NULL, referenceVertex, vertexCount, &mat4Result) != 0)
+        return(-1);
+    if( RunBench( GRASS_LAYOUT_COMPACT, setup->simdLevel, setup->threadCount, setup->gridSize, setup->frameCount, setup->rootVertices, &setup->windMap, NULL, NULL, NULL, grassVertex, vertexCount, &compactResult) != 0)
+        return(-1);
+
+    PrintResult( "mat4", &mat4Result);
+    PrintResult( "compact", &compactResult);
+
+    printf( "speedup : %.2fx, static props %.1fx smaller, max vertex diff %g\n",
+        mat4Result.msPerFrame / compactResult.msPerFrame,
+        (double)mat4Result.staticBytes / compactResult.staticBytes,
+        MaxVertexDifference( referenceVertex, grassVertex, vertexCount));
+
+    free( referenceVertex);
+
+    return(0);
+}
+
+//
+//WriteTrace() :- -trace, Chrome trace plus a .csv next to it
+//
+int WriteTrace( const char *traceFileName)
+{
+    //variable declarations
+    char csvFileName[512];
+
+    //code
+    const char *extension = strrchr( traceFileName, '.');
+    int baseLength = (extension != NULL) ? (int)(extension - traceFileName) : (int)strlen( traceFileName);
+
+    snprintf( csvFileName, sizeof( csvFileName), "%.*s.csv", baseLength, traceFileName);
+
+    int zoneCount = GrassProfileWriteTrace( traceFileName);
+    if( (zoneCount < 0) || (GrassProfileWriteCsv( csvFileName) < 0))
+    {
+        fprintf( stderr, "cannot write %s / %s\n", traceFileName, csvFileName);
+        return(-1);
+    }
+    printf( "trace   : %d zones written to %s and %s\n", zoneCount, traceFileName, csvFileName);
+
+    return(0);
+}
+
+//
+//main()
+//
+int main( int argc, char *argv[])
+{
+    //variable declarations
+    BENCH_OPTIONS options;
+    BENCH_SETUP setup;
+    int windWidth, windHeight;
+    int status;
+
+    //code
+    if( ParseOptions( argc, argv, &options) != 0)
+    {
+        return( 1);
+    }
+
+    if( (gpClDeviceName != NULL) && (strcmp( gpClDeviceName, "list") == 0))
+    {
+        ListDevices();
+        return( 0);
+    }
+
+    setup.simdLevel = GrassSimdDefault();
+    if( strcmp( options.simdName, "scalar") == 0)
+    {
+        setup.simdLevel = GRASS_SIMD_SCALAR;
+    }
+    else if( strcmp( options.simdName, "avx512") == 0)
+    {
+        setup.simdLevel = GrassSimdDetect();
+    }
+
+    setup.threadCount = atoi( options.threadsName);
+    if( (strcmp( options.threadsName, "all") == 0) || (strcmp( options.threadsName, "scale") == 0))
+    {
+        setup.threadCount = 0;
+    }
+
+    setup.gridSize = CLAMP( options.gridSize, MIN_MESH_SIZE, MAX_MESH_SIZE);
+    setup.frameCount = MAX( options.frameCount, 1);
+
+    float *windTexels = LoadWindMap( options.windFileName, &windWidth, &windHeight);
+    if( windTexels == NULL)
+    {
+        fprintf( stderr, "Cannot load wind map \"%s\"\n", options.windFileName);
+        return( 1);
+    }
+
+    setup.windMap.width = windWidth;
+    setup.windMap.height = windHeight;
+    setup.windMap.texels = windTexels;
+
+    setup.floatWindBytes = (size_t)windWidth * windHeight * GRASS_COLOR_CHANNELS * sizeof(float);
+    setup.packedWindBytes = GrassGetPackedWindBytes( windWidth, windHeight);
+    unsigned char *packedWind = (unsigned char *) malloc( setup.packedWindBytes);
+    if( packedWind == NULL)
+    {
+        fprintf( stderr, "malloc() Failed\n");
+        return( 1);
+    }
+
+    setup.packedWindMap = setup.windMap;
+    GrassPackWindMap( &setup.packedWindMap, packedWind);
+
+    if( strcmp( options.windMapName, "rg8") == 0)
+    {
+        setup.windMap = setup.packedWindMap;
+    }
+    else if( strcmp( options.windMapName, "bilinear") == 0)
+    {
+        setup.windMap = setup.packedWindMap;
+        setup.windMap.bilinear = true;
+    }
+    else if( strcmp( options.windMapName, "procedural") == 0)
+    {
+        setup.windMap.procedural = true;
+    }
+
+    setup.meshVertexData = (VERTEX *) malloc( (size_t)setup.gridSize * setup.gridSize * sizeof(VERTEX));
+    if( setup.meshVertexData == NULL)
+    {
+        fprintf( stderr, "malloc() Failed\n");
+        return( 1);
+    }
+
+    CreateMesh( 0, 0, setup.gridSize, setup.gridSize, MESH_MULTIPLICANT, MESH_AMPLITUDE, setup.meshVertexData, HeightCalculate);
+
+        //NULL : GrassField computes the roots, see RunBench()
+    setup.rootVertices = (strcmp( options.rootsName, "grid") == 0) ? NULL : setup.meshVertexData;
+
+    setup.vertexCount = (size_t)setup.gridSize * setup.gridSize * 2 * GRASS_BLADE_SEGMENTS;
+    setup.grassVertex = AllocVertices( setup.vertexCount);
+    if( setup.grassVertex == NULL)
+    {
+        return( 1);
+    }
+
+    printf( "grid %d x %d, %d segments, %d frames, simd %s (supported %s), threads %s\n", setup.gridSize, setup.gridSize, GRASS_BLADE_SEGMENTS, setup.frameCount,
+        GrassSimdName( setup.simdLevel), GrassSimdName( GrassSimdDetect()), options.threadsName);
+
+    if( options.benchIndices && (BenchIndices( setup.gridSize, setup.meshVertexData) != 0))
+    {
+        return( 1);
+    }
+
+    if( strcmp( options.backendName, "compare") == 0)
+    {
+        status = BenchBackends( &options, &setup);
+    }
+    else if( strcmp( options.windMapName, "compare") == 0)
+    {
+        status = BenchWindMaps( &setup);
+    }
+    else if( options.benchCull || options.benchLod)
+    {
+        status = BenchCull( &options, &setup);
+    }
+    else if( strcmp( options.rootsName, "both") == 0)
+    {
+        status = BenchRoots( &setup);
+    }
+    else if( strcmp( options.threadsName, "scale") == 0)
+    {
+        status = BenchThreadScale( &setup);
+    }
+    else if( strcmp( options.simdName, "all") == 0)
+    {
+        status = BenchSimdLevels( &setup);
+    }
+    else
+    {
+        status = BenchLayouts( &options, &setup);
+    }
+
+    if( (status == 0) && (options.traceFileName != NULL))
+    {
+        status = WriteTrace( options.traceFileName);
+    }
+
+    free( setup.grassVertex);
+    free( setup.meshVertexData);
+    free( packedWind);
+    free( windTexels);
+
+    return( ( status == 0) ? 0 : 1);
+}
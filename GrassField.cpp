@@ -0,0 +1,1794 @@
+/*
+ * Headless grass blade generator (CPU path)
+ *
+ * Created By Vijaykumar Dangi
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include <atomic>
+#include <new>
+
+#include "GrassField.h"
+#include "GrassProfiler.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+extern FILE *gpLogFile;
+
+//one simulate() call, shared by all tiles
+typedef struct GRASS_TILE_JOB
+{
+    GrassField *field;
+    float time;
+    const GRASS_WIND_MAP *windMap;
+    GRASS_VERTEX *outVertices;
+} GRASS_TILE_JOB;
+
+
+//3x3 rotation in column major order, m[column][row]
+typedef struct GRASS_MAT3
+{
+    float m[3][3];
+} GRASS_MAT3;
+
+//
+//Mat3Multiply() :- a * b
+//
+static inline GRASS_MAT3 Mat3Multiply( const GRASS_MAT3 &a, const GRASS_MAT3 &b)
+{
+    //variable declarations
+    GRASS_MAT3 r;
+
+    //code
+    for( int j = 0; j < 3; j++)
+    {
+        r.m[j][0] = a.m[0][0] * b.m[j][0] + a.m[1][0] * b.m[j][1] + a.m[2][0] * b.m[j][2];
+        r.m[j][1] = a.m[0][1] * b.m[j][0] + a.m[1][1] * b.m[j][1] + a.m[2][1] * b.m[j][2];
+        r.m[j][2] = a.m[0][2] * b.m[j][0] + a.m[1][2] * b.m[j][1] + a.m[2][2] * b.m[j][2];
+    }
+
+    return( r);
+}
+
+//
+//Mat3Rotation() :- same layout as RotationMatrix(), from precomputed sin/cos
+//
+static inline GRASS_MAT3 Mat3Rotation( float s, float c, float x, float y, float z)
+{
+    //variable declarations
+    GRASS_MAT3 r;
+    float t = 1.0f - c;
+
+    //code
+    r.m[0][0] = x*x*t + c;      r.m[0][1] = y*x*t + z*s;    r.m[0][2] = x*z*t - y*s;
+    r.m[1][0] = x*y*t - z*s;    r.m[1][1] = y*y*t + c;      r.m[1][2] = y*z*t + x*s;
+    r.m[2][0] = x*z*t + y*s;    r.m[2][1] = y*z*t - x*s;    r.m[2][2] = z*z*t + c;
+
+    return( r);
+}
+
+
+//
+//GrassField()
+//
+GrassField::GrassField( GRASS_LAYOUT layout)
+{
+    //code
+    this->layout = layout;
+    this->simdLevel = GrassSimdDefault();
+
+    this->meshWidth = 0;
+    this->meshHeight = 0;
+    this->bladeCount = 0;
+    this->bladeCapacity = 0;
+
+        //threads are started on first simulate(), not when a global GrassField is constructed
+    this->pool = NULL;
+    this->threadCount = 1;
+
+    this->tiles = NULL;
+    this->tileNodes = NULL;
+    this->tileVisible = NULL;
+    this->visibleTiles = NULL;
+    this->tilesX = 0;
+    this->tilesZ = 0;
+    this->tileCount = 0;
+    this->tileCapacity = 0;
+    this->visibleTileCount = 0;
+    this->visibleBladeCount = 0;
+    this->outputVertexCount = 0;
+    this->outputIndexCount = 0;
+    memset( this->levelBlades, 0, sizeof( this->levelBlades));
+
+    this->tileSlots = NULL;
+    this->tileSegments = NULL;
+    this->tileUpdateFrames = NULL;
+    this->visibleDistances = NULL;
+    this->scheduleEntries = NULL;
+    this->updateTiles = NULL;
+    this->updateTileCount = 0;
+    this->updateBladeCount = 0;
+    this->scheduleFrame = 0;
+    this->slotLayout = false;
+    this->scheduleVisibleBlades = 0;
+    this->scheduleUpdateBlades = 0;
+
+    this->nodes = NULL;
+    this->nodeCount = 0;
+
+    this->meshVertices = NULL;
+    this->staticProps = NULL;
+    this->bladeStorage = NULL;
+    memset( &this->blades, 0, sizeof( this->blades));
+}
+
+//
+//~GrassField()
+//
+GrassField::~GrassField()
+{
+    //code
+    if( this->staticProps)
+    {
+        delete[] this->staticProps;
+        this->staticProps = NULL;
+    }
+
+    if( this->bladeStorage)
+    {
+        free( this->bladeStorage);
+        this->bladeStorage = NULL;
+    }
+
+    free( this->tiles);
+    free( this->tileNodes);
+    free( this->tileVisible);
+    free( this->visibleTiles);
+    free( this->tileSlots);
+    free( this->tileSegments);
+    free( this->tileUpdateFrames);
+    free( this->visibleDistances);
+    free( this->scheduleEntries);
+    free( this->updateTiles);
+    free( this->nodes);
+    this->tiles = NULL;
+    this->tileNodes = NULL;
+    this->tileVisible = NULL;
+    this->visibleTiles = NULL;
+    this->tileSlots = NULL;
+    this->tileSegments = NULL;
+    this->tileUpdateFrames = NULL;
+    this->visibleDistances = NULL;
+    this->scheduleEntries = NULL;
+    this->updateTiles = NULL;
+    this->nodes = NULL;
+
+    if( this->pool)
+    {
+        delete this->pool;
+        this->pool = NULL;
+    }
+}
+
+//
+//getStaticBytesPerBlade()
+//
+size_t GrassField::getStaticBytesPerBlade( void) const
+{
+    //code
+    if( this->layout == GRASS_LAYOUT_MAT4)
+    {
+        return( sizeof( GRASS_STATIC_PROPERTIES));
+    }
+
+    return( 6 * sizeof( float));
+}
+
+//
+//setSimdLevel()
+//
+void GrassField::setSimdLevel( GRASS_SIMD_LEVEL level)
+{
+    //code
+    GRASS_SIMD_LEVEL supported = GrassSimdDetect();
+
+    this->simdLevel = (level > supported) ? supported : level;
+}
+
+//
+//setThreadCount()
+//
+void GrassField::setThreadCount( int threadCount)
+{
+    //code
+    if( this->pool && ( threadCount == this->threadCount))
+    {
+        return;
+    }
+
+    if( this->pool)
+    {
+        delete this->pool;
+        this->pool = NULL;
+    }
+
+    this->threadCount = threadCount;
+    this->pool = new GrassThreadPool( threadCount);
+}
+
+//
+//resize()
+//
+int GrassField::resize( int meshWidth, int meshHeight, const VERTEX *meshVertices)
+{
+    //code
+    memset( &this->grid, 0, sizeof( this->grid));
+    this->grid.width = meshWidth;
+    this->grid.height = meshHeight;
+    this->meshVertices = meshVertices;
+
+    return( rebuild());
+}
+
+//
+//resize() :- procedural grid
+//
+int GrassField::resize( const GRASS_GRID *grid)
+{
+    //code
+    this->grid = *grid;
+    this->meshVertices = NULL;
+
+    return( rebuild());
+}
+
+//
+//rebuild() :- static properties for this->grid / this->meshVertices
+//
+int GrassField::rebuild( void)
+{
+    //code
+    GRASS_PROFILE_SCOPE( "static props");
+
+    int meshWidth = this->grid.width;
+    int meshHeight = this->grid.height;
+    int newBladeCount = meshWidth * meshHeight;
+    int newCapacity = GrassReserveCapacity( this->bladeCapacity, newBladeCount);
+
+    if( newCapacity != this->bladeCapacity)
+    {
+        if( this->layout == GRASS_LAYOUT_MAT4)
+        {
+                //vmath::mat4 members, constructed by new[] and not moved with realloc(), content is rebuilt below
+            GRASS_STATIC_PROPERTIES *newProps = new (std::nothrow) GRASS_STATIC_PROPERTIES[ newCapacity];
+            if( newProps == NULL)
+            {
+                return(-1);
+            }
+
+            delete[] this->staticProps;
+            this->staticProps = newProps;
+        }
+        else
+        {
+                //SoA arrays are rebuilt below, no need to keep old content
+            free( this->bladeStorage);
+            this->bladeStorage = (float *) malloc( (size_t)newCapacity * 6 * sizeof( float));
+            if( this->bladeStorage == NULL)
+            {
+                memset( &this->blades, 0, sizeof( this->blades));
+                this->bladeCapacity = 0;
+                this->bladeCount = 0;
+                return(-1);
+            }
+
+            this->blades.facingSin = this->bladeStorage + 0 * (size_t)newCapacity;
+            this->blades.facingCos = this->bladeStorage + 1 * (size_t)newCapacity;
+            this->blades.bendSin   = this->bladeStorage + 2 * (size_t)newCapacity;
+            this->blades.width     = this->bladeStorage + 3 * (size_t)newCapacity;
+            this->blades.height    = this->bladeStorage + 4 * (size_t)newCapacity;
+            this->blades.forward   = this->bladeStorage + 5 * (size_t)newCapacity;
+        }
+
+        this->bladeCapacity = newCapacity;
+    }
+
+    this->meshWidth = meshWidth;
+    this->meshHeight = meshHeight;
+    this->bladeCount = newBladeCount;
+
+    //Update grass static properties        //static means the properties which are not changing
+        //drawn from the blade grid index, not the root position, so grass_kernel draws the same values
+    for( int i = 0; i < this->bladeCount; i++)
+    {
+        //random rotation of vertex but consistent between frames
+        float facingAngle = GrassRandom( i, GRASS_RANDOM_FACING) * mymath::TWO_PI;
+
+        //rotate grass along X-axis
+        float bendAngle = GrassRandom( i, GRASS_RANDOM_BEND) * params.bendRotationRandom * mymath::PI * 0.5f;
+
+        //blade width and height
+        float width  = ( GrassRandom( i, GRASS_RANDOM_WIDTH) * 2.0f - 1.0f) * params.bladeWidthRandom + params.bladeWidth;
+        float height = ( GrassRandom( i, GRASS_RANDOM_HEIGHT) * 2.0f - 1.0f) * params.bladeHeightRandom + params.bladeHeight;
+
+        //for curvature of grass we add Y-offset in each vertex. ( Y-offset in tangent space)
+        float forward = GrassRandom( i, GRASS_RANDOM_FORWARD) * params.bladeForwardAmount;
+
+        if( this->layout == GRASS_LAYOUT_MAT4)
+        {
+            float rootPosition[3], rootNormal[3], rootTangent[3];
+            getBladeRoot( i, rootPosition, rootNormal, rootTangent);
+
+            vmath::vec3 normal( rootNormal[0], rootNormal[1], rootNormal[2]);
+            vmath::vec3 tangent( rootTangent[0], rootTangent[1], rootTangent[2]);
+
+            vmath::vec3 biNormal = vmath::cross( normal, tangent);
+
+            this->staticProps[i].tangentToLocalMatrix = vmath::mat4(
+                vmath::vec4( tangent[0],  tangent[1],  tangent[2],  0.0f),
+                vmath::vec4( biNormal[0], biNormal[1], biNormal[2], 0.0f),
+                vmath::vec4( normal[0],   normal[1],   normal[2],   0.0f),
+                vmath::vec4( 0.0f, 0.0f, 0.0f, 1.0f)
+            );
+
+            this->staticProps[i].facingRotationMatrix = RotationMatrix( facingAngle, 0.0f, 0.0f, 1.0f);
+            this->staticProps[i].bendRotationMatrix = RotationMatrix( bendAngle, -1.0f, 0.0f, 0.0f);
+
+            this->staticProps[i].width = width;
+            this->staticProps[i].height = height;
+            this->staticProps[i].forward = forward;
+        }
+        else
+        {
+            this->blades.facingSin[i] = sinf( facingAngle);
+            this->blades.facingCos[i] = cosf( facingAngle);
+            this->blades.bendSin[i] = sinf( bendAngle);
+            this->blades.width[i] = width;
+            this->blades.height[i] = height;
+            this->blades.forward[i] = forward;
+        }
+    }
+
+    return( rebuildTiles());
+}
+
+//
+//rebuildTiles() :- GRASS_TILE_SIZE tiles and their quadtree, everything visible until the next cull()
+//
+int GrassField::rebuildTiles( void)
+{
+    //code
+    this->tilesX = ( this->meshWidth + GRASS_TILE_SIZE - 1) / GRASS_TILE_SIZE;
+    this->tilesZ = ( this->meshHeight + GRASS_TILE_SIZE - 1) / GRASS_TILE_SIZE;
+    this->tileCount = this->tilesX * this->tilesZ;
+    this->nodeCount = 0;
+
+    if( this->tileCount > this->tileCapacity)
+    {
+        free( this->tiles);
+        free( this->tileNodes);
+        free( this->tileVisible);
+        free( this->visibleTiles);
+        free( this->tileSlots);
+        free( this->tileSegments);
+        free( this->tileUpdateFrames);
+        free( this->visibleDistances);
+        free( this->scheduleEntries);
+        free( this->updateTiles);
+        free( this->nodes);
+
+            //every inner node has at least 2 children, so less than 2 nodes per tile
+        this->tiles = (GRASS_TILE *) malloc( this->tileCount * sizeof( GRASS_TILE));
+        this->tileVisible = (unsigned char *) malloc( this->tileCount * sizeof( unsigned char));
+        this->tileNodes = (int *) malloc( this->tileCount * sizeof( int));
+        this->visibleTiles = (GRASS_LOD_TILE *) malloc( this->tileCount * sizeof( GRASS_LOD_TILE));
+        this->tileSlots = (int *) malloc( this->tileCount * sizeof( int));
+        this->tileSegments = (int *) malloc( this->tileCount * sizeof( int));
+        this->tileUpdateFrames = (int *) malloc( this->tileCount * sizeof( int));
+        this->visibleDistances = (float *) malloc( this->tileCount * sizeof( float));
+        this->scheduleEntries = (GRASS_SCHEDULE_ENTRY *) malloc( this->tileCount * sizeof( GRASS_SCHEDULE_ENTRY));
+        this->updateTiles = (GRASS_LOD_TILE *) malloc( this->tileCount * sizeof( GRASS_LOD_TILE));
+        this->nodes = (GRASS_CULL_NODE *) malloc( 2 * this->tileCount * sizeof( GRASS_CULL_NODE));
+
+        if( (this->tiles == NULL) || (this->tileNodes == NULL) || (this->tileVisible == NULL) || (this->visibleTiles == NULL) ||
+            (this->tileSlots == NULL) || (this->tileSegments == NULL) || (this->tileUpdateFrames == NULL) || (this->visibleDistances == NULL) || (this->scheduleEntries == NULL) || (this->updateTiles == NULL) ||
+            (this->nodes == NULL))
+        {
+            this->tileCapacity = 0;
+            this->tileCount = 0;
+            this->visibleTileCount = 0;
+            this->visibleBladeCount = 0;
+            this->outputVertexCount = 0;
+            this->outputIndexCount = 0;
+            this->updateTileCount = 0;
+            this->updateBladeCount = 0;
+            return(-1);
+        }
+
+        this->tileCapacity = this->tileCount;
+    }
+
+    for( int tz = 0; tz < this->tilesZ; tz++)
+    {
+        for( int tx = 0; tx < this->tilesX; tx++)
+        {
+            GRASS_TILE *tile = &this->tiles[ tz * this->tilesX + tx];
+
+            tile->x = tx * GRASS_TILE_SIZE;
+            tile->z = tz * GRASS_TILE_SIZE;
+            tile->width = MIN( GRASS_TILE_SIZE, this->meshWidth - tile->x);
+            tile->height = MIN( GRASS_TILE_SIZE, this->meshHeight - tile->z);
+        }
+    }
+
+        //slot of every tile at level 0, the whole output buffer
+    int slot = 0;
+    for( int i = 0; i < this->tileCount; i++)
+    {
+        this->tileSlots[i] = slot;
+        slot += this->tiles[i].width * this->tiles[i].height * 2 * params.segments;
+    }
+
+    invalidateSchedule();
+
+    if( this->tileCount > 0)
+    {
+        buildNode( 0, 0, this->tilesX, this->tilesZ);
+    }
+
+    cull( NULL, NULL);
+
+    return(0);
+}
+
+//
+//buildNode() :- quadtree node over tiles [tileX0, tileX1) x [tileZ0, tileZ1), return node index
+//
+int GrassField::buildNode( int tileX0, int tileZ0, int tileX1, int tileZ1)
+{
+    //code
+    int index = this->nodeCount++;
+    GRASS_CULL_NODE *node = &this->nodes[ index];
+
+    node->child[0] = node->child[1] = node->child[2] = node->child[3] = -1;
+    node->tile = -1;
+
+    if( (tileX1 - tileX0 == 1) && (tileZ1 - tileZ0 == 1))
+    {
+        node->tile = tileZ0 * this->tilesX + tileX0;
+        this->tileNodes[ node->tile] = index;
+        const GRASS_TILE *tile = &this->tiles[ node->tile];
+
+        node->boundsMin[0] = node->boundsMin[1] = node->boundsMin[2] = FLT_MAX;
+        node->boundsMax[0] = node->boundsMax[1] = node->boundsMax[2] = -FLT_MAX;
+
+        for( int z = tile->z; z < tile->z + tile->height; z++)
+        {
+            for( int x = tile->x; x < tile->x + tile->width; x++)
+            {
+                float position[3], normal[3], tangent[3];
+                getBladeRoot( z * this->meshWidth + x, position, normal, tangent);
+
+                for( int k = 0; k < 3; k++)
+                {
+                    node->boundsMin[k] = MIN( node->boundsMin[k], position[k]);
+                    node->boundsMax[k] = MAX( node->boundsMax[k], position[k]);
+                }
+            }
+        }
+
+            //a blade vertex is at most width + forward + height away from its root, whatever the wind does
+        float reach = ( params.bladeWidth + params.bladeWidthRandom) + params.bladeForwardAmount + ( params.bladeHeight + params.bladeHeightRandom);
+        for( int k = 0; k < 3; k++)
+        {
+            node->boundsMin[k] -= reach;
+            node->boundsMax[k] += reach;
+        }
+
+        return( index);
+    }
+
+    int tileXm = tileX0 + ( tileX1 - tileX0 + 1) / 2;
+    int tileZm = tileZ0 + ( tileZ1 - tileZ0 + 1) / 2;
+
+    int ranges[4][4] =
+    {
+        { tileX0, tileZ0, tileXm, tileZm},
+        { tileXm, tileZ0, tileX1, tileZm},
+        { tileX0, tileZm, tileXm, tileZ1},
+        { tileXm, tileZm, tileX1, tileZ1}
+    };
+
+    float boundsMin[3] = { FLT_MAX, FLT_MAX, FLT_MAX};
+    float boundsMax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX};
+
+    for( int c = 0; c < 4; c++)
+    {
+        if( (ranges[c][0] >= ranges[c][2]) || (ranges[c][1] >= ranges[c][3]))
+        {
+            continue;       //odd tile count, one half is empty
+        }
+
+        int child = buildNode( ranges[c][0], ranges[c][1], ranges[c][2], ranges[c][3]);
+        this->nodes[ index].child[c] = child;
+
+        for( int k = 0; k < 3; k++)
+        {
+            boundsMin[k] = MIN( boundsMin[k], this->nodes[ child].boundsMin[k]);
+            boundsMax[k] = MAX( boundsMax[k], this->nodes[ child].boundsMax[k]);
+        }
+    }
+
+    memcpy( this->nodes[ index].boundsMin, boundsMin, sizeof( boundsMin));
+    memcpy( this->nodes[ index].boundsMax, boundsMax, sizeof( boundsMax));
+
+    return( index);
+}
+
+//
+//cull()
+//
+int GrassField::cull( const vmath::mat4 *viewProjection, const vmath::vec3 *eye)
+{
+    //variable declarations
+    float planes[6][4];
+
+    //code
+    GRASS_PROFILE_SCOPE( "cull");
+
+    memset( this->tileVisible, ( viewProjection == NULL) ? 1 : 0, this->tileCount * sizeof( unsigned char));
+
+    if( (viewProjection != NULL) && (this->nodeCount > 0))
+    {
+        const vmath::mat4 &m = *viewProjection;
+
+            //clip space planes from the rows of the matrix, m[column][row] ( Gribb / Hartmann)
+        for( int k = 0; k < 4; k++)
+        {
+            planes[0][k] = m[k][3] + m[k][0];     //left
+            planes[1][k] = m[k][3] - m[k][0];     //right
+            planes[2][k] = m[k][3] + m[k][1];     //bottom
+            planes[3][k] = m[k][3] - m[k][1];     //top
+            planes[4][k] = m[k][3] + m[k][2];     //near
+            planes[5][k] = m[k][3] - m[k][2];     //far
+        }
+
+        cullNode( 0, planes, false);
+    }
+
+        //slots of skipped tiles must not move, their vertices are from an earlier frame
+    if( this->slotLayout != schedule.enabled)
+    {
+        this->slotLayout = schedule.enabled;
+        invalidateSchedule();
+    }
+
+        //row major, neighbouring tiles stay on the same thread and in the same draw
+        //output offsets are the prefix sum of the vertices of the visible tiles, or the tile slots
+    this->visibleTileCount = 0;
+    this->visibleBladeCount = 0;
+    this->outputVertexCount = 0;
+    this->outputIndexCount = 0;
+    memset( this->levelBlades, 0, sizeof( this->levelBlades));
+
+    for( int i = 0; i < this->tileCount; i++)
+    {
+        if( !this->tileVisible[i])
+        {
+            continue;
+        }
+
+        float distance = ( eye != NULL) ? getTileDistance( i, eye) : 0.0f;
+
+        this->visibleDistances[ this->visibleTileCount] = distance;
+        GRASS_LOD_TILE *lodTile = &this->visibleTiles[ this->visibleTileCount++];
+        selectLod( i, distance, lodTile);
+
+        int blades = lodTile->width * lodTile->height;
+
+        lodTile->firstVertex = this->slotLayout ? this->tileSlots[i] : this->outputVertexCount;
+        this->outputVertexCount += blades * 2 * lodTile->segments;
+        this->outputIndexCount += blades * 6 * ( lodTile->segments - 1);
+        this->visibleBladeCount += blades;
+        this->levelBlades[ lodTile->level] += blades;
+    }
+
+        //everything visible until scheduleUpdates() says otherwise
+    memcpy( this->updateTiles, this->visibleTiles, this->visibleTileCount * sizeof( GRASS_LOD_TILE));
+    this->updateTileCount = this->visibleTileCount;
+    this->updateBladeCount = this->visibleBladeCount;
+
+    return( this->visibleBladeCount);
+}
+
+//
+//cullNode() :- 'inside' : parent is inside all planes, children need no test
+//
+void GrassField::cullNode( int node, const float planes[6][4], bool inside)
+{
+    //code
+    const GRASS_CULL_NODE *n = &this->nodes[ node];
+
+    if( !inside)
+    {
+        inside = true;
+
+        for( int p = 0; p < 6; p++)
+        {
+            const float *plane = planes[p];
+
+                //corner furthest along the plane normal, then the nearest one
+            float farthest = plane[3], nearest = plane[3];
+            for( int k = 0; k < 3; k++)
+            {
+                farthest += plane[k] * ( (plane[k] >= 0.0f) ? n->boundsMax[k] : n->boundsMin[k]);
+                nearest  += plane[k] * ( (plane[k] >= 0.0f) ? n->boundsMin[k] : n->boundsMax[k]);
+            }
+
+            if( farthest < 0.0f)
+            {
+                return;         //outside this plane
+            }
+
+            if( nearest < 0.0f)
+            {
+                inside = false; //straddles this plane
+            }
+        }
+    }
+
+    if( n->tile >= 0)
+    {
+        this->tileVisible[ n->tile] = 1;
+        return;
+    }
+
+    for( int c = 0; c < 4; c++)
+    {
+        if( n->child[c] >= 0)
+        {
+            cullNode( n->child[c], planes, inside);
+        }
+    }
+}
+
+//
+//getLevelSegments()
+//
+int GrassField::getLevelSegments( int level) const
+{
+    //code
+    if( level <= 0)
+    {
+        return( params.segments);
+    }
+
+        //2 rows of vertices is the least that still makes a quad
+    return( CLAMP( lod.segments[ MIN( level, GRASS_LOD_LEVELS - 1)], 2, params.segments));
+}
+
+//
+//getTileDistance() :- from 'eye' to the nearest point of the bounds of 'tile', 0 inside
+//
+float GrassField::getTileDistance( int tile, const vmath::vec3 *eye) const
+{
+    //code
+    const GRASS_CULL_NODE *node = &this->nodes[ this->tileNodes[ tile]];
+
+    float distanceSquared = 0.0f;
+    for( int k = 0; k < 3; k++)
+    {
+        float d = MAX( MAX( node->boundsMin[k] - (*eye)[k], (*eye)[k] - node->boundsMax[k]), 0.0f);
+        distanceSquared += d * d;
+    }
+
+    return( sqrtf( distanceSquared));
+}
+
+//
+//selectLod() :- level of 'tile' from its distance to the eye, rectangle and output size are filled by cull()
+//
+void GrassField::selectLod( int tile, float distance, GRASS_LOD_TILE *lodTile) const
+{
+    //code
+    const GRASS_TILE *t = &this->tiles[ tile];
+
+    lodTile->x = t->x;
+    lodTile->z = t->z;
+    lodTile->width = t->width;
+    lodTile->height = t->height;
+    lodTile->level = 0;
+    lodTile->morph = 0.0f;
+
+    int levels = CLAMP( lod.levels, 1, GRASS_LOD_LEVELS);
+
+    if( levels > 1)
+    {
+        while( (lodTile->level < levels - 1) && (distance > lod.distance[ lodTile->level]))
+        {
+            lodTile->level++;
+        }
+
+            //last part of the band blends into the next level, which takes over at the far end with the same shape
+        if( lodTile->level < levels - 1)
+        {
+            float bandBegin = ( lodTile->level == 0) ? 0.0f : lod.distance[ lodTile->level - 1];
+            float bandEnd = lod.distance[ lodTile->level];
+            float morphLength = lod.morphRange * ( bandEnd - bandBegin);
+
+            if( morphLength > 0.0f)
+            {
+                lodTile->morph = CLAMP( ( distance - ( bandEnd - morphLength)) / morphLength, 0.0f, 1.0f);
+            }
+        }
+    }
+
+    lodTile->segments = getLevelSegments( lodTile->level);
+    lodTile->coarseSegments = ( lodTile->level < levels - 1) ? getLevelSegments( lodTile->level + 1) : lodTile->segments;
+}
+
+//
+//fillSegmentTable()
+//
+void GrassField::fillSegmentTable( const GRASS_LOD_TILE *tile, float *segmentT, float *segmentCurve) const
+{
+    //code
+    float curvePower = 2.0f * params.bladeCurvatureAmount;
+
+    for( int j = 0; j < tile->segments; j++)
+    {
+        segmentT[j] = (float)j / (float)(tile->segments - 1);
+        segmentCurve[j] = powf( segmentT[j], curvePower);
+    }
+
+    if( tile->morph <= 0.0f)
+    {
+        return;
+    }
+
+        //width and height are linear in t, only the forward curve differs between levels :
+        //move it towards the coarse level's piecewise linear curve, at morph 1 both blades have the same shape
+    int coarseSpans = tile->coarseSegments - 1;
+
+    for( int j = 0; j < tile->segments; j++)
+    {
+        float u = segmentT[j] * coarseSpans;
+        int k = MIN( (int)u, coarseSpans - 1);
+
+        float c0 = powf( (float)k / coarseSpans, curvePower);
+        float c1 = powf( (float)( k + 1) / coarseSpans, curvePower);
+        float coarseCurve = c0 + ( c1 - c0) * ( u - k);
+
+        segmentCurve[j] = segmentCurve[j] + ( coarseCurve - segmentCurve[j]) * tile->morph;
+    }
+}
+
+//
+//CompareScheduleEntries() :- qsort(), highest priority first
+//
+static int CompareScheduleEntries( const void *a, const void *b)
+{
+    //code
+    float pa = ((const GRASS_SCHEDULE_ENTRY *) a)->priority;
+    float pb = ((const GRASS_SCHEDULE_ENTRY *) b)->priority;
+
+    return( (pa < pb) - (pa > pb));
+}
+
+//
+//scheduleUpdates()
+//
+int GrassField::scheduleUpdates( float pixelScale)
+{
+    //code
+    GRASS_PROFILE_SCOPE( "schedule");
+
+    this->scheduleFrame++;
+
+    if( this->slotLayout)
+    {
+        int entryCount = 0;
+
+        for( int v = 0; v < this->visibleTileCount; v++)
+        {
+            const GRASS_LOD_TILE *lodTile = &this->visibleTiles[v];
+            int tile = ( lodTile->z / GRASS_TILE_SIZE) * this->tilesX + lodTile->x / GRASS_TILE_SIZE;
+
+            GRASS_SCHEDULE_ENTRY *entry = &this->scheduleEntries[ entryCount];
+            entry->visible = v;
+
+            if( this->tileSegments[ tile] != lodTile->segments)
+            {
+                entry->priority = FLT_MAX;      //new in view, new level or lost buffer
+                entryCount++;
+                continue;
+            }
+
+                //halve the rate each time the projected blade height halves below fullRatePixels
+            int period = 1;
+            float distance = this->visibleDistances[v];
+
+            if( (pixelScale > 0.0f) && (distance > 0.0f))
+            {
+                float pixels = params.bladeHeight * pixelScale / distance;
+
+                while( (period * 2 <= schedule.maxPeriod) && (pixels * period * 2 <= schedule.fullRatePixels))
+                {
+                    period *= 2;
+                }
+            }
+
+            int age = this->scheduleFrame - this->tileUpdateFrames[ tile];
+            if( age >= period)
+            {
+                entry->priority = (float)age / period;
+                entryCount++;
+            }
+        }
+
+        qsort( this->scheduleEntries, entryCount, sizeof( GRASS_SCHEDULE_ENTRY), CompareScheduleEntries);
+
+            //most overdue first while the budget lasts, tiles without valid vertices regardless of it
+        int blades = 0;
+        for( int e = 0; e < entryCount; e++)
+        {
+            const GRASS_LOD_TILE *lodTile = &this->visibleTiles[ this->scheduleEntries[e].visible];
+            int tileBlades = lodTile->width * lodTile->height;
+
+            if( (this->scheduleEntries[e].priority != FLT_MAX) && (schedule.bladeBudget > 0) && (blades + tileBlades > schedule.bladeBudget))
+            {
+                continue;
+            }
+
+            int tile = ( lodTile->z / GRASS_TILE_SIZE) * this->tilesX + lodTile->x / GRASS_TILE_SIZE;
+            this->tileSegments[ tile] = lodTile->segments;
+            this->tileUpdateFrames[ tile] = this->scheduleFrame;
+            blades += tileBlades;
+        }
+
+            //back in output order
+        this->updateTileCount = 0;
+        this->updateBladeCount = 0;
+
+        for( int v = 0; v < this->visibleTileCount; v++)
+        {
+            const GRASS_LOD_TILE *lodTile = &this->visibleTiles[v];
+            int tile = ( lodTile->z / GRASS_TILE_SIZE) * this->tilesX + lodTile->x / GRASS_TILE_SIZE;
+
+            if( this->tileUpdateFrames[ tile] == this->scheduleFrame)
+            {
+                this->updateTiles[ this->updateTileCount++] = *lodTile;
+                this->updateBladeCount += lodTile->width * lodTile->height;
+            }
+        }
+    }
+
+    this->scheduleVisibleBlades += this->visibleBladeCount;
+    this->scheduleUpdateBlades += this->updateBladeCount;
+
+    return( this->updateBladeCount);
+}
+
+//
+//invalidateSchedule()
+//
+void GrassField::invalidateSchedule( void)
+{
+    //code
+    if( this->tileSegments != NULL)
+    {
+        memset( this->tileSegments, 0, this->tileCount * sizeof( int));
+        memset( this->tileUpdateFrames, 0, this->tileCount * sizeof( int));
+    }
+}
+
+//
+//simulate()
+//
+int GrassField::simulate( float time, const GRASS_WIND_MAP *windMap, GRASS_VERTEX *outVertices, size_t outVertexCount)
+{
+    //code
+    GRASS_PROFILE_SCOPE( "simulate");
+
+    if( (outVertices == NULL) || (windMap == NULL) || ( (windMap->texels == NULL) && (windMap->packed == NULL) && !windMap->procedural))
+    {
+        return(0);
+    }
+
+    if( params.segments > GRASS_MAX_BLADE_SEGMENTS)
+    {
+        return(0);
+    }
+
+        //whole tiles only, outputs are in increasing order
+    int tiles = this->updateTileCount;
+    while( tiles > 0)
+    {
+        const GRASS_LOD_TILE *last = &this->updateTiles[ tiles - 1];
+        if( (size_t)last->firstVertex + (size_t)last->width * last->height * 2 * last->segments <= outVertexCount)
+        {
+            break;
+        }
+
+        tiles--;
+    }
+
+    if( this->pool == NULL)
+    {
+        this->pool = new GrassThreadPool( this->threadCount);
+    }
+
+    GRASS_TILE_JOB job;
+    job.field = this;
+    job.time = time;
+    job.windMap = windMap;
+    job.outVertices = outVertices;
+
+    this->pool->run( tiles, simulateTile, &job);
+
+    int written = this->updateBladeCount;
+    if( tiles != this->updateTileCount)
+    {
+        written = 0;
+        for( int i = 0; i < tiles; i++)
+        {
+            written += this->updateTiles[i].width * this->updateTiles[i].height;
+        }
+    }
+
+    return( written);
+}
+
+//
+//simulateTile() :- pool task, one update tile
+//
+void GrassField::simulateTile( void *context, int task)
+{
+    //code
+    const GRASS_TILE_JOB *job = (const GRASS_TILE_JOB *) context;
+    GrassField *field = job->field;
+    const GRASS_LOD_TILE *tile = &field->updateTiles[ task];
+
+    if( field->layout == GRASS_LAYOUT_MAT4)
+    {
+        field->simulateMat4( job->time, job->windMap, tile, job->outVertices);
+    }
+    else
+    {
+        field->simulateCompact( job->time, job->windMap, tile, job->outVertices);
+    }
+}
+
+//
+//simulateMat4() :- reference path, full mat4 per blade
+//
+void GrassField::simulateMat4( float time, const GRASS_WIND_MAP *windMap, const GRASS_LOD_TILE *tile, GRASS_VERTEX *outVertices)
+{
+    //variable declarations
+    int i, j;
+    float t;
+    float segmentHeight, segmentWidth, segmentForward;
+
+    vmath::vec4 tangentPoint;
+    vmath::vec4 localPosition;
+    vmath::vec4 tangentNormal;
+    vmath::vec4 localNormal;
+
+    vmath::mat4 transformationMatrix;
+    vmath::mat4 baseTransformationMatrix;
+    vmath::mat4 windRotationMatrix;
+
+    vmath::vec2 uv;
+    vmath::vec4 color;
+    vmath::vec2 windSample;
+    vmath::vec3 windDirection;
+
+    int index;
+    int segments = tile->segments;
+    int verticesPerBlade = 2 * segments;
+
+    float segmentT[ GRASS_MAX_BLADE_SEGMENTS];
+    float segmentCurve[ GRASS_MAX_BLADE_SEGMENTS];
+
+    //code
+    fillSegmentTable( tile, segmentT, segmentCurve);
+
+    vmath::vec2 windParam = params.windOffset + params.windFrequency * time;
+
+    int bladeCount = tile->width * tile->height;
+
+    for( int b = 0; b < bladeCount; b++)        // grass position, row by row inside the tile
+    {
+        i = ( tile->z + b / tile->width) * this->meshWidth + tile->x + b % tile->width;
+
+        float pos[3], normal[3], tangent[3];
+        getBladeRoot( i, pos, normal, tangent);
+
+        const GRASS_STATIC_PROPERTIES *props = &this->staticProps[i];
+
+        // //ADD WIND
+        if( windMap->procedural)
+        {
+            color = vmath::vec4( 0.0f);
+            GrassSampleProceduralWind( &windMap->model, pos[0], pos[2], time, &color[0], &color[1]);
+        }
+        else
+        {
+            uv = vmath::vec2( pos[0], pos[2]) * params.windScale + windParam;
+            color = getTexel( uv, windMap);
+        }
+
+        windSample = ( (vmath::vec2( color[0], color[1]) * 2.0f) - 1.0f) * params.windStrength;
+            //normalize vector representing direction
+        windDirection = vmath::normalize( vmath::vec3( windSample[0], windSample[1], 0.0f));
+            //construct matrix to rotate above vector
+        windRotationMatrix = RotationMatrix( mymath::PI * windSample[0], windDirection[0], windDirection[1], windDirection[2]);
+
+            //for base vertices, we don't want to bend or rotate base vertices
+        baseTransformationMatrix = props->tangentToLocalMatrix * props->facingRotationMatrix;
+
+            //for vertices other than base  vertices, as we want them to move with wind
+        transformationMatrix = props->tangentToLocalMatrix * windRotationMatrix * props->facingRotationMatrix * props->bendRotationMatrix;
+
+        for( j = 0; j < segments; j++)      //vertices of single grass blade
+        {
+            const vmath::mat4 &M = (j == 0) ? baseTransformationMatrix : transformationMatrix;     //don't bend base vertices
+
+            index = tile->firstVertex + verticesPerBlade * b + 2*j;
+
+            t = segmentT[j];
+
+            segmentWidth = props->width * ( 1 - t);
+            segmentHeight = props->height * t;
+            segmentForward = segmentCurve[j] * props->forward;
+
+            tangentNormal = vmath::vec4( 0.0f, -1.0f, segmentForward, 0.0f);
+            localNormal = M * tangentNormal;
+
+                //////////////////////////////////////////
+            tangentPoint = vmath::vec4( segmentWidth, segmentForward, segmentHeight, 0.0f);
+            localPosition = M * tangentPoint;
+
+            outVertices[index + 0].position[0] = localPosition[0] + pos[0];
+            outVertices[index + 0].position[1] = localPosition[1] + pos[1];
+            outVertices[index + 0].position[2] = localPosition[2] + pos[2];
+
+            outVertices[index + 0].normal[0] = localNormal[0];
+            outVertices[index + 0].normal[1] = localNormal[1];
+            outVertices[index + 0].normal[2] = localNormal[2];
+
+            outVertices[index + 0].texcoord[0] = 0.0f;
+            outVertices[index + 0].texcoord[1] = t;
+
+                //////////////////////////////////////////
+            tangentPoint = vmath::vec4( -segmentWidth, segmentForward, segmentHeight, 0.0f);
+            localPosition = M * tangentPoint;
+
+            outVertices[index + 1].position[0] = localPosition[0] + pos[0];
+            outVertices[index + 1].position[1] = localPosition[1] + pos[1];
+            outVertices[index + 1].position[2] = localPosition[2] + pos[2];
+
+            outVertices[index + 1].normal[0] = localNormal[0];
+            outVertices[index + 1].normal[1] = localNormal[1];
+            outVertices[index + 1].normal[2] = localNormal[2];
+
+            outVertices[index + 1].texcoord[0] = 1.0f;
+            outVertices[index + 1].texcoord[1] = t;
+        }
+    }
+}
+
+//
+//simulateCompact() :- GRASS_BLADE_SOA path, 3x3 rotations built from sin/cos
+//
+void GrassField::simulateCompact( float time, const GRASS_WIND_MAP *windMap, const GRASS_LOD_TILE *tile, GRASS_VERTEX *outVertices)
+{
+    //variable declarations
+    int segments = tile->segments;
+    int verticesPerBlade = 2 * segments;
+
+    float segmentT[ GRASS_MAX_BLADE_SEGMENTS];
+    float segmentCurve[ GRASS_MAX_BLADE_SEGMENTS];
+
+    //code
+        //per segment terms are the same for every blade of the tile
+    fillSegmentTable( tile, segmentT, segmentCurve);
+
+    float windParamX = params.windOffset[0] + params.windFrequency[0] * time;
+    float windParamY = params.windOffset[1] + params.windFrequency[1] * time;
+
+    GRASS_SIMD_BATCH batch;
+
+    if( this->simdLevel != GRASS_SIMD_SCALAR)
+    {
+        batch.meshVertices = this->meshVertices;
+        batch.grid = this->grid;
+        batch.facingSin = this->blades.facingSin;
+        batch.facingCos = this->blades.facingCos;
+        batch.bendSin = this->blades.bendSin;
+        batch.width = this->blades.width;
+        batch.height = this->blades.height;
+        batch.forward = this->blades.forward;
+        batch.segments = segments;
+        batch.segmentT = segmentT;
+        batch.segmentCurve = segmentCurve;
+        batch.windWidth = windMap->width;
+        batch.windHeight = windMap->height;
+        batch.windTexels = windMap->texels;
+        batch.windPacked = windMap->packed;
+        batch.windBlockColumns = windMap->blockColumns;
+        batch.windBilinear = windMap->bilinear;
+        batch.windScale[0] = params.windScale[0];
+        batch.windScale[1] = params.windScale[1];
+        batch.windParam[0] = windParamX;
+        batch.windParam[1] = windParamY;
+        batch.windStrength = params.windStrength;
+        batch.windProcedural = windMap->procedural;
+        batch.windModel = windMap->model;
+        batch.windTime = time;
+    }
+
+        //a row of the tile is contiguous both in the grid and in the output
+    for( int row = 0; row < tile->height; row++)
+    {
+        int rowBegin = ( tile->z + row) * this->meshWidth + tile->x;
+        int rowEnd = rowBegin + tile->width;
+        GRASS_VERTEX *rowOut = outVertices + tile->firstVertex + (size_t)verticesPerBlade * tile->width * row;
+
+        int bladeBegin = rowBegin;
+
+            //whole groups of 8 / 16 blades on the vector kernel, the rest below
+        if( this->simdLevel != GRASS_SIMD_SCALAR)
+        {
+            batch.outVertices = rowOut;
+            batch.outFirstBlade = rowBegin;
+
+            if( this->simdLevel == GRASS_SIMD_AVX512)
+            {
+                bladeBegin += GrassSimulateAVX512( &batch, rowBegin, rowEnd);
+            }
+            else
+            {
+                bladeBegin += GrassSimulateAVX2( &batch, rowBegin, rowEnd);
+            }
+        }
+
+
+        for( int i = bladeBegin; i < rowEnd; i++)
+        {
+            float pos[3], normal[3], tangent[3];
+            getBladeRoot( i, pos, normal, tangent);
+
+            //tangent to local from grid normal / tangent ( columns : tangent, normal x tangent, normal)
+            GRASS_MAT3 T;
+            T.m[0][0] = tangent[0];     T.m[0][1] = tangent[1];     T.m[0][2] = tangent[2];
+            T.m[1][0] = normal[1] * tangent[2] - normal[2] * tangent[1];
+            T.m[1][1] = normal[2] * tangent[0] - normal[0] * tangent[2];
+            T.m[1][2] = normal[0] * tangent[1] - normal[1] * tangent[0];
+            T.m[2][0] = normal[0];      T.m[2][1] = normal[1];      T.m[2][2] = normal[2];
+
+            float bendSin = this->blades.bendSin[i];
+            GRASS_MAT3 F = Mat3Rotation( this->blades.facingSin[i], this->blades.facingCos[i], 0.0f, 0.0f, 1.0f);
+            GRASS_MAT3 B = Mat3Rotation( bendSin, sqrtf( 1.0f - bendSin * bendSin), -1.0f, 0.0f, 0.0f);
+
+            //ADD WIND
+            vmath::vec4 color = vmath::vec4( 0.0f);
+            if( windMap->procedural)
+            {
+                GrassSampleProceduralWind( &windMap->model, pos[0], pos[2], time, &color[0], &color[1]);
+            }
+            else
+            {
+                vmath::vec2 uv( pos[0] * params.windScale[0] + windParamX, pos[2] * params.windScale[1] + windParamY);
+                color = getTexel( uv, windMap);
+            }
+
+            float windSampleX = ( color[0] * 2.0f - 1.0f) * params.windStrength;
+            float windSampleY = ( color[1] * 2.0f - 1.0f) * params.windStrength;
+
+            float windLength = sqrtf( windSampleX * windSampleX + windSampleY * windSampleY);
+            float windAngle = mymath::PI * windSampleX;
+            GRASS_MAT3 W = Mat3Rotation( sinf( windAngle), cosf( windAngle), windSampleX / windLength, windSampleY / windLength, 0.0f);
+
+                //for base vertices, we don't want to bend or rotate base vertices
+            GRASS_MAT3 baseM = Mat3Multiply( T, F);
+
+                //for vertices other than base  vertices, as we want them to move with wind
+            GRASS_MAT3 M = Mat3Multiply( Mat3Multiply( T, W), Mat3Multiply( F, B));
+
+            float width = this->blades.width[i];
+            float height = this->blades.height[i];
+            float forward = this->blades.forward[i];
+
+            GRASS_VERTEX *out = rowOut + (size_t)verticesPerBlade * ( i - rowBegin);
+
+            for( int j = 0; j < segments; j++)
+            {
+                const GRASS_MAT3 &R = (j == 0) ? baseM : M;     //don't bend base vertices
+
+                float t = segmentT[j];
+                float segmentWidth = width * ( 1.0f - t);
+                float segmentHeight = height * t;
+                float segmentForward = segmentCurve[j] * forward;
+
+                    //shared part of ( +/-width, forward, height) and normal ( 0, -1, forward)
+                float fx = R.m[1][0] * segmentForward, fy = R.m[1][1] * segmentForward, fz = R.m[1][2] * segmentForward;
+                float hx = R.m[2][0] * segmentHeight,  hy = R.m[2][1] * segmentHeight,  hz = R.m[2][2] * segmentHeight;
+                float wx = R.m[0][0] * segmentWidth,   wy = R.m[0][1] * segmentWidth,   wz = R.m[0][2] * segmentWidth;
+
+                float nx = R.m[2][0] * segmentForward - R.m[1][0];
+                float ny = R.m[2][1] * segmentForward - R.m[1][1];
+                float nz = R.m[2][2] * segmentForward - R.m[1][2];
+
+                out[0].position[0] = pos[0] + wx + fx + hx;
+                out[0].position[1] = pos[1] + wy + fy + hy;
+                out[0].position[2] = pos[2] + wz + fz + hz;
+                out[0].normal[0] = nx;
+                out[0].normal[1] = ny;
+                out[0].normal[2] = nz;
+                out[0].texcoord[0] = 0.0f;
+                out[0].texcoord[1] = t;
+
+                out[1].position[0] = pos[0] - wx + fx + hx;
+                out[1].position[1] = pos[1] - wy + fy + hy;
+                out[1].position[2] = pos[2] - wz + fz + hz;
+                out[1].normal[0] = nx;
+                out[1].normal[1] = ny;
+                out[1].normal[2] = nz;
+                out[1].texcoord[0] = 1.0f;
+                out[1].texcoord[1] = t;
+
+                out += 2;
+            }
+        }
+    }
+}
+
+//
+//FillBladeIndices() :- two triangles per segment for 'blades' blades of 'segments' segments, return number of indices written
+//
+static int FillBladeIndices( unsigned int *outIndices, int blades, int segments)
+{
+    //code
+    int verticesPerBlade = 2 * segments;
+
+    int indexPointer = 0;
+    for( int i = 0; i < blades; i++)
+    {
+        for( int j = 0; j < segments - 1; j++)
+        {
+            outIndices[indexPointer++] = (i * verticesPerBlade) + (2 * j + 0);
+            outIndices[indexPointer++] = (i * verticesPerBlade) + (2 * j + 2);
+            outIndices[indexPointer++] = (i * verticesPerBlade) + (2 * j + 3);
+
+            outIndices[indexPointer++] = (i * verticesPerBlade) + (2 * j + 0);
+            outIndices[indexPointer++] = (i * verticesPerBlade) + (2 * j + 3);
+            outIndices[indexPointer++] = (i * verticesPerBlade) + (2 * j + 1);
+        }
+    }
+
+    return( indexPointer);
+}
+
+//
+//fillIndices()
+//
+int GrassField::fillIndices( unsigned int *outIndices, size_t outIndexCount) const
+{
+    //code
+    GRASS_PROFILE_SCOPE( "fill indices");
+
+    int blades = this->bladeCount;
+    if( (size_t)blades * getIndicesPerBlade() > outIndexCount)
+    {
+        blades = (int)(outIndexCount / getIndicesPerBlade());
+    }
+
+    return( FillBladeIndices( outIndices, blades, params.segments));
+}
+
+//
+//fillIndexTemplate()
+//
+int GrassField::fillIndexTemplate( unsigned int *outIndices, int templateBlades) const
+{
+    //code
+    GRASS_PROFILE_SCOPE( "fill index template");
+
+    int indexPointer = 0;
+    for( int level = 0; level < GRASS_LOD_LEVELS; level++)
+    {
+        indexPointer += FillBladeIndices( outIndices + indexPointer, templateBlades, getLevelSegments( level));
+    }
+
+    return( indexPointer);
+}
+
+//
+//getIndexTemplateCount()
+//
+int GrassField::getIndexTemplateCount( int templateBlades) const
+{
+    //code
+    int count = 0;
+    for( int level = 0; level < GRASS_LOD_LEVELS; level++)
+    {
+        count += templateBlades * 6 * ( getLevelSegments( level) - 1);
+    }
+
+    return( count);
+}
+
+//
+//fillTemplateDraws() :- visible tiles of the same level are contiguous in the output, one draw per templateBlades of them
+//
+int GrassField::fillTemplateDraws( int templateBlades, int *outCounts, int *outFirstIndices, int *outBaseVertices, int maxDraws) const
+{
+    //variable declarations
+    int templateFirstIndex[ GRASS_LOD_LEVELS];
+
+    //code
+    templateFirstIndex[0] = 0;
+    for( int level = 1; level < GRASS_LOD_LEVELS; level++)
+    {
+        templateFirstIndex[ level] = templateFirstIndex[ level - 1] + templateBlades * 6 * ( getLevelSegments( level - 1) - 1);
+    }
+
+    int drawCount = 0;
+    int tile = 0;
+
+    while( tile < this->visibleTileCount)
+    {
+            //run of neighbouring tiles with the same level and adjacent outputs
+        const GRASS_LOD_TILE *first = &this->visibleTiles[ tile];
+        int runBlades = 0;
+
+        while( (tile < this->visibleTileCount) && (this->visibleTiles[ tile].level == first->level) &&
+               (this->visibleTiles[ tile].firstVertex == first->firstVertex + runBlades * 2 * first->segments))
+        {
+            runBlades += this->visibleTiles[ tile].width * this->visibleTiles[ tile].height;
+            tile++;
+        }
+
+        for( int blade = 0; blade < runBlades; blade += templateBlades)
+        {
+            if( drawCount >= maxDraws)
+            {
+                return(0);
+            }
+
+            outCounts[ drawCount] = MIN( templateBlades, runBlades - blade) * 6 * ( first->segments - 1);
+            outFirstIndices[ drawCount] = templateFirstIndex[ first->level];
+            outBaseVertices[ drawCount] = first->firstVertex + blade * 2 * first->segments;
+            drawCount++;
+        }
+    }
+
+    return( drawCount);
+}
+
+
+//
+//GrassReserveCapacity()
+//
+int GrassReserveCapacity( int capacity, int required)
+{
+    //code
+    if( required <= 0)
+    {
+        return( capacity);
+    }
+
+    if( (required <= capacity) && (required > capacity / 16))
+    {
+        return( capacity);      //fits and not wasting too much
+    }
+
+    int newCapacity = 1;
+    while( newCapacity < required)
+    {
+        newCapacity = newCapacity * 2;
+    }
+
+    return( newCapacity);
+}
+
+//
+//GrassSimdDetect()
+//
+GRASS_SIMD_LEVEL GrassSimdDetect( void)
+{
+    //variable declarations
+    static std::atomic<int> detected( -1);     //GrassBench / renderer threads may detect at the same time
+
+    int avx2 = 0;
+    int avx512 = 0;
+
+    //code
+    int level = detected.load();
+    if( level >= 0)
+    {
+        return( (GRASS_SIMD_LEVEL) level);
+    }
+
+#if defined(_MSC_VER) && ( defined(_M_X64) || defined(_M_IX86))
+    int info[4];
+
+    __cpuid( info, 1);
+    int fma = ( info[2] & (1 << 12)) != 0;
+    int osxsave = ( info[2] & (1 << 27)) != 0;
+
+    __cpuidex( info, 7, 0);
+    if( osxsave)
+    {
+        unsigned long long xcr0 = _xgetbv( 0);
+
+        avx2 = fma && ( info[1] & (1 << 5)) && ( (xcr0 & 0x06) == 0x06);        //YMM state
+        avx512 = avx2 && ( info[1] & (1 << 16)) && ( (xcr0 & 0xE6) == 0xE6);    //ZMM / opmask state
+    }
+#elif ( defined(__GNUC__) || defined(__clang__)) && ( defined(__x86_64__) || defined(__i386__))
+    __builtin_cpu_init();
+
+    avx2 = __builtin_cpu_supports( "avx2") && __builtin_cpu_supports( "fma");
+    avx512 = avx2 && __builtin_cpu_supports( "avx512f");
+#endif
+
+        //kernels compiled without their instruction set are stubs
+    avx2 = avx2 && ( GrassSimdAVX2Lanes() > 0);
+    avx512 = avx512 && ( GrassSimdAVX512Lanes() > 0);
+
+    level = avx512 ? GRASS_SIMD_AVX512 : ( avx2 ? GRASS_SIMD_AVX2 : GRASS_SIMD_SCALAR);
+    detected.store( level);
+
+    return( (GRASS_SIMD_LEVEL) level);
+}
+
+//
+//GrassSimdDefault()
+//
+GRASS_SIMD_LEVEL GrassSimdDefault( void)
+{
+    //code
+    GRASS_SIMD_LEVEL supported = GrassSimdDetect();
+
+    return( (supported > GRASS_SIMD_AVX2) ? GRASS_SIMD_AVX2 : supported);
+}
+
+//
+//GrassSimdName()
+//
+const char *GrassSimdName( GRASS_SIMD_LEVEL level)
+{
+    //code
+    switch( level)
+    {
+        case GRASS_SIMD_AVX2:
+            return( "AVX2");
+
+        case GRASS_SIMD_AVX512:
+            return( "AVX-512");
+
+        default:
+            return( "scalar");
+    }
+}
+
+//
+//HeightCalculate
+//
+float HeightCalculate( float x, float z, float amplitude)
+{
+    //code
+    return( 0.0f);
+    //return( random( 0.1f* vmath::vec3( x/currentMeshWidth, 0.0f, z/currentMeshHeight)) * amplitude);
+}
+
+//
+//CreateMesh()
+//
+void CreateMesh(
+    int cx,
+    int cz,
+    int MeshWidth,
+    int MeshHeight,
+    float multiplicant,
+    float amplitude,
+    VERTEX *vertexData,
+    float (*heightFunc)(float, float, float)    //height function
+)
+{
+	//code
+    if( vertexData == NULL)
+        return;
+
+	int vertexPointer = 0;
+
+	int xStart = cx * (MeshWidth-1);
+	int zStart = cz * (MeshHeight-1);
+
+	float topLeftX = xStart - (MeshWidth -1) / 2;
+	float topLeftZ = zStart + (MeshHeight -1) / 2;
+
+    if( gpLogFile)
+    {
+        fprintf( gpLogFile, "[%f, %f], [%d, %d]\n", topLeftX, topLeftZ, MeshWidth, MeshHeight);
+    }
+
+	for (int z = 0; z < MeshHeight; z++)
+	{
+		for (int x = 0; x < MeshWidth; x++)
+		{
+			float posX = (topLeftX + x) * multiplicant;
+			float posZ = (topLeftZ - z) * multiplicant;
+
+			vertexData[vertexPointer].position[0] = (float)posX;
+			vertexData[vertexPointer].position[1] = heightFunc( posX, posZ, amplitude);//0.0f;
+			vertexData[vertexPointer].position[2] = (float)posZ;
+
+            vertexData[vertexPointer].normal[0] = 0.0f;
+            vertexData[vertexPointer].normal[1] = 1.0f;
+            vertexData[vertexPointer].normal[2] = 0.0f;
+
+            vertexData[vertexPointer].texcoord[0] = (float)x / (float)MeshWidth;
+			vertexData[vertexPointer].texcoord[1] = (float)z / (float)MeshHeight;
+
+            vertexData[vertexPointer].tangent[0] = 1.0f;
+			vertexData[vertexPointer].tangent[1] = 0.0f;
+			vertexData[vertexPointer].tangent[2] = 0.0f;
+
+            vertexPointer++;
+		}
+	}
+}
+
+//
+//CreateGrid()
+//
+void CreateGrid( int cx, int cz, int MeshWidth, int MeshHeight, float multiplicant, GRASS_GRID *grid)
+{
+    //code
+    int xStart = cx * (MeshWidth-1);
+    int zStart = cz * (MeshHeight-1);
+
+    grid->width = MeshWidth;
+    grid->height = MeshHeight;
+    grid->left = xStart - (MeshWidth -1) / 2;      //integer division, same as CreateMesh()
+    grid->top = zStart + (MeshHeight -1) / 2;
+    grid->spacing = multiplicant;
+    grid->heights = NULL;
+}
+
+//
+//RotationMatrix()
+//
+vmath::mat4 RotationMatrix( float angleInRadians, float x, float y, float z)
+{
+    //code
+    float s = sinf( angleInRadians);
+    float c = cosf( angleInRadians);
+    float t = 1.0 - c;
+
+    return( vmath::mat4(
+                vmath::vec4( x*x*t + c  , y*x*t + z*s, x*z*t - y*s, 0.0f),
+                vmath::vec4( x*y*t - z*s, y*y*t + c  , y*z*t + x*s, 0.0f),
+                vmath::vec4( x*z*t + y*s, y*z*t - x*s, z*z*t + c  , 0.0f),
+                vmath::vec4( 0.0f, 0.0f, 0.0f, 1.0f)
+            )
+    );
+}
+
+//
+//getPackedTexel() :- red / green of packed wind texel ( x, y), 0 - 255
+//
+static inline void getPackedTexel( const GRASS_WIND_MAP *texture, int x, int y, float *red, float *green)
+{
+    //code
+    const unsigned char *texel = texture->packed + 2 * GRASS_WIND_TEXEL_OFFSET( x, y, texture->blockColumns);
+
+    *red = (float)texel[0];
+    *green = (float)texel[1];
+}
+
+//
+//getTexel() :- Return color from specified texcoord location
+//
+vmath::vec4 getTexel( vmath::vec2 uv, const GRASS_WIND_MAP *texture)
+{
+    //variable declarations
+    vmath::vec4 sample = vmath::vec4( 0.0f);
+
+    //code
+    if( texture->packed && texture->bilinear)
+    {
+            //texel centers at ( x + 0.5) / width, neighbours wrap around like fract()
+            //( same operation order as GrassSimdKernel.h and Grass.cl)
+        float fx = mymath::fract( uv[0]) * texture->width - 0.5f;
+        float fy = mymath::fract( uv[1]) * texture->height - 0.5f;
+        float x0f = floorf( fx);
+        float y0f = floorf( fy);
+        float wx = fx - x0f;
+        float wy = fy - y0f;
+
+        int x0 = (int)x0f;
+        int y0 = (int)y0f;
+        x0 += ( x0 < 0) ? texture->width : 0;
+        y0 += ( y0 < 0) ? texture->height : 0;
+
+        int x1 = ( x0 + 1 < texture->width) ? x0 + 1 : 0;
+        int y1 = ( y0 + 1 < texture->height) ? y0 + 1 : 0;
+
+        float r00, g00, r10, g10, r01, g01, r11, g11;
+        getPackedTexel( texture, x0, y0, &r00, &g00);
+        getPackedTexel( texture, x1, y0, &r10, &g10);
+        getPackedTexel( texture, x0, y1, &r01, &g01);
+        getPackedTexel( texture, x1, y1, &r11, &g11);
+
+        float red0 = r00 + ( r10 - r00) * wx;
+        float red1 = r01 + ( r11 - r01) * wx;
+        float green0 = g00 + ( g10 - g00) * wx;
+        float green1 = g01 + ( g11 - g01) * wx;
+
+        sample[0] = ( red0 + ( red1 - red0) * wy) / 255.0f;
+        sample[1] = ( green0 + ( green1 - green0) * wy) / 255.0f;
+        sample[3] = 1.0f;
+
+        return( sample);
+    }
+
+    int x = floor( mymath::fract(uv[0]) * ( texture->width ));
+    int y = floor( mymath::fract(uv[1]) * ( texture->height));
+
+    if( texture->packed)
+    {
+        getPackedTexel( texture, x, y, &sample[0], &sample[1]);
+
+        sample[0] = sample[0] / 255.0f;
+        sample[1] = sample[1] / 255.0f;
+        sample[3] = 1.0f;
+
+        return( sample);
+    }
+
+    sample[0] = texture->texels[ GRASS_COLOR_CHANNELS * ( y * texture->width + x) + 0]; //red
+    sample[1] = texture->texels[ GRASS_COLOR_CHANNELS * ( y * texture->width + x) + 1]; //green
+    sample[2] = texture->texels[ GRASS_COLOR_CHANNELS * ( y * texture->width + x) + 2]; //blue
+    sample[3] = texture->texels[ GRASS_COLOR_CHANNELS * ( y * texture->width + x) + 3]; //alpha
+
+    return( sample);
+}
+
+//
+//GrassWindHash() :- integer hash of a noise lattice point
+//
+static inline unsigned int GrassWindHash( int x, int y)
+{
+    //code
+    unsigned int h = ( (unsigned int)x * 0x27d4eb2dU) ^ ( (unsigned int)y * 0x165667b1U);
+    h = h ^ ( h >> 15);
+    h = h * 0x2c1b3c6dU;
+
+    return( h ^ ( h >> 12));
+}
+
+//
+//GrassWindGradient() :- dot of the lattice point's gradient and the offset ( dx, dy) from it
+//
+static inline float GrassWindGradient( int x, int y, float dx, float dy)
+{
+    //code
+    unsigned int h = GrassWindHash( x, y);
+    float gx = (float)( h & 0xFF) * ( 1.0f / 127.5f) - 1.0f;
+    float gy = (float)( ( h >> 8) & 0xFF) * ( 1.0f / 127.5f) - 1.0f;
+
+    return( gx * dx + gy * dy);
+}
+
+//
+//GrassGradientNoise()
+//
+float GrassGradientNoise( float x, float y)
+{
+    //code
+    float x0 = floorf( x);
+    float y0 = floorf( y);
+    float fx = x - x0;
+    float fy = y - y0;
+    int ix = (int)x0;
+    int iy = (int)y0;
+
+    float n00 = GrassWindGradient( ix, iy, fx, fy);
+    float n10 = GrassWindGradient( ix + 1, iy, fx - 1.0f, fy);
+    float n01 = GrassWindGradient( ix, iy + 1, fx, fy - 1.0f);
+    float n11 = GrassWindGradient( ix + 1, iy + 1, fx - 1.0f, fy - 1.0f);
+
+        //quintic fade
+    float ux = fx * fx * fx * ( fx * ( fx * 6.0f - 15.0f) + 10.0f);
+    float uy = fy * fy * fy * ( fy * ( fy * 6.0f - 15.0f) + 10.0f);
+
+    float nx0 = n00 + ( n10 - n00) * ux;
+    float nx1 = n01 + ( n11 - n01) * ux;
+
+    return( nx0 + ( nx1 - nx0) * uy);
+}
+
+//
+//GrassSampleProceduralWind()
+//
+void GrassSampleProceduralWind( const GRASS_PROCEDURAL_WIND *wind, float x, float z, float time, float *red, float *green)
+{
+    //code
+    float dirX = wind->direction[0];
+    float dirZ = wind->direction[1];
+    float drift = wind->speed * time;
+
+        //noise drifts with the wind
+    float qx = ( x - dirX * drift) * wind->frequency;
+    float qz = ( z - dirZ * drift) * wind->frequency;
+
+    float base = GrassGradientNoise( qx, qz) + 0.5f * GrassGradientNoise( qx * 2.0f + 19.1f, qz * 2.0f + 7.3f);
+    float sway = GrassGradientNoise( qx + 41.7f, qz + 13.9f);
+
+        //fronts perpendicular to the wind, squared positive half of a sine
+        //( phase wrapped first, the drift grows without bound)
+    float phase = ( x * dirX + z * dirZ - drift) * wind->gustFrequency;
+    float front = sinf( mymath::TWO_PI * ( phase - floorf( phase)));
+    float gust = ( front > 0.0f) ? front * front : 0.0f;
+
+    float along = wind->strength * ( 0.4f + 0.3f * base + 0.6f * gust);
+    float across = wind->strength * 0.3f * sway;
+
+    float windX = dirX * along - dirZ * across;
+    float windZ = dirZ * along + dirX * across;
+
+    *red = CLAMP( 0.5f + 0.5f * windX, 0.0f, 1.0f);
+    *green = CLAMP( 0.5f + 0.5f * windZ, 0.0f, 1.0f);
+}
+
+//
+//GrassGetPackedWindBytes()
+//
+size_t GrassGetPackedWindBytes( int width, int height)
+{
+    //variable declarations
+    int blockSize = 1 << GRASS_WIND_BLOCK_SHIFT;
+    size_t blockColumns = ( width + blockSize - 1) >> GRASS_WIND_BLOCK_SHIFT;
+    size_t blockRows = ( height + blockSize - 1) >> GRASS_WIND_BLOCK_SHIFT;
+
+    //code
+    return( blockColumns * blockRows * blockSize * blockSize * 2 + 4);
+}
+
+//
+//GrassPackWindMap() :- red / green of the float texels to bytes in 8 x 8 texel blocks
+//
+void GrassPackWindMap( GRASS_WIND_MAP *windMap, unsigned char *outPacked)
+{
+    //variable declarations
+    int blockSize = 1 << GRASS_WIND_BLOCK_SHIFT;
+    int blockColumns = ( windMap->width + blockSize - 1) >> GRASS_WIND_BLOCK_SHIFT;
+
+    //code
+    memset( outPacked, 0, GrassGetPackedWindBytes( windMap->width, windMap->height));
+
+        //texels are n / 255 of an 8 bit image, so the round trip is exact
+    for( int y = 0; y < windMap->height; y++)
+    {
+        for( int x = 0; x < windMap->width; x++)
+        {
+            const float *texel = windMap->texels + GRASS_COLOR_CHANNELS * ( (size_t)y * windMap->width + x);
+            unsigned char *packed = outPacked + 2 * GRASS_WIND_TEXEL_OFFSET( x, y, blockColumns);
+
+            packed[0] = (unsigned char)( CLAMP( texel[0], 0.0f, 1.0f) * 255.0f + 0.5f);
+            packed[1] = (unsigned char)( CLAMP( texel[1], 0.0f, 1.0f) * 255.0f + 0.5f);
+        }
+    }
+
+    windMap->packed = outPacked;
+    windMap->blockColumns = blockColumns;
+}
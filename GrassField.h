@@ -0,0 +1,416 @@
+#ifndef __GRASS_FIELD_H__
+#define __GRASS_FIELD_H__
+
+/*
+ * Headless grass blade generator (CPU path).
+ *
+ * No Win32 / OpenGL dependency, so the same code runs inside the renderer
+ * (writing into the mapped VBO) and in the command line bench on Linux.
+ */
+
+#include <stddef.h>
+#include <float.h>
+
+#include "vmath.h"
+#include "MyMath.h"
+#include "GrassTypes.h"
+#include "GrassSimd.h"
+#include "GrassThreadPool.h"
+
+//macro
+#define  GRASS_TILE_SIZE            64          //blades per side of a cull / work stealing tile
+#define  GRASS_TEMPLATE_BLADES      1024        //blades in the shared index template, one base vertex draw each
+#define  GRASS_LOD_LEVELS           4
+
+    //grid side range and CreateMesh() terrain of the app, shared by the benches
+#define  MAX_MESH_SIZE              1024
+#define  MIN_MESH_SIZE              2
+#define  MESH_MULTIPLICANT          0.1f
+#define  MESH_AMPLITUDE             5.0f
+
+typedef struct GRASS_STATIC_PROPERTIES
+{
+    vmath::mat4 tangentToLocalMatrix;
+    vmath::mat4 facingRotationMatrix;
+    vmath::mat4 bendRotationMatrix;
+    float width;
+    float height;
+    float forward;
+} GRASS_STATIC_PROPERTIES;
+
+//compact per blade static record, structure of arrays (24 bytes per blade)
+//tangent frame is derived from the grid normal/tangent at simulate time
+typedef struct GRASS_BLADE_SOA
+{
+    float *facingSin;   //facing rotation around tangent space Z
+    float *facingCos;
+    float *bendSin;     //bend angle is in [0, PI/2 * bendRotationRandom], cos = sqrt(1 - sin^2)
+    float *width;
+    float *height;
+    float *forward;
+} GRASS_BLADE_SOA;
+
+enum GRASS_LAYOUT
+{
+    GRASS_LAYOUT_MAT4 = 0,      //three mat4 per blade (204 bytes), reference path
+    GRASS_LAYOUT_COMPACT        //GRASS_BLADE_SOA (24 bytes)
+};
+
+//blade shape and wind parameters (same defaults as Grass.cl)
+typedef struct GRASS_BLADE_PARAMS
+{
+    int   segments;
+
+    float bladeHeight;
+    float bladeHeightRandom;
+    float bladeWidth;
+    float bladeWidthRandom;
+    float bendRotationRandom;
+    float bladeForwardAmount;
+    float bladeCurvatureAmount;
+
+    vmath::vec2 windFrequency;
+    vmath::vec2 windScale;
+    vmath::vec2 windOffset;
+    float windStrength;
+
+    GRASS_BLADE_PARAMS()
+    {
+        segments = 12;
+
+        bladeHeight = 0.83f;
+        bladeHeightRandom = 0.26f;
+        bladeWidth = 0.03f;
+        bladeWidthRandom = 0.01f;
+        bendRotationRandom = 0.4f;
+        bladeForwardAmount = 0.515f;
+        bladeCurvatureAmount = 1.18f;
+
+        windFrequency = vmath::vec2( 0.05f, 0.05f);
+        windScale = vmath::vec2( 0.009f, 0.009f);
+        windOffset = vmath::vec2( 0.0f, 0.0f);
+        windStrength = 0.345f;
+    }
+} GRASS_BLADE_PARAMS;
+
+//distance based level of detail, chosen per tile from the camera distance to its bounds
+typedef struct GRASS_LOD_PARAMS
+{
+    int   levels;                           //1 : every tile at level 0
+    int   segments[ GRASS_LOD_LEVELS];      //level 0 always uses GRASS_BLADE_PARAMS::segments
+    float distance[ GRASS_LOD_LEVELS];      //far end of each level, the last one is unbounded
+    float morphRange;                       //fraction of a level's band, before its far end, where blades morph to the next level
+
+    GRASS_LOD_PARAMS()
+    {
+        levels = GRASS_LOD_LEVELS;
+
+        segments[0] = 12;   distance[0] = 10.0f;
+        segments[1] = 6;    distance[1] = 25.0f;
+        segments[2] = 3;    distance[2] = 50.0f;
+        segments[3] = 2;    distance[3] = FLT_MAX;
+
+        morphRange = 0.25f;
+    }
+} GRASS_LOD_PARAMS;
+
+//time sliced updates : visible tiles are regenerated every 'period' frames, period from the projected blade size
+typedef struct GRASS_SCHEDULE_PARAMS
+{
+    bool  enabled;          //tiles get fixed output slots, skipped tiles keep their last vertices
+    int   bladeBudget;      //blades regenerated per frame, 0 = no limit ( tiles without valid vertices always are)
+    int   maxPeriod;        //longest period in frames, power of 2
+    float fullRatePixels;   //projected blade height at and above which a tile is updated every frame
+
+    GRASS_SCHEDULE_PARAMS()
+    {
+        enabled = false;
+        bladeBudget = 0;
+        maxPeriod = 8;
+        fullRatePixels = 96.0f;
+    }
+} GRASS_SCHEDULE_PARAMS;
+
+//rectangle of blades in grid coordinates, [x, x + width) x [z, z + height)
+typedef struct GRASS_TILE
+{
+    int x;
+    int z;
+    int width;
+    int height;
+} GRASS_TILE;
+
+//quadtree node over tiles, bounds padded by the reach of a blade
+typedef struct GRASS_CULL_NODE
+{
+    float boundsMin[3];
+    float boundsMax[3];
+    int child[4];       //-1 : no child
+    int tile;           //leaf : index into tiles, inner node : -1
+} GRASS_CULL_NODE;
+
+//visible tile competing for this frame's update budget
+typedef struct GRASS_SCHEDULE_ENTRY
+{
+    int visible;        //index into visibleTiles
+    float priority;     //frames since the last update / period, FLT_MAX : slot holds no valid vertices
+} GRASS_SCHEDULE_ENTRY;
+
+//read only view of the normalized wind distortion map (RGBA float texels)
+//with its optional packed copy from GrassPackWindMap() : red / green only, one byte each, in 8 x 8 texel
+//blocks ( GRASS_WIND_TEXEL_OFFSET), 2 bytes instead of 16 per texel and a bilinear footprint in one or two blocks
+typedef struct GRASS_WIND_MAP
+{
+    int width;
+    int height;
+    const float *texels;
+
+    const unsigned char *packed;    //NULL : sample 'texels' ( nearest)
+    int blockColumns;
+    bool bilinear;                  //packed only, false : nearest texel like 'texels'
+
+    bool procedural;                //sample 'model' ( GrassSampleProceduralWind()), no texels needed
+    GRASS_PROCEDURAL_WIND model;
+
+    GRASS_WIND_MAP()
+    {
+        width = 0;
+        height = 0;
+        texels = NULL;
+        packed = NULL;
+        blockColumns = 0;
+        bilinear = false;
+
+        procedural = false;
+        model.direction[0] = 0.8f;
+        model.direction[1] = 0.6f;
+        model.strength = 0.8f;
+        model.frequency = 0.15f;
+        model.speed = 2.0f;
+        model.gustFrequency = 0.05f;
+    }
+} GRASS_WIND_MAP;
+
+
+class GrassField
+{
+    public:
+        GRASS_BLADE_PARAMS params;
+        GRASS_LOD_PARAMS lod;
+        GRASS_SCHEDULE_PARAMS schedule;
+
+        GrassField( GRASS_LAYOUT layout = GRASS_LAYOUT_COMPACT);
+        ~GrassField();
+
+            //rebuild per blade static properties for a (meshWidth x meshHeight) grid
+            //return -1 on allocation failure, 0 on success
+        int resize( int meshWidth, int meshHeight, const VERTEX *meshVertices);
+
+            //same for a procedural grid, blade roots are computed instead of read from VERTEX
+            //'grid' is copied, grid->heights must stay valid
+        int resize( const GRASS_GRID *grid);
+        bool isProcedural( void) const          { return( meshVertices == NULL); }
+
+            //frustum cull tiles against 'viewProjection' (clip = viewProjection * world), NULL : all visible
+            //and pick each visible tile's LOD level from its distance to 'eye', NULL : all at level 0
+            //simulate() and the draw lists below only cover visible tiles, return number of visible blades
+        int cull( const vmath::mat4 *viewProjection, const vmath::vec3 *eye = NULL);
+        int getVisibleBladeCount( void) const   { return( visibleBladeCount); }
+        int getVisibleTileCount( void) const    { return( visibleTileCount); }
+        int getTileCount( void) const           { return( tileCount); }
+        int getTileColumnCount( void) const     { return( tilesX); }
+
+            //visible tiles in output order
+        const GRASS_LOD_TILE *getVisibleTiles( void) const  { return( visibleTiles); }
+
+            //vertices / indices of the visible blades at their LOD, output of simulate() is packed to this size
+            //unless schedule.enabled ( then every tile has its own slot, up to getVertexCount())
+        int getOutputVertexCount( void) const   { return( outputVertexCount); }
+        int getOutputIndexCount( void) const    { return( outputIndexCount); }
+        int getLevelBladeCount( int level) const    { return( ( level >= 0 && level < GRASS_LOD_LEVELS) ? levelBlades[ level] : 0); }
+        int getLevelSegments( int level) const;
+
+            //after cull() : pick the visible tiles simulate() regenerates this frame ( all of them when schedule is off)
+            //pixelScale : projected size in pixels of 1 unit at distance 1 ( viewport height / 2 * projection[1][1])
+            //return number of blades to regenerate
+        int scheduleUpdates( float pixelScale);
+        void invalidateSchedule( void);     //output buffer was lost, regenerate every tile on next use
+
+            //tiles simulate() writes, in output order, the OpenCL kernel runs one work group row per entry
+        const GRASS_LOD_TILE *getUpdateTiles( void) const   { return( updateTiles); }
+        int getUpdateTileCount( void) const     { return( updateTileCount); }
+        int getUpdateBladeCount( void) const    { return( updateBladeCount); }
+
+            //visible blades per regenerated blade, this frame and averaged since the last resetScheduleStats()
+        double getAmortization( void) const     { return( (double)visibleBladeCount / MAX( updateBladeCount, 1)); }
+        double getMeanAmortization( void) const { return( (double)scheduleVisibleBlades / MAX( scheduleUpdateBlades, 1)); }
+        void resetScheduleStats( void)          { scheduleVisibleBlades = 0; scheduleUpdateBlades = 0; }
+
+            //generate blades of the update tiles at 'time' into outVertices[0 .. outVertexCount)
+            //return number of blades written
+        int simulate( float time, const GRASS_WIND_MAP *windMap, GRASS_VERTEX *outVertices, size_t outVertexCount);
+
+            //write triangle indices of all blades at params.segments, return number of indices written
+            //with LOD off the packed output of simulate() is drawn by its first getOutputIndexCount() indices
+        int fillIndices( unsigned int *outIndices, size_t outIndexCount) const;
+
+            //one template of templateBlades blades per LOD level, level after level, same for every grid size
+            //return number of indices written ( getIndexTemplateCount())
+        int fillIndexTemplate( unsigned int *outIndices, int templateBlades) const;
+        int getIndexTemplateCount( int templateBlades) const;
+
+            //draws of the level templates covering visible blades : index count, first template index and base vertex per draw
+            //return number of draws, 0 when maxDraws is too small ( at most getTileCount() * ( GRASS_TILE_SIZE^2 / templateBlades + 1))
+        int fillTemplateDraws( int templateBlades, int *outCounts, int *outFirstIndices, int *outBaseVertices, int maxDraws) const;
+
+        int getBladeCount( void) const          { return( bladeCount); }
+            //at level 0 ( params.segments), the output buffer is sized for every blade at level 0
+        int getVerticesPerBlade( void) const    { return( 2 * params.segments); }
+        int getIndicesPerBlade( void) const     { return( 6 * (params.segments - 1)); }
+        int getVertexCount( void) const         { return( bladeCount * getVerticesPerBlade()); }
+        int getIndexCount( void) const          { return( bladeCount * getIndicesPerBlade()); }
+
+        GRASS_LAYOUT getLayout( void) const     { return( layout); }
+
+            //vector kernel for the compact layout, clamped to GrassSimdDetect()
+        void setSimdLevel( GRASS_SIMD_LEVEL level);
+        GRASS_SIMD_LEVEL getSimdLevel( void) const  { return( simdLevel); }
+
+            //worker threads of simulate(), 0 = one per hardware thread, 1 = calling thread only
+        void setThreadCount( int threadCount);
+        int getThreadCount( void) const         { return( pool ? pool->getThreadCount() : 1); }
+
+            //per thread busy time / tiles of the last simulate(), NULL before the first one
+        const GRASS_THREAD_STATS *getThreadStats( void) const  { return( pool ? pool->getStats() : NULL); }
+        double getLoadImbalance( void) const    { return( pool ? pool->getImbalance() : 1.0); }
+        double getSimulateMs( void) const       { return( pool ? pool->getWallMs() : 0.0); }
+
+        size_t getStaticBytesPerBlade( void) const;
+
+            //host memory of static properties, reserved (capacity) and used (current grid)
+        size_t getReservedBytes( void) const    { return( getStaticBytesPerBlade() * bladeCapacity); }
+        size_t getUsedBytes( void) const        { return( getStaticBytesPerBlade() * bladeCount); }
+
+    private:
+        GRASS_LAYOUT layout;
+        GRASS_SIMD_LEVEL simdLevel;
+
+        int meshWidth;
+        int meshHeight;
+        int bladeCount;
+        int bladeCapacity;
+
+        GrassThreadPool *pool;
+        int threadCount;
+
+            //tiles are row major, tilesX x tilesZ, nodes[0] is the quadtree root
+        GRASS_TILE *tiles;
+        int *tileNodes;                 //leaf node of each tile
+        unsigned char *tileVisible;
+        GRASS_LOD_TILE *visibleTiles;
+        int tilesX;
+        int tilesZ;
+        int tileCount;
+        int tileCapacity;
+        int visibleTileCount;
+        int visibleBladeCount;
+        int outputVertexCount;
+        int outputIndexCount;
+        int levelBlades[ GRASS_LOD_LEVELS];
+
+            //time sliced updates, per tile : fixed output slot, segments held in it ( 0 : nothing valid), frame of last update
+        int *tileSlots;
+        int *tileSegments;
+        int *tileUpdateFrames;
+        float *visibleDistances;        //eye to bounds of each visible tile, 0 without eye
+        GRASS_SCHEDULE_ENTRY *scheduleEntries;
+        GRASS_LOD_TILE *updateTiles;
+        int updateTileCount;
+        int updateBladeCount;
+        int scheduleFrame;
+        bool slotLayout;                //placement of the last cull()
+        long long scheduleVisibleBlades;
+        long long scheduleUpdateBlades;
+
+        GRASS_CULL_NODE *nodes;
+        int nodeCount;
+
+        const VERTEX *meshVertices;     //NULL : procedural 'grid'
+        GRASS_GRID grid;
+        GRASS_STATIC_PROPERTIES *staticProps;
+        GRASS_BLADE_SOA blades;
+        float *bladeStorage;
+
+        int rebuild( void);
+        int rebuildTiles( void);
+        int buildNode( int tileX0, int tileZ0, int tileX1, int tileZ1);
+        void cullNode( int node, const float planes[6][4], bool inside);
+        float getTileDistance( int tile, const vmath::vec3 *eye) const;
+        void selectLod( int tile, float distance, GRASS_LOD_TILE *lodTile) const;
+
+            //t and forward curve per segment of 'tile', morphed towards its coarse level
+        void fillSegmentTable( const GRASS_LOD_TILE *tile, float *segmentT, float *segmentCurve) const;
+
+            //root position, normal and tangent of blade i
+        inline void getBladeRoot( int i, float position[3], float normal[3], float tangent[3]) const
+        {
+            if( meshVertices)
+            {
+                const VERTEX *v = &meshVertices[i];
+                position[0] = v->position[0];   position[1] = v->position[1];   position[2] = v->position[2];
+                normal[0] = v->normal[0];       normal[1] = v->normal[1];       normal[2] = v->normal[2];
+                tangent[0] = v->tangent[0];     tangent[1] = v->tangent[1];     tangent[2] = v->tangent[2];
+            }
+            else
+            {
+                int x = i % grid.width;
+                int z = i / grid.width;
+                position[0] = (grid.left + x) * grid.spacing;
+                position[1] = grid.heights ? grid.heights[i] : 0.0f;
+                position[2] = (grid.top - z) * grid.spacing;
+                normal[0] = 0.0f;   normal[1] = 1.0f;   normal[2] = 0.0f;
+                tangent[0] = 1.0f;  tangent[1] = 0.0f;  tangent[2] = 0.0f;
+            }
+        }
+
+            //blades of one visible tile, written from outVertices + tile->firstVertex
+        void simulateMat4( float time, const GRASS_WIND_MAP *windMap, const GRASS_LOD_TILE *tile, GRASS_VERTEX *outVertices);
+        void simulateCompact( float time, const GRASS_WIND_MAP *windMap, const GRASS_LOD_TILE *tile, GRASS_VERTEX *outVertices);
+
+        static void simulateTile( void *context, int tile);
+
+        GrassField( const GrassField &);
+        GrassField& operator=( const GrassField &);
+};
+
+
+//function declarations
+
+    //geometric (power of two) capacity for 'required' elements, shrinks only below 1/16 usage
+int GrassReserveCapacity( int capacity, int required);
+
+float HeightCalculate( float x, float z, float amplitude);
+void CreateMesh(
+    int cx, int cz, int MeshWidth, int MeshHeight,
+    float multiplicant, float amplitude,
+    VERTEX *vertexData,
+    float (*heightFunc)(float, float, float)    //height function
+);
+
+    //procedural equivalent of a flat CreateMesh()
+void CreateGrid( int cx, int cz, int MeshWidth, int MeshHeight, float multiplicant, GRASS_GRID *grid);
+
+vmath::mat4 RotationMatrix( float angleInRadians, float x, float y, float z);
+vmath::vec4 getTexel( vmath::vec2 uv, const GRASS_WIND_MAP *texture);
+
+    //2D gradient noise in about [-1, 1], lattice gradients from an integer hash ( same in GrassSimdKernel.h and Grass.cl)
+float GrassGradientNoise( float x, float y);
+    //wind at world ( x, z) and 'time' as the red / green a texel would hold ( 0.5 : no wind)
+void GrassSampleProceduralWind( const GRASS_PROCEDURAL_WIND *wind, float x, float z, float time, float *red, float *green);
+
+    //bytes of the packed copy of a width x height wind map ( padded to whole blocks, + 4 for 32 bit gathers)
+size_t GrassGetPackedWindBytes( int width, int height);
+    //pack windMap->texels into outPacked ( GrassGetPackedWindBytes() bytes) and point windMap->packed at it
+void GrassPackWindMap( GRASS_WIND_MAP *windMap, unsigned char *outPacked);
+
+#endif
@@ -0,0 +1,271 @@
+/*
+ * OpenCL helpers shared by Main.cpp and GrassBench, see GrassOpenCL.h
+ *
+ * Created By Vijaykumar Dangi
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "GrassOpenCL.h"
+
+//
+//GrassWindImageSupported()
+//
+bool GrassWindImageSupported( cl_context context, cl_device_id device)
+{
+    //variable declarations
+    cl_bool imageSupport = CL_FALSE;
+    cl_uint formatCount = 0;
+
+    //code
+    if( (clGetDeviceInfo( device, CL_DEVICE_IMAGE_SUPPORT, sizeof( imageSupport), &imageSupport, NULL) != CL_SUCCESS) || (imageSupport == CL_FALSE))
+    {
+        return( false);
+    }
+
+    if( (clGetSupportedImageFormats( context, CL_MEM_READ_ONLY, CL_MEM_OBJECT_IMAGE2D, 0, NULL, &formatCount) != CL_SUCCESS) || (formatCount == 0))
+    {
+        return( false);
+    }
+
+    cl_image_format *formats = (cl_image_format *) malloc( formatCount * sizeof( cl_image_format));
+    if( formats == NULL)
+    {
+        return( false);
+    }
+
+    bool supported = false;
+    if( clGetSupportedImageFormats( context, CL_MEM_READ_ONLY, CL_MEM_OBJECT_IMAGE2D, formatCount, formats, NULL) == CL_SUCCESS)
+    {
+        for( cl_uint i = 0; (i < formatCount) && !supported; i++)
+        {
+            supported = (formats[i].image_channel_order == CL_RG) && (formats[i].image_channel_data_type == CL_UNORM_INT8);
+        }
+    }
+
+    free( formats);
+
+    return( supported);
+}
+
+//
+//GrassCreateWindImage() :- 8 x 8 blocks of the packed map back to rows for the image
+//
+cl_mem GrassCreateWindImage( cl_context context, const GRASS_WIND_MAP *windMap, cl_int *result)
+{
+    //variable declarations
+    cl_image_format format;
+    cl_image_desc desc;
+
+    //code
+    if( windMap->packed == NULL)
+    {
+        *result = CL_INVALID_VALUE;
+        return( NULL);
+    }
+
+    unsigned char *rows = (unsigned char *) malloc( (size_t)windMap->width * windMap->height * 2);
+    if( rows == NULL)
+    {
+        *result = CL_OUT_OF_HOST_MEMORY;
+        return( NULL);
+    }
+
+    for( int y = 0; y < windMap->height; y++)
+    {
+        for( int x = 0; x < windMap->width; x++)
+        {
+            const unsigned char *texel = windMap->packed + 2 * GRASS_WIND_TEXEL_OFFSET( x, y, windMap->blockColumns);
+
+            rows[ 2 * ( y * windMap->width + x) + 0] = texel[0];
+            rows[ 2 * ( y * windMap->width + x) + 1] = texel[1];
+        }
+    }
+
+    format.image_channel_order = CL_RG;
+    format.image_channel_data_type = CL_UNORM_INT8;
+
+    memset( &desc, 0, sizeof( cl_image_desc));
+    desc.image_type = CL_MEM_OBJECT_IMAGE2D;
+    desc.image_width = windMap->width;
+    desc.image_height = windMap->height;
+
+    cl_mem image = clCreateImage( context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, &format, &desc, rows, result);
+    free( rows);
+
+    return( ( *result == CL_SUCCESS) ? image : NULL);
+}
+
+//
+//HasExtension() :- 'extension' is one of the space separated names of CL_DEVICE_EXTENSIONS
+//
+static bool HasExtension( cl_device_id device, const char *extension)
+{
+    //variable declarations
+    size_t size = 0;
+    bool found = false;
+
+    //code
+    if( (clGetDeviceInfo( device, CL_DEVICE_EXTENSIONS, 0, NULL, &size) != CL_SUCCESS) || (size == 0))
+    {
+        return( false);
+    }
+
+    char *extensions = (char *) malloc( size + 1);
+    if( extensions == NULL)
+    {
+        return( false);
+    }
+
+    if( clGetDeviceInfo( device, CL_DEVICE_EXTENSIONS, size, extensions, NULL) == CL_SUCCESS)
+    {
+        extensions[ size] = '\0';
+
+        for( char *name = strtok( extensions, " "); (name != NULL) && !found; name = strtok( NULL, " "))
+        {
+            found = (strcmp( name, extension) == 0);
+        }
+    }
+
+    free( extensions);
+
+    return( found);
+}
+
+//
+//GrassEnumerateDevices()
+//
+int GrassEnumerateDevices( GRASS_CL_DEVICE *devices, int maxDevices)
+{
+    //variable declarations
+    cl_platform_id platforms[ 16];
+    cl_uint platformCount = 0;
+    int deviceCount = 0;
+
+    //code
+    if( (clGetPlatformIDs( 16, platforms, &platformCount) != CL_SUCCESS) || (platformCount == 0))
+    {
+        return(0);
+    }
+
+    platformCount = MIN( platformCount, 16);
+
+    for( cl_uint i = 0; (i < platformCount) && (deviceCount < maxDevices); i++)
+    {
+        cl_device_id platformDevices[ GRASS_MAX_CL_DEVICES];
+        cl_uint platformDeviceCount = 0;
+        char platformName[ 128] = "";
+
+        if( clGetDeviceIDs( platforms[i], CL_DEVICE_TYPE_ALL, GRASS_MAX_CL_DEVICES, platformDevices, &platformDeviceCount) != CL_SUCCESS)
+        {
+            continue;       //CL_DEVICE_NOT_FOUND
+        }
+        clGetPlatformInfo( platforms[i], CL_PLATFORM_NAME, sizeof( platformName), platformName, NULL);
+
+        platformDeviceCount = MIN( platformDeviceCount, GRASS_MAX_CL_DEVICES);
+
+        for( cl_uint j = 0; (j < platformDeviceCount) && (deviceCount < maxDevices); j++)
+        {
+            GRASS_CL_DEVICE *device = &devices[ deviceCount++];
+
+            memset( device, 0, sizeof( GRASS_CL_DEVICE));
+            device->platform = platforms[i];
+            device->device = platformDevices[j];
+            clGetDeviceInfo( device->device, CL_DEVICE_TYPE, sizeof( cl_device_type), &device->type, NULL);
+            clGetDeviceInfo( device->device, CL_DEVICE_NAME, sizeof( device->name) - 1, device->name, NULL);
+            memcpy( device->platformName, platformName, sizeof( device->platformName));
+            device->glSharing = HasExtension( device->device, "cl_khr_gl_sharing");
+        }
+    }
+
+    return( deviceCount);
+}
+
+//
+//ContainsNoCase()
+//
+static bool ContainsNoCase( const char *text, const char *pattern)
+{
+    //code
+    for( ; *text != '\0'; text++)
+    {
+        int i = 0;
+        while( (pattern[i] != '\0') && (tolower( (unsigned char)text[i]) == tolower( (unsigned char)pattern[i])))
+        {
+            i++;
+        }
+
+        if( pattern[i] == '\0')
+        {
+            return( true);
+        }
+    }
+
+    return( false);
+}
+
+//
+//GrassSelectDevice()
+//
+int GrassSelectDevice( const GRASS_CL_DEVICE *devices, int deviceCount, const char *selector, cl_device_type preferredType)
+{
+    //code
+    if( deviceCount <= 0)
+    {
+        return(-1);
+    }
+
+    if( (selector == NULL) || (selector[0] == '\0'))
+    {
+        for( int i = 0; i < deviceCount; i++)
+        {
+            if( devices[i].type & preferredType)
+            {
+                return( i);
+            }
+        }
+
+        return(0);
+    }
+
+    if( strspn( selector, "0123456789") == strlen( selector))
+    {
+        int index = atoi( selector);
+        return( (index < deviceCount) ? index : -1);
+    }
+
+    for( int i = 0; i < deviceCount; i++)
+    {
+        if( ContainsNoCase( devices[i].name, selector))
+        {
+            return( i);
+        }
+    }
+
+    return(-1);
+}
+
+//
+//GrassDeviceTypeName()
+//
+const char *GrassDeviceTypeName( cl_device_type type)
+{
+    //code
+    if( type & CL_DEVICE_TYPE_GPU)
+    {
+        return( "GPU");
+    }
+    else if( type & CL_DEVICE_TYPE_CPU)
+    {
+        return( "CPU");
+    }
+    else if( type & CL_DEVICE_TYPE_ACCELERATOR)
+    {
+        return( "accelerator");
+    }
+
+    return( "other");
+}
@@ -0,0 +1,57 @@
+#ifndef __GRASS_OPENCL_H__
+#define __GRASS_OPENCL_H__
+
+/*
+ * OpenCL helpers shared by Main.cpp and GrassBench.
+ *
+ * Wind image : devices with image support sample the wind map through a
+ * CL_RG / CL_UNORM_INT8 image2d_t with a repeat, linear sampler ( texture
+ * cache and filtering hardware) instead of the packed buffer and the
+ * manual bilinear getTexel(). grass_kernel is then built with
+ * GRASS_WIND_IMAGE_OPTION and takes the image as argument
+ * GRASS_KERNEL_ARG_WIND_IMAGE, the packed buffer argument stays NULL.
+ *
+ * Devices : GrassEnumerateDevices() lists every device of every platform,
+ * GrassSelectDevice() picks one by index or name ( -cldevice), so the kernel
+ * also runs on CPU runtimes of hosts without a GPU.
+ */
+
+#include <CL/opencl.h>
+
+#include "GrassField.h"
+
+//macro
+#define  GRASS_KERNEL_ARG_WIND_IMAGE    15                          //grass_kernel argument, built with GRASS_WIND_IMAGE_OPTION only
+#define  GRASS_WIND_IMAGE_OPTION        " -D GRASS_WIND_IMAGE"      //appended to the program build options
+#define  GRASS_MAX_CL_DEVICES           32                          //devices GrassEnumerateDevices() lists
+
+//one OpenCL device and what selection needs of it
+typedef struct GRASS_CL_DEVICE
+{
+    cl_platform_id platform;
+    cl_device_id device;
+    cl_device_type type;
+    char name[ 128];
+    char platformName[ 128];
+    bool glSharing;             //cl_khr_gl_sharing, can write GL buffers in place
+} GRASS_CL_DEVICE;
+
+
+//function declarations
+
+    //true when 'device' has images and reads CL_RG / CL_UNORM_INT8 2D images
+bool GrassWindImageSupported( cl_context context, cl_device_id device);
+
+    //red / green bytes of the packed wind map ( GrassPackWindMap()) as a read only image,
+    //same quantization as the buffer path. NULL on error, *result tells why
+cl_mem GrassCreateWindImage( cl_context context, const GRASS_WIND_MAP *windMap, cl_int *result);
+
+    //devices of all platforms and types, platform order then device order, return how many
+int GrassEnumerateDevices( GRASS_CL_DEVICE *devices, int maxDevices);
+    //'selector' : index into 'devices' or part of a device name ( any case), NULL : first device of
+    //'preferredType', else the first device. Return the index, -1 when nothing matches
+int GrassSelectDevice( const GRASS_CL_DEVICE *devices, int deviceCount, const char *selector, cl_device_type preferredType);
+    //"GPU", "CPU", "accelerator" or "other"
+const char *GrassDeviceTypeName( cl_device_type type);
+
+#endif
@@ -0,0 +1,253 @@
+/*
+ * Scoped CPU timing zones, see GrassProfiler.h
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+
+#include "GrassProfiler.h"
+
+//ring slot, 'sequence' is 2 * zone index + 1 while the zone is written, + 2 once it is complete
+typedef struct GRASS_PROFILE_SLOT
+{
+    std::atomic<unsigned long long> sequence;
+    GRASS_PROFILE_ZONE zone;
+} GRASS_PROFILE_SLOT;
+
+//global variable declaration
+static GRASS_PROFILE_SLOT gProfileSlots[ GRASS_PROFILE_CAPACITY];
+static std::atomic<unsigned long long> gProfileHead( 0);     //zones ever recorded
+static std::atomic<unsigned int> gProfileFrame( 0);
+static std::atomic<unsigned int> gProfileThreads( 0);
+
+//
+//GrassProfileNow()
+//
+long long GrassProfileNow( void)
+{
+    //variable declarations
+    static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    //code
+    return( std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now() - start).count());
+}
+
+//
+//GrassProfileSeconds()
+//
+double GrassProfileSeconds( void)
+{
+    //code
+    return( GrassProfileNow() * 1.0e-9);
+}
+
+//
+//GrassProfileBeginFrame()
+//
+unsigned int GrassProfileBeginFrame( void)
+{
+    //code
+    return( gProfileFrame.fetch_add( 1, std::memory_order_relaxed) + 1);
+}
+
+//
+//RecordProfileZone() :- claim the next slot, write the zone, publish it
+//
+static void RecordProfileZone( const char *name, long long beginNs, long long endNs, unsigned int thread)
+{
+    //code
+    unsigned long long index = gProfileHead.fetch_add( 1, std::memory_order_relaxed);
+    GRASS_PROFILE_SLOT *slot = &gProfileSlots[ index & ( GRASS_PROFILE_CAPACITY - 1)];
+
+    slot->sequence.store( 2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence( std::memory_order_release);
+
+    slot->zone.name = name;
+    slot->zone.beginNs = beginNs;
+    slot->zone.endNs = endNs;
+    slot->zone.frame = gProfileFrame.load( std::memory_order_relaxed);
+    slot->zone.thread = thread;
+
+    slot->sequence.store( 2 * index + 2, std::memory_order_release);
+}
+
+//
+//GrassProfileRecord()
+//
+void GrassProfileRecord( const char *name, long long beginNs, long long endNs)
+{
+    //variable declarations
+    static thread_local int thread = -1;
+
+    //code
+    if( thread < 0)
+    {
+        thread = (int)gProfileThreads.fetch_add( 1, std::memory_order_relaxed);
+    }
+
+    RecordProfileZone( name, beginNs, endNs, (unsigned int)thread);
+}
+
+//
+//GrassProfileRecordTrack()
+//
+void GrassProfileRecordTrack( const char *name, long long beginNs, long long endNs, unsigned int track)
+{
+    //code
+    RecordProfileZone( name, beginNs, endNs, track);
+}
+
+//
+//GrassProfileStatAdd()
+//
+void GrassProfileStatAdd( GRASS_PROFILE_STAT *stat, float value)
+{
+    //code
+    stat->sample[ stat->next] = value;
+    stat->next = ( stat->next + 1) % GRASS_PROFILE_STAT_WINDOW;
+    if( stat->count < GRASS_PROFILE_STAT_WINDOW)
+    {
+        stat->count++;
+    }
+}
+
+//
+//GrassProfileStatSummary() :- p99 is the smallest sample not below 99 % of the window
+//
+int GrassProfileStatSummary( const GRASS_PROFILE_STAT *stat, float *minValue, float *avgValue, float *p99Value)
+{
+    //variable declarations
+    float sorted[ GRASS_PROFILE_STAT_WINDOW];
+    double sum = 0.0;
+
+    //code
+    if( stat->count == 0)
+    {
+        return( 0);
+    }
+
+    for( int i = 0; i < stat->count; i++)
+    {
+        sorted[i] = stat->sample[i];
+        sum += stat->sample[i];
+    }
+    std::sort( sorted, sorted + stat->count);
+
+    int p99Index = ( 99 * stat->count + 99) / 100 - 1;
+
+    *minValue = sorted[0];
+    *avgValue = (float)( sum / stat->count);
+    *p99Value = sorted[ p99Index];
+
+    return( stat->count);
+}
+
+//
+//CopyProfileZones() :- complete zones of the ring, oldest first, into a malloc()ed array
+//
+static GRASS_PROFILE_ZONE *CopyProfileZones( int *zoneCount)
+{
+    //code
+    *zoneCount = 0;
+
+    GRASS_PROFILE_ZONE *zones = (GRASS_PROFILE_ZONE *) malloc( GRASS_PROFILE_CAPACITY * sizeof( GRASS_PROFILE_ZONE));
+    if( zones == NULL)
+    {
+        return( NULL);
+    }
+
+    unsigned long long head = gProfileHead.load( std::memory_order_acquire);
+    unsigned long long first = ( head > GRASS_PROFILE_CAPACITY) ? head - GRASS_PROFILE_CAPACITY : 0;
+
+    for( unsigned long long index = first; index < head; index++)
+    {
+        GRASS_PROFILE_SLOT *slot = &gProfileSlots[ index & ( GRASS_PROFILE_CAPACITY - 1)];
+
+            //skip zones still being written or already overwritten by a newer one
+        unsigned long long sequence = slot->sequence.load( std::memory_order_acquire);
+        if( sequence != 2 * index + 2)
+        {
+            continue;
+        }
+
+        GRASS_PROFILE_ZONE zone = slot->zone;
+
+        std::atomic_thread_fence( std::memory_order_acquire);
+        if( slot->sequence.load( std::memory_order_relaxed) != sequence)
+        {
+            continue;
+        }
+
+        zones[ (*zoneCount)++] = zone;
+    }
+
+    return( zones);
+}
+
+//
+//GrassProfileWriteTrace() :- Chrome trace event format, one complete ( "X") event per zone
+//
+int GrassProfileWriteTrace( const char *fileName)
+{
+    //variable declarations
+    int zoneCount;
+
+    //code
+    FILE *fp = fopen( fileName, "w");
+    if( fp == NULL)
+    {
+        return(-1);
+    }
+
+    GRASS_PROFILE_ZONE *zones = CopyProfileZones( &zoneCount);
+
+    fprintf( fp, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+    fprintf( fp, "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %u, \"args\": {\"name\": \"OpenCL queue\"}}%s\n",
+        GRASS_PROFILE_TRACK_OPENCL, ( zoneCount > 0) ? "," : "");
+    for( int i = 0; i < zoneCount; i++)
+    {
+            //timestamps in microseconds
+        fprintf( fp, "{\"name\": \"%s\", \"cat\": \"grass\", \"ph\": \"X\", \"pid\": 1, \"tid\": %u, \"ts\": %.3f, \"dur\": %.3f, \"args\": {\"frame\": %u}}%s\n",
+            zones[i].name, zones[i].thread, zones[i].beginNs * 1.0e-3, ( zones[i].endNs - zones[i].beginNs) * 1.0e-3, zones[i].frame,
+            ( i + 1 < zoneCount) ? "," : "");
+    }
+    fprintf( fp, "]}\n");
+
+    fclose( fp);
+    free( zones);
+
+    return( zoneCount);
+}
+
+//
+//GrassProfileWriteCsv() :- frame, thread, zone, begin and duration in microseconds
+//
+int GrassProfileWriteCsv( const char *fileName)
+{
+    //variable declarations
+    int zoneCount;
+
+    //code
+    FILE *fp = fopen( fileName, "w");
+    if( fp == NULL)
+    {
+        return(-1);
+    }
+
+    GRASS_PROFILE_ZONE *zones = CopyProfileZones( &zoneCount);
+
+    fprintf( fp, "frame,thread,zone,begin_us,duration_us\n");
+    for( int i = 0; i < zoneCount; i++)
+    {
+        fprintf( fp, "%u,%u,%s,%.3f,%.3f\n", zones[i].frame, zones[i].thread, zones[i].name,
+            zones[i].beginNs * 1.0e-3, ( zones[i].endNs - zones[i].beginNs) * 1.0e-3);
+    }
+
+    fclose( fp);
+    free( zones);
+
+    return( zoneCount);
+}
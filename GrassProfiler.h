@@ -0,0 +1,95 @@
+#ifndef __GRASS_PROFILER_H__
+#define __GRASS_PROFILER_H__
+
+/*
+ * Scoped CPU timing zones for the frame.
+ *
+ * A zone is recorded when its GrassProfileScope goes out of scope, into a
+ * fixed ring of the last GRASS_PROFILE_CAPACITY zones. Any thread may record:
+ * a slot is claimed with one atomic add and published with its sequence
+ * number, no locks. GrassProfileWriteTrace() / GrassProfileWriteCsv() copy
+ * the ring out on demand, zones overwritten while copying are skipped.
+ *
+ * Zones timed by someone else ( OpenCL event timestamps) go to their own
+ * track with GrassProfileRecordTrack(), GRASS_PROFILE_STAT keeps a rolling
+ * min / avg / p99 of a per frame value for the HUD.
+ */
+
+//macro
+#define  GRASS_PROFILE_CAPACITY     65536   //zones kept, power of two, the oldest are overwritten
+#define  GRASS_PROFILE_STAT_WINDOW  128     //samples of a GRASS_PROFILE_STAT
+
+#define  GRASS_PROFILE_TRACK_OPENCL 1000    //'thread' of the OpenCL command zones, above any real thread id
+
+//one finished zone
+typedef struct GRASS_PROFILE_ZONE
+{
+    const char *name;       //string literal, not copied
+    long long beginNs;      //since the first GrassProfileNow()
+    long long endNs;
+    unsigned int frame;     //GrassProfileBeginFrame() count when the zone ended
+    unsigned int thread;    //small per thread id, 0 : first thread that recorded
+} GRASS_PROFILE_ZONE;
+
+//last GRASS_PROFILE_STAT_WINDOW samples of a value, zero initialize
+typedef struct GRASS_PROFILE_STAT
+{
+    float sample[ GRASS_PROFILE_STAT_WINDOW];
+    int count;      //samples kept, up to GRASS_PROFILE_STAT_WINDOW
+    int next;       //slot of the next sample
+} GRASS_PROFILE_STAT;
+
+
+//function declarations
+
+    //monotonic high resolution time in ns since the first call
+long long GrassProfileNow( void);
+    //in seconds, for animation time
+double GrassProfileSeconds( void);
+
+    //start of the next frame, return its number
+unsigned int GrassProfileBeginFrame( void);
+
+    //add a finished zone, 'name' has to outlive the profiler ( string literal)
+void GrassProfileRecord( const char *name, long long beginNs, long long endNs);
+    //same on a fixed track ( GRASS_PROFILE_TRACK_*) instead of the calling thread
+void GrassProfileRecordTrack( const char *name, long long beginNs, long long endNs, unsigned int track);
+
+    //rolling statistics, summary returns the number of samples ( 0 : outputs untouched)
+void GrassProfileStatAdd( GRASS_PROFILE_STAT *stat, float value);
+int GrassProfileStatSummary( const GRASS_PROFILE_STAT *stat, float *minValue, float *avgValue, float *p99Value);
+
+    //zones of the ring, oldest first, as a Chrome trace ( chrome://tracing, Perfetto) or CSV
+    //return number of zones written, -1 when the file cannot be created
+int GrassProfileWriteTrace( const char *fileName);
+int GrassProfileWriteCsv( const char *fileName);
+
+
+//zone from construction to end of scope
+class GrassProfileScope
+{
+    public:
+        GrassProfileScope( const char *name)
+        {
+            this->name = name;
+            this->beginNs = GrassProfileNow();
+        }
+
+        ~GrassProfileScope()
+        {
+            GrassProfileRecord( this->name, this->beginNs, GrassProfileNow());
+        }
+
+    private:
+        const char *name;
+        long long beginNs;
+
+        GrassProfileScope( const GrassProfileScope &);
+        GrassProfileScope& operator=( const GrassProfileScope &);
+};
+
+#define  GRASS_PROFILE_CONCAT_( a, b)   a##b
+#define  GRASS_PROFILE_CONCAT( a, b)    GRASS_PROFILE_CONCAT_( a, b)
+#define  GRASS_PROFILE_SCOPE( name)     GrassProfileScope GRASS_PROFILE_CONCAT( grassProfileScope, __LINE__)( name)
+
+#endif
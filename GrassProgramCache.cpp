@@ -0,0 +1,269 @@
+/*
+ * On disk cache of built OpenCL programs, see GrassProgramCache.h
+ *
+ * Created By Vijaykumar Dangi
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "GrassProgramCache.h"
+
+//
+//HashBytes() :- 64 bit FNV-1a, continued from 'hash'
+//
+static unsigned long long HashBytes( unsigned long long hash, const void *data, size_t size)
+{
+    //variable declarations
+    const unsigned char *bytes = (const unsigned char *)data;
+
+    //code
+    for( size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ULL;
+    }
+
+    return( hash);
+}
+
+//
+//HashDeviceInfo() :- one string property of the device into the key, NUL included as separator
+//
+static unsigned long long HashDeviceInfo( unsigned long long hash, cl_device_id device, cl_device_info info)
+{
+    //variable declarations
+    char value[ 1024];
+    size_t size = 0;
+
+    //code
+    if( clGetDeviceInfo( device, info, sizeof( value), value, &size) != CL_SUCCESS)
+    {
+        size = 0;
+    }
+
+    return( HashBytes( hash, value, size));
+}
+
+//
+//GrassDeviceHash()
+//
+unsigned long long GrassDeviceHash( cl_device_id device)
+{
+    //variable declarations
+    unsigned long long hash = 0xcbf29ce484222325ULL;
+
+    //code
+    hash = HashDeviceInfo( hash, device, CL_DEVICE_NAME);
+    hash = HashDeviceInfo( hash, device, CL_DEVICE_VENDOR);
+    hash = HashDeviceInfo( hash, device, CL_DEVICE_VERSION);
+    hash = HashDeviceInfo( hash, device, CL_DRIVER_VERSION);
+
+    return( hash);
+}
+
+//
+//ProgramCacheKey()
+//
+static unsigned long long ProgramCacheKey( cl_device_id device, const char *source, const char *options)
+{
+    //variable declarations
+    unsigned long long deviceHash = GrassDeviceHash( device);
+
+    //code
+    unsigned long long hash = HashBytes( 0xcbf29ce484222325ULL, source, strlen( source) + 1);
+    hash = HashBytes( hash, options, strlen( options) + 1);
+    hash = HashBytes( hash, &deviceHash, sizeof( deviceHash));
+
+    return( hash);
+}
+
+//
+//LoadProgramBinary() :- binary stored under 'key', NULL when missing or not complete, free() it
+//
+static unsigned char *LoadProgramBinary( const char *fileName, unsigned long long key, size_t *binarySize)
+{
+    //variable declarations
+    char magic[ 8];
+    unsigned long long storedKey, storedSize;
+
+    //code
+    FILE *fp = fopen( fileName, "rb");
+    if( fp == NULL)
+    {
+        return( NULL);
+    }
+
+    if( (fread( magic, 1, sizeof( magic), fp) != sizeof( magic)) || (memcmp( magic, GRASS_PROGRAM_CACHE_MAGIC, sizeof( magic)) != 0) ||
+        (fread( &storedKey, sizeof( storedKey), 1, fp) != 1) || (storedKey != key) ||
+        (fread( &storedSize, sizeof( storedSize), 1, fp) != 1) || (storedSize == 0))
+    {
+        fclose( fp);
+        return( NULL);
+    }
+
+    unsigned char *binary = (unsigned char *) malloc( (size_t)storedSize);
+    if( (binary == NULL) || (fread( binary, 1, (size_t)storedSize, fp) != (size_t)storedSize))
+    {
+        free( binary);
+        fclose( fp);
+        return( NULL);
+    }
+
+    fclose( fp);
+
+    *binarySize = (size_t)storedSize;
+    return( binary);
+}
+
+//
+//StoreProgramBinary() :- CL_PROGRAM_BINARIES of the built program, written to a temporary file and renamed
+//                        so a crash never leaves a half written entry under the real name
+//
+static void StoreProgramBinary( const char *fileName, unsigned long long key, cl_program program)
+{
+    //variable declarations
+    char tempFileName[ 512 + 8];
+    size_t binarySize = 0;
+    unsigned long long storedSize;
+
+    //code
+    if( (clGetProgramInfo( program, CL_PROGRAM_BINARY_SIZES, sizeof( size_t), &binarySize, NULL) != CL_SUCCESS) || (binarySize == 0))
+    {
+        return;
+    }
+
+    unsigned char *binary = (unsigned char *) malloc( binarySize);
+    if( binary == NULL)
+    {
+        return;
+    }
+
+    if( clGetProgramInfo( program, CL_PROGRAM_BINARIES, sizeof( unsigned char *), &binary, NULL) != CL_SUCCESS)
+    {
+        free( binary);
+        return;
+    }
+
+    snprintf( tempFileName, sizeof( tempFileName), "%s.tmp", fileName);
+
+    FILE *fp = fopen( tempFileName, "wb");
+    if( fp == NULL)
+    {
+        free( binary);
+        return;
+    }
+
+    storedSize = binarySize;
+    bool written = (fwrite( GRASS_PROGRAM_CACHE_MAGIC, 1, 8, fp) == 8) &&
+                   (fwrite( &key, sizeof( key), 1, fp) == 1) &&
+                   (fwrite( &storedSize, sizeof( storedSize), 1, fp) == 1) &&
+                   (fwrite( binary, 1, binarySize, fp) == binarySize);
+    written = (fclose( fp) == 0) && written;
+
+    free( binary);
+
+    remove( fileName);
+    if( !written || (rename( tempFileName, fileName) != 0))
+    {
+        remove( tempFileName);
+    }
+}
+
+//
+//BuildProgramFromSource()
+//
+static cl_program BuildProgramFromSource( cl_context context, cl_device_id device, const char *source, const char *options, cl_int *result)
+{
+    //variable declarations
+    size_t sourceSize = strlen( source);
+
+    //code
+    cl_program program = clCreateProgramWithSource( context, 1, &source, &sourceSize, result);
+    if( *result != CL_SUCCESS)
+    {
+        return( NULL);
+    }
+
+    *result = clBuildProgram( program, 1, &device, options, NULL, NULL);
+
+    return( program);
+}
+
+//
+//GrassBuildProgramCached()
+//
+cl_program GrassBuildProgramCached( cl_context context, cl_device_id device, const char *source, const char *options,
+    const char *cachePrefix, GRASS_PROGRAM_SOURCE *programSource, cl_int *result)
+{
+    //variable declarations
+    char fileName[ 512];
+    size_t binarySize = 0;
+    cl_int binaryStatus = CL_SUCCESS;
+    cl_program program;
+
+    //code
+    *programSource = GRASS_PROGRAM_FROM_SOURCE;
+
+    if( cachePrefix == NULL)
+    {
+        return( BuildProgramFromSource( context, device, source, options, result));
+    }
+
+    unsigned long long key = ProgramCacheKey( device, source, options);
+    snprintf( fileName, sizeof( fileName), "%s_%016llx.bin", cachePrefix, key);
+
+    unsigned char *binary = LoadProgramBinary( fileName, key, &binarySize);
+    if( binary != NULL)
+    {
+        program = clCreateProgramWithBinary( context, 1, &device, &binarySize, (const unsigned char **)&binary, &binaryStatus, result);
+        free( binary);
+
+            //a binary still has to be built ( linked) for the device
+        if( (*result == CL_SUCCESS) && (binaryStatus == CL_SUCCESS))
+        {
+            *result = clBuildProgram( program, 1, &device, options, NULL, NULL);
+            if( *result == CL_SUCCESS)
+            {
+                *programSource = GRASS_PROGRAM_FROM_BINARY;
+                return( program);
+            }
+        }
+
+        if( program != NULL)
+        {
+            clReleaseProgram( program);
+        }
+        *programSource = GRASS_PROGRAM_REBUILT;
+    }
+
+    program = BuildProgramFromSource( context, device, source, options, result);
+    if( (program != NULL) && (*result == CL_SUCCESS))
+    {
+        StoreProgramBinary( fileName, key, program);
+    }
+
+    return( program);
+}
+
+//
+//GrassProgramSourceName()
+//
+const char *GrassProgramSourceName( GRASS_PROGRAM_SOURCE programSource)
+{
+    //code
+    switch( programSource)
+    {
+        case GRASS_PROGRAM_FROM_BINARY:
+            return( "cached binary");
+
+        case GRASS_PROGRAM_REBUILT:
+            return( "source, cached binary rejected");
+
+        default:
+        break;
+    }
+
+    return( "source");
+}
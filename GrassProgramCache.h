@@ -0,0 +1,43 @@
+#ifndef __GRASS_PROGRAM_CACHE_H__
+#define __GRASS_PROGRAM_CACHE_H__
+
+/*
+ * On disk cache of built OpenCL programs.
+ *
+ * The key is a 64 bit hash of the kernel source, the build options and the
+ * device name, vendor, version and driver version, so a new driver or an
+ * edited Grass.cl misses and rebuilds from source. A hit loads the stored
+ * CL_PROGRAM_BINARIES with clCreateProgramWithBinary(), a binary the driver
+ * rejects is rebuilt from source and overwritten.
+ */
+
+#include <CL/opencl.h>
+
+//macro
+#define  GRASS_PROGRAM_CACHE_MAGIC  "GRASSCLB"      //file header, then key, binary size and binary
+
+//how GrassBuildProgramCached() got its program
+typedef enum GRASS_PROGRAM_SOURCE
+{
+    GRASS_PROGRAM_FROM_SOURCE = 0,      //key missed ( or no cache), built and stored
+    GRASS_PROGRAM_FROM_BINARY,          //key hit
+    GRASS_PROGRAM_REBUILT               //key hit, binary rejected, built from source again
+} GRASS_PROGRAM_SOURCE;
+
+
+//function declarations
+
+    //program of 'source' built for 'device' with 'options', through "<cachePrefix>_<key>.bin"
+    //( cachePrefix NULL : no cache). Return NULL when the program cannot be created, else the
+    //program with *result = clBuildProgram() result, the caller reads the build log on failure
+cl_program GrassBuildProgramCached( cl_context context, cl_device_id device, const char *source, const char *options,
+    const char *cachePrefix, GRASS_PROGRAM_SOURCE *programSource, cl_int *result);
+
+    //64 bit hash of the device name, vendor, version and driver version, also keys
+    //per device files other than the program cache ( GrassWorkGroupTuner.h)
+unsigned long long GrassDeviceHash( cl_device_id device);
+
+    //human readable GRASS_PROGRAM_SOURCE
+const char *GrassProgramSourceName( GRASS_PROGRAM_SOURCE programSource);
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef __GRASS_SIMD_H__
+#define __GRASS_SIMD_H__
+
+/*
+ * Vectorized blade generator for the compact (GRASS_BLADE_SOA) layout.
+ *
+ * Each kernel lives in its own translation unit built for its instruction
+ * set (GrassSimdAVX2.cpp, GrassSimdAVX512.cpp) and processes 8 / 16 blades
+ * per iteration. GrassField picks one at run time with GrassSimdDefault(),
+ * the scalar simulateCompact() handles the remaining blades.
+ */
+
+#include <stddef.h>
+
+#include "GrassTypes.h"
+
+enum GRASS_SIMD_LEVEL
+{
+    GRASS_SIMD_SCALAR = 0,
+    GRASS_SIMD_AVX2,        //8 blades per iteration, AVX2 + FMA
+    GRASS_SIMD_AVX512       //16 blades per iteration, AVX-512F
+};
+
+//everything one kernel call needs, filled by GrassField::simulate()
+typedef struct GRASS_SIMD_BATCH
+{
+    const VERTEX *meshVertices;     //NULL : roots from 'grid'
+    GRASS_GRID grid;
+
+        //GRASS_BLADE_SOA arrays
+    const float *facingSin;
+    const float *facingCos;
+    const float *bendSin;
+    const float *width;
+    const float *height;
+    const float *forward;
+
+        //per segment t and pow( t, 2 * curvature)
+    int segments;
+    const float *segmentT;
+    const float *segmentCurve;
+
+        //wind distortion map and its transform for this frame
+    int windWidth;
+    int windHeight;
+    const float *windTexels;
+    const unsigned char *windPacked;    //GRASS_WIND_MAP::packed, NULL : gather windTexels
+    int windBlockColumns;
+    bool windBilinear;
+    float windScale[2];
+    float windParam[2];
+    float windStrength;
+    bool windProcedural;                //windModel instead of the texture
+    GRASS_PROCEDURAL_WIND windModel;
+    float windTime;
+
+        //blade i is written at outVertices + ( i - outFirstBlade) * 2 * segments
+    GRASS_VERTEX *outVertices;
+    int outFirstBlade;
+} GRASS_SIMD_BATCH;
+
+
+//function declarations
+
+    //highest level supported by both the CPU / OS and this build
+GRASS_SIMD_LEVEL GrassSimdDetect( void);
+    //level GrassField starts with : AVX2 when supported, AVX-512 only on request ( setSimdLevel()),
+    //its 16 lane kernel measured slower than AVX2 ( frequency license, wider gathers)
+GRASS_SIMD_LEVEL GrassSimdDefault( void);
+const char *GrassSimdName( GRASS_SIMD_LEVEL level);
+
+    //generate blades [bladeBegin, bladeEnd) in whole SIMD groups
+    //return number of blades written starting at bladeBegin (0 when the kernel is not compiled in)
+int GrassSimulateAVX2( const GRASS_SIMD_BATCH *batch, int bladeBegin, int bladeEnd);
+int GrassSimulateAVX512( const GRASS_SIMD_BATCH *batch, int bladeBegin, int bladeEnd);
+
+    //blades per iteration, 0 when the kernel is not compiled in
+int GrassSimdAVX2Lanes( void);
+int GrassSimdAVX512Lanes( void);
+
+#endif
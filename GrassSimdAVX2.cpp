@@ -0,0 +1,86 @@
+/*
+ * AVX2 + FMA blade generator, 8 blades per iteration
+ *
+ * gcc / clang : build this file with -mavx2 -mfma (see build.sh), without
+ * them only the stub is compiled and GrassField stays on the scalar path.
+ *
+ * Created By Vijaykumar Dangi
+ */
+
+#include "GrassSimd.h"
+
+#if ( defined(__AVX2__) && defined(__FMA__)) || ( defined(_MSC_VER) && ( defined(_M_X64) || defined(_M_IX86)))
+
+#include <immintrin.h>
+
+//macro
+#define  VEC                __m256
+#define  IVEC               __m256i
+#define  GRASS_SIMD_LANES   8
+
+#define  VSET1( a)          _mm256_set1_ps( a)
+#define  VLOADU( p)         _mm256_loadu_ps( p)
+#define  VADD( a, b)        _mm256_add_ps( a, b)
+#define  VSUB( a, b)        _mm256_sub_ps( a, b)
+#define  VMUL( a, b)        _mm256_mul_ps( a, b)
+#define  VDIV( a, b)        _mm256_div_ps( a, b)
+#define  VSQRT( a)          _mm256_sqrt_ps( a)
+#define  VFMADD( a, b, c)   _mm256_fmadd_ps( a, b, c)
+#define  VFLOOR( a)         _mm256_floor_ps( a)
+#define  VROUND( a)         _mm256_round_ps( a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)
+#define  VXOR( a, b)        _mm256_xor_ps( a, b)
+#define  VMIN( a, b)         _mm256_min_ps( a, b)
+#define  VMAX( a, b)         _mm256_max_ps( a, b)
+#define  VGATHER( p, i)     _mm256_i32gather_ps( p, i, 4)
+
+#define  IVSET1( a)         _mm256_set1_epi32( a)
+#define  IVINDEX            _mm256_setr_epi32( 0, 1, 2, 3, 4, 5, 6, 7)
+#define  IVADD( a, b)       _mm256_add_epi32( a, b)
+#define  IVMULLO( a, b)     _mm256_mullo_epi32( a, b)
+#define  IVAND( a, b)       _mm256_and_si256( a, b)
+#define  IVXOR( a, b)       _mm256_xor_si256( a, b)
+#define  IVSLLI( a, n)      _mm256_slli_epi32( a, n)
+#define  IVSRLI( a, n)      _mm256_srli_epi32( a, n)
+#define  IVSUB( a, b)       _mm256_sub_epi32( a, b)
+#define  IVCMPGT( a, b)     _mm256_cmpgt_epi32( a, b)
+#define  IVGATHER8( p, i)   _mm256_i32gather_epi32( (const int *)(p), i, 1)
+
+#define  VCVTTI( a)         _mm256_cvttps_epi32( a)
+#define  VCVTIF( a)         _mm256_cvtepi32_ps( a)
+#define  VCASTIF( a)        _mm256_castsi256_ps( a)
+#define  VSELECT( m, a, b)  _mm256_blendv_ps( b, a, _mm256_castsi256_ps( _mm256_cmpgt_epi32( m, _mm256_setzero_si256())))
+#define  VHALF( v, h)       (v)
+
+#include "GrassSimdKernel.h"
+
+//
+//GrassSimulateAVX2()
+//
+int GrassSimulateAVX2( const GRASS_SIMD_BATCH *batch, int bladeBegin, int bladeEnd)
+{
+    //code
+    return( GrassSimdSimulate( batch, bladeBegin, bladeEnd));
+}
+
+//
+//GrassSimdAVX2Lanes()
+//
+int GrassSimdAVX2Lanes( void)
+{
+    //code
+    return( GRASS_SIMD_LANES);
+}
+
+#else
+
+int GrassSimulateAVX2( const GRASS_SIMD_BATCH *batch, int bladeBegin, int bladeEnd)
+{
+    return( 0);
+}
+
+int GrassSimdAVX2Lanes( void)
+{
+    return( 0);
+}
+
+#endif
@@ -0,0 +1,86 @@
+/*
+ * AVX-512F blade generator, 16 blades per iteration
+ *
+ * gcc / clang : build this file with -mavx512f -mavx2 -mfma (see build.sh), without
+ * them only the stub is compiled and GrassField stays on the scalar path.
+ *
+ * Created By Vijaykumar Dangi
+ */
+
+#include "GrassSimd.h"
+
+#if ( defined(__AVX512F__) && defined(__FMA__)) || ( defined(_MSC_VER) && defined(_M_X64) && ( _MSC_VER >= 1911))
+
+#include <immintrin.h>
+
+//macro
+#define  VEC                __m512
+#define  IVEC               __m512i
+#define  GRASS_SIMD_LANES   16
+
+#define  VSET1( a)          _mm512_set1_ps( a)
+#define  VLOADU( p)         _mm512_loadu_ps( p)
+#define  VADD( a, b)        _mm512_add_ps( a, b)
+#define  VSUB( a, b)        _mm512_sub_ps( a, b)
+#define  VMUL( a, b)        _mm512_mul_ps( a, b)
+#define  VDIV( a, b)        _mm512_div_ps( a, b)
+#define  VSQRT( a)          _mm512_sqrt_ps( a)
+#define  VFMADD( a, b, c)   _mm512_fmadd_ps( a, b, c)
+#define  VFLOOR( a)         _mm512_roundscale_ps( a, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC)
+#define  VROUND( a)         _mm512_roundscale_ps( a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)
+#define  VXOR( a, b)        _mm512_castsi512_ps( _mm512_xor_si512( _mm512_castps_si512( a), _mm512_castps_si512( b)))
+#define  VMIN( a, b)         _mm512_min_ps( a, b)
+#define  VMAX( a, b)         _mm512_max_ps( a, b)
+#define  VGATHER( p, i)     _mm512_i32gather_ps( i, p, 4)
+
+#define  IVSET1( a)         _mm512_set1_epi32( a)
+#define  IVINDEX            _mm512_setr_epi32( 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15)
+#define  IVADD( a, b)       _mm512_add_epi32( a, b)
+#define  IVMULLO( a, b)     _mm512_mullo_epi32( a, b)
+#define  IVAND( a, b)       _mm512_and_si512( a, b)
+#define  IVXOR( a, b)       _mm512_xor_si512( a, b)
+#define  IVSLLI( a, n)      _mm512_slli_epi32( a, n)
+#define  IVSRLI( a, n)      _mm512_srli_epi32( a, n)
+#define  IVSUB( a, b)       _mm512_sub_epi32( a, b)
+#define  IVCMPGT( a, b)     _mm512_maskz_mov_epi32( _mm512_cmpgt_epi32_mask( a, b), _mm512_set1_epi32( -1))
+#define  IVGATHER8( p, i)   _mm512_i32gather_epi32( i, (const void *)(p), 1)
+
+#define  VCVTTI( a)         _mm512_cvttps_epi32( a)
+#define  VCVTIF( a)         _mm512_cvtepi32_ps( a)
+#define  VCASTIF( a)        _mm512_castsi512_ps( a)
+#define  VSELECT( m, a, b)  _mm512_mask_blend_ps( _mm512_test_epi32_mask( m, m), b, a)
+#define  VHALF( v, h)       _mm256_castpd_ps( _mm512_extractf64x4_pd( _mm512_castps_pd( v), h))
+
+#include "GrassSimdKernel.h"
+
+//
+//GrassSimulateAVX512()
+//
+int GrassSimulateAVX512( const GRASS_SIMD_BATCH *batch, int bladeBegin, int bladeEnd)
+{
+    //code
+    return( GrassSimdSimulate( batch, bladeBegin, bladeEnd));
+}
+
+//
+//GrassSimdAVX512Lanes()
+//
+int GrassSimdAVX512Lanes( void)
+{
+    //code
+    return( GRASS_SIMD_LANES);
+}
+
+#else
+
+int GrassSimulateAVX512( const GRASS_SIMD_BATCH *batch, int bladeBegin, int bladeEnd)
+{
+    return( 0);
+}
+
+int GrassSimdAVX512Lanes( void)
+{
+    return( 0);
+}
+
+#endif
@@ -0,0 +1,493 @@
+/*
+ * Vectorized blade generator body, included once by each SIMD translation unit.
+ *
+ * The including file defines the vector type and operation macros for its
+ * instruction set (see GrassSimdAVX2.cpp), this file only does the math.
+ * Lanes are blades : the GRASS_BLADE_SOA arrays are loaded directly, grid
+ * vertices and wind texels are gathered (roots of a procedural GRASS_GRID
+ * are computed), and the per segment vertices are transposed back to
+ * GRASS_VERTEX (8 floats) before the store.
+ *
+ * Same math as GrassField::simulateCompact(), rotations are expanded with
+ * their known zero terms and sin / cos of the wind angle use a polynomial.
+ *
+ * required macros :
+ *  VEC, IVEC, GRASS_SIMD_LANES
+ *  VSET1, VLOADU, VADD, VSUB, VMUL, VDIV, VSQRT, VFMADD( a, b, c) = a * b + c,
+ *  VFLOOR, VROUND (nearest), VXOR, VMIN, VMAX, VGATHER( base, index),
+ *  IVSET1, IVINDEX (0, 1, .. lanes - 1), IVADD, IVSUB, IVMULLO, IVAND, IVXOR, IVSLLI, IVSRLI (logical),
+ *  IVCMPGT (all bits set where a > b), IVGATHER8( bytes, byteOffset) (32 bit loads at byte offsets),
+ *  VCVTTI (float to int, truncate), VCVTIF (int to float), VCASTIF (bit cast),
+ *  VSELECT( mask, a, b) (a where mask != 0, else b), VHALF( v, h) (h-th group of 8 lanes as __m256, h constant)
+ */
+
+#ifndef __GRASS_SIMD_KERNEL_H__
+#define __GRASS_SIMD_KERNEL_H__
+
+//
+//GrassSimdStoreVertices8() :- c[k] holds component k of 8 blades, write one GRASS_VERTEX per blade
+//
+static inline void GrassSimdStoreVertices8( const __m256 c[8], GRASS_VERTEX *out, size_t stride)
+{
+    //code
+    __m256 t0 = _mm256_unpacklo_ps( c[0], c[1]);
+    __m256 t1 = _mm256_unpackhi_ps( c[0], c[1]);
+    __m256 t2 = _mm256_unpacklo_ps( c[2], c[3]);
+    __m256 t3 = _mm256_unpackhi_ps( c[2], c[3]);
+    __m256 t4 = _mm256_unpacklo_ps( c[4], c[5]);
+    __m256 t5 = _mm256_unpackhi_ps( c[4], c[5]);
+    __m256 t6 = _mm256_unpacklo_ps( c[6], c[7]);
+    __m256 t7 = _mm256_unpackhi_ps( c[6], c[7]);
+
+    __m256 s0 = _mm256_shuffle_ps( t0, t2, _MM_SHUFFLE( 1, 0, 1, 0));
+    __m256 s1 = _mm256_shuffle_ps( t0, t2, _MM_SHUFFLE( 3, 2, 3, 2));
+    __m256 s2 = _mm256_shuffle_ps( t1, t3, _MM_SHUFFLE( 1, 0, 1, 0));
+    __m256 s3 = _mm256_shuffle_ps( t1, t3, _MM_SHUFFLE( 3, 2, 3, 2));
+    __m256 s4 = _mm256_shuffle_ps( t4, t6, _MM_SHUFFLE( 1, 0, 1, 0));
+    __m256 s5 = _mm256_shuffle_ps( t4, t6, _MM_SHUFFLE( 3, 2, 3, 2));
+    __m256 s6 = _mm256_shuffle_ps( t5, t7, _MM_SHUFFLE( 1, 0, 1, 0));
+    __m256 s7 = _mm256_shuffle_ps( t5, t7, _MM_SHUFFLE( 3, 2, 3, 2));
+
+    _mm256_storeu_ps( out[0 * stride].position, _mm256_permute2f128_ps( s0, s4, 0x20));
+    _mm256_storeu_ps( out[1 * stride].position, _mm256_permute2f128_ps( s1, s5, 0x20));
+    _mm256_storeu_ps( out[2 * stride].position, _mm256_permute2f128_ps( s2, s6, 0x20));
+    _mm256_storeu_ps( out[3 * stride].position, _mm256_permute2f128_ps( s3, s7, 0x20));
+    _mm256_storeu_ps( out[4 * stride].position, _mm256_permute2f128_ps( s0, s4, 0x31));
+    _mm256_storeu_ps( out[5 * stride].position, _mm256_permute2f128_ps( s1, s5, 0x31));
+    _mm256_storeu_ps( out[6 * stride].position, _mm256_permute2f128_ps( s2, s6, 0x31));
+    _mm256_storeu_ps( out[7 * stride].position, _mm256_permute2f128_ps( s3, s7, 0x31));
+}
+
+//
+//GrassSimdStoreVertices() :- c[k] holds component k of GRASS_SIMD_LANES blades
+//
+static inline void GrassSimdStoreVertices( const VEC c[8], GRASS_VERTEX *out, size_t stride)
+{
+    //variable declarations
+    __m256 half[8];
+
+    //code
+    for( int k = 0; k < 8; k++)
+    {
+        half[k] = VHALF( c[k], 0);
+    }
+    GrassSimdStoreVertices8( half, out, stride);
+
+#if GRASS_SIMD_LANES == 16
+    for( int k = 0; k < 8; k++)
+    {
+        half[k] = VHALF( c[k], 1);
+    }
+    GrassSimdStoreVertices8( half, out + 8 * stride, stride);
+#endif
+}
+
+//
+//GrassSimdSinCos() :- sin / cos for |x| up to a few PI (Cody-Waite reduction to [-PI/4, PI/4])
+//
+static inline void GrassSimdSinCos( VEC x, VEC *sinOut, VEC *cosOut)
+{
+    //code
+    VEC j = VROUND( VMUL( x, VSET1( 0.63661977236758134f)));     //x * 2 / PI
+    VEC r = VFMADD( j, VSET1( -1.5707963705062866211f), x);
+    r = VFMADD( j, VSET1( 4.3711388286737928865e-08f), r);
+
+    VEC r2 = VMUL( r, r);
+
+    VEC sr = VFMADD( r2, VSET1( -1.9515295891e-4f), VSET1( 8.3321608736e-3f));
+    sr = VFMADD( sr, r2, VSET1( -1.6666654611e-1f));
+    sr = VFMADD( VMUL( sr, r2), r, r);
+
+    VEC cr = VFMADD( r2, VSET1( 2.443315711809948e-5f), VSET1( -1.388731625493765e-3f));
+    cr = VFMADD( cr, r2, VSET1( 4.166664568298827e-2f));
+    cr = VFMADD( VMUL( cr, r2), r2, VFMADD( r2, VSET1( -0.5f), VSET1( 1.0f)));
+
+        //quadrant : sin = sr, cr, -sr, -cr   cos = cr, -sr, -cr, sr
+    IVEC q = VCVTTI( j);
+    IVEC swap = IVAND( q, IVSET1( 1));
+    VEC sinSign = VCASTIF( IVSLLI( IVAND( q, IVSET1( 2)), 30));
+    VEC cosSign = VCASTIF( IVSLLI( IVAND( IVADD( q, IVSET1( 1)), IVSET1( 2)), 30));
+
+    *sinOut = VXOR( VSELECT( swap, cr, sr), sinSign);
+    *cosOut = VXOR( VSELECT( swap, sr, cr), cosSign);
+}
+
+//
+//GrassSimdMat3Multiply() :- r = a * b, column major m[column][row]
+//
+static inline void GrassSimdMat3Multiply( VEC r[3][3], const VEC a[3][3], const VEC b[3][3])
+{
+    //code
+    for( int j = 0; j < 3; j++)
+    {
+        for( int k = 0; k < 3; k++)
+        {
+            r[j][k] = VFMADD( a[2][k], b[j][2], VFMADD( a[1][k], b[j][1], VMUL( a[0][k], b[j][0])));
+        }
+    }
+}
+
+//
+//GrassSimdPackedTexel() :- red / green ( 0 - 255) of packed wind texels ( x, y), see GRASS_WIND_TEXEL_OFFSET
+//
+static inline void GrassSimdPackedTexel( const unsigned char *packed, IVEC x, IVEC y, IVEC blockColumns, VEC *red, VEC *green)
+{
+    //code
+    const IVEC blockMask = IVSET1( (1 << GRASS_WIND_BLOCK_SHIFT) - 1);
+    const IVEC byteMask = IVSET1( 0xFF);
+
+    IVEC block = IVADD( IVMULLO( IVSRLI( y, GRASS_WIND_BLOCK_SHIFT), blockColumns), IVSRLI( x, GRASS_WIND_BLOCK_SHIFT));
+    IVEC offset = IVADD( IVSLLI( block, 2 * GRASS_WIND_BLOCK_SHIFT),
+                         IVADD( IVSLLI( IVAND( y, blockMask), GRASS_WIND_BLOCK_SHIFT), IVAND( x, blockMask)));
+
+        //red, green and the 2 bytes of the next texel ( the packed map is padded for the last one)
+    IVEC texel = IVGATHER8( packed, IVSLLI( offset, 1));
+
+    *red = VCVTIF( IVAND( texel, byteMask));
+    *green = VCVTIF( IVAND( IVSRLI( texel, 8), byteMask));
+}
+
+//
+//GrassSimdSampleWind() :- wind texel red / green at u, v in [0, 1), same as getTexel()
+//
+static inline void GrassSimdSampleWind( const GRASS_SIMD_BATCH *batch, VEC u, VEC v, VEC *red, VEC *green)
+{
+    //code
+    const VEC windWidth = VSET1( (float)batch->windWidth);
+    const VEC windHeight = VSET1( (float)batch->windHeight);
+    const IVEC windRowTexels = IVSET1( batch->windWidth);
+    const IVEC windColumnTexels = IVSET1( batch->windHeight);
+    const IVEC blockColumns = IVSET1( batch->windBlockColumns);
+    const VEC byteScale = VSET1( 255.0f);
+
+    if( batch->windPacked == NULL)
+    {
+        IVEC texelX = VCVTTI( VFLOOR( VMUL( u, windWidth)));
+        IVEC texelY = VCVTTI( VFLOOR( VMUL( v, windHeight)));
+        IVEC texelIndex = IVSLLI( IVADD( IVMULLO( texelY, windRowTexels), texelX), 2);     //GRASS_COLOR_CHANNELS
+
+        *red = VGATHER( batch->windTexels + 0, texelIndex);
+        *green = VGATHER( batch->windTexels + 1, texelIndex);
+        return;
+    }
+
+    if( !batch->windBilinear)
+    {
+        IVEC texelX = VCVTTI( VFLOOR( VMUL( u, windWidth)));
+        IVEC texelY = VCVTTI( VFLOOR( VMUL( v, windHeight)));
+
+        GrassSimdPackedTexel( batch->windPacked, texelX, texelY, blockColumns, red, green);
+        *red = VDIV( *red, byteScale);
+        *green = VDIV( *green, byteScale);
+        return;
+    }
+
+        //texel centers at ( x + 0.5) / width, neighbours wrap around
+    VEC fx = VSUB( VMUL( u, windWidth), VSET1( 0.5f));
+    VEC fy = VSUB( VMUL( v, windHeight), VSET1( 0.5f));
+    VEC x0f = VFLOOR( fx);
+    VEC y0f = VFLOOR( fy);
+    VEC wx = VSUB( fx, x0f);
+    VEC wy = VSUB( fy, y0f);
+
+    const IVEC izero = IVSET1( 0);
+    const IVEC ione = IVSET1( 1);
+
+    IVEC x0 = VCVTTI( x0f);
+    IVEC y0 = VCVTTI( y0f);
+    x0 = IVADD( x0, IVAND( IVCMPGT( izero, x0), windRowTexels));
+    y0 = IVADD( y0, IVAND( IVCMPGT( izero, y0), windColumnTexels));
+
+    IVEC x1 = IVADD( x0, ione);
+    IVEC y1 = IVADD( y0, ione);
+    x1 = IVSUB( x1, IVAND( IVCMPGT( x1, IVSUB( windRowTexels, ione)), windRowTexels));
+    y1 = IVSUB( y1, IVAND( IVCMPGT( y1, IVSUB( windColumnTexels, ione)), windColumnTexels));
+
+    VEC r00, g00, r10, g10, r01, g01, r11, g11;
+    GrassSimdPackedTexel( batch->windPacked, x0, y0, blockColumns, &r00, &g00);
+    GrassSimdPackedTexel( batch->windPacked, x1, y0, blockColumns, &r10, &g10);
+    GrassSimdPackedTexel( batch->windPacked, x0, y1, blockColumns, &r01, &g01);
+    GrassSimdPackedTexel( batch->windPacked, x1, y1, blockColumns, &r11, &g11);
+
+    VEC red0 = VADD( r00, VMUL( VSUB( r10, r00), wx));
+    VEC red1 = VADD( r01, VMUL( VSUB( r11, r01), wx));
+    VEC green0 = VADD( g00, VMUL( VSUB( g10, g00), wx));
+    VEC green1 = VADD( g01, VMUL( VSUB( g11, g01), wx));
+
+    *red = VDIV( VADD( red0, VMUL( VSUB( red1, red0), wy)), byteScale);
+    *green = VDIV( VADD( green0, VMUL( VSUB( green1, green0), wy)), byteScale);
+}
+
+//
+//GrassSimdWindGradient() :- GrassWindGradient() of GrassField.cpp, hash of lattice point ( x, y) dotted with ( dx, dy)
+//
+static inline VEC GrassSimdWindGradient( IVEC x, IVEC y, VEC dx, VEC dy)
+{
+    //code
+    const IVEC byteMask = IVSET1( 0xFF);
+    const VEC scale = VSET1( 1.0f / 127.5f);
+    const VEC one = VSET1( 1.0f);
+
+    IVEC h = IVXOR( IVMULLO( x, IVSET1( 0x27d4eb2d)), IVMULLO( y, IVSET1( 0x165667b1)));
+    h = IVXOR( h, IVSRLI( h, 15));
+    h = IVMULLO( h, IVSET1( 0x2c1b3c6d));
+    h = IVXOR( h, IVSRLI( h, 12));
+
+    VEC gx = VSUB( VMUL( VCVTIF( IVAND( h, byteMask)), scale), one);
+    VEC gy = VSUB( VMUL( VCVTIF( IVAND( IVSRLI( h, 8), byteMask)), scale), one);
+
+    return( VADD( VMUL( gx, dx), VMUL( gy, dy)));
+}
+
+//
+//GrassSimdGradientNoise() :- GrassGradientNoise()
+//
+static inline VEC GrassSimdGradientNoise( VEC x, VEC y)
+{
+    //code
+    const VEC one = VSET1( 1.0f);
+    const IVEC ione = IVSET1( 1);
+
+    VEC x0 = VFLOOR( x);
+    VEC y0 = VFLOOR( y);
+    VEC fx = VSUB( x, x0);
+    VEC fy = VSUB( y, y0);
+    IVEC ix = VCVTTI( x0);
+    IVEC iy = VCVTTI( y0);
+
+    VEC n00 = GrassSimdWindGradient( ix, iy, fx, fy);
+    VEC n10 = GrassSimdWindGradient( IVADD( ix, ione), iy, VSUB( fx, one), fy);
+    VEC n01 = GrassSimdWindGradient( ix, IVADD( iy, ione), fx, VSUB( fy, one));
+    VEC n11 = GrassSimdWindGradient( IVADD( ix, ione), IVADD( iy, ione), VSUB( fx, one), VSUB( fy, one));
+
+    VEC ux = VMUL( VMUL( VMUL( fx, fx), fx), VADD( VMUL( fx, VSUB( VMUL( fx, VSET1( 6.0f)), VSET1( 15.0f))), VSET1( 10.0f)));
+    VEC uy = VMUL( VMUL( VMUL( fy, fy), fy), VADD( VMUL( fy, VSUB( VMUL( fy, VSET1( 6.0f)), VSET1( 15.0f))), VSET1( 10.0f)));
+
+    VEC nx0 = VADD( n00, VMUL( VSUB( n10, n00), ux));
+    VEC nx1 = VADD( n01, VMUL( VSUB( n11, n01), ux));
+
+    return( VADD( nx0, VMUL( VSUB( nx1, nx0), uy)));
+}
+
+//
+//GrassSimdProceduralWind() :- GrassSampleProceduralWind() at blade roots ( x, z)
+//
+static inline void GrassSimdProceduralWind( const GRASS_SIMD_BATCH *batch, VEC x, VEC z, VEC *red, VEC *green)
+{
+    //code
+    const GRASS_PROCEDURAL_WIND *wind = &batch->windModel;
+    const VEC zero = VSET1( 0.0f);
+    const VEC one = VSET1( 1.0f);
+    const VEC half = VSET1( 0.5f);
+    const VEC dirX = VSET1( wind->direction[0]);
+    const VEC dirZ = VSET1( wind->direction[1]);
+    const VEC strength = VSET1( wind->strength);
+    const VEC frequency = VSET1( wind->frequency);
+    const VEC drift = VSET1( wind->speed * batch->windTime);
+    const VEC two = VSET1( 2.0f);
+
+    VEC qx = VMUL( VSUB( x, VMUL( dirX, drift)), frequency);
+    VEC qz = VMUL( VSUB( z, VMUL( dirZ, drift)), frequency);
+
+    VEC base = VADD( GrassSimdGradientNoise( qx, qz),
+                     VMUL( half, GrassSimdGradientNoise( VADD( VMUL( qx, two), VSET1( 19.1f)), VADD( VMUL( qz, two), VSET1( 7.3f)))));
+    VEC sway = GrassSimdGradientNoise( VADD( qx, VSET1( 41.7f)), VADD( qz, VSET1( 13.9f)));
+
+    VEC phase = VMUL( VSUB( VADD( VMUL( x, dirX), VMUL( z, dirZ)), drift), VSET1( wind->gustFrequency));
+    VEC front, frontCos;
+    GrassSimdSinCos( VMUL( VSET1( 6.28318531f), VSUB( phase, VFLOOR( phase))), &front, &frontCos);
+    front = VMAX( front, zero);
+    VEC gust = VMUL( front, front);
+
+    VEC along = VMUL( strength, VADD( VADD( VSET1( 0.4f), VMUL( VSET1( 0.3f), base)), VMUL( VSET1( 0.6f), gust)));
+    VEC across = VMUL( VMUL( strength, VSET1( 0.3f)), sway);
+
+    VEC windX = VSUB( VMUL( dirX, along), VMUL( dirZ, across));
+    VEC windZ = VADD( VMUL( dirZ, along), VMUL( dirX, across));
+
+    *red = VMIN( VMAX( VADD( half, VMUL( half, windX)), zero), one);
+    *green = VMIN( VMAX( VADD( half, VMUL( half, windZ)), zero), one);
+}
+
+//
+//GrassSimdSimulate()
+//
+static int GrassSimdSimulate( const GRASS_SIMD_BATCH *batch, int bladeBegin, int bladeEnd)
+{
+    //variable declarations
+    int segments = batch->segments;
+    size_t verticesPerBlade = 2 * (size_t)segments;
+    int groupEnd = bladeBegin + ( (bladeEnd - bladeBegin) / GRASS_SIMD_LANES) * GRASS_SIMD_LANES;
+
+    const float *mesh = batch->meshVertices ? batch->meshVertices[0].position : NULL;
+    const IVEC vertexStride = IVSET1( (int)(sizeof( VERTEX) / sizeof( float)));
+
+    const VEC zero = VSET1( 0.0f);
+    const VEC one = VSET1( 1.0f);
+    const VEC two = VSET1( 2.0f);
+
+    const VEC windScaleX = VSET1( batch->windScale[0]);
+    const VEC windScaleY = VSET1( batch->windScale[1]);
+    const VEC windParamX = VSET1( batch->windParam[0]);
+    const VEC windParamY = VSET1( batch->windParam[1]);
+    const VEC windStrength = VSET1( batch->windStrength);
+
+    const VEC gridWidth = VSET1( (float)batch->grid.width);
+    const VEC gridLeft = VSET1( batch->grid.left);
+    const VEC gridTop = VSET1( batch->grid.top);
+    const VEC gridSpacing = VSET1( batch->grid.spacing);
+
+    VEC T[3][3], F[3][3], W[3][3], FB[3][3], TW[3][3];
+    VEC M[3][3], baseM[3][3];
+
+    //code
+    for( int i = bladeBegin; i < groupEnd; i += GRASS_SIMD_LANES)
+    {
+        VEC px, py, pz, nx, ny, nz, tx, ty, tz;
+
+        if( mesh)
+        {
+            IVEC vertexIndex = IVMULLO( IVADD( IVSET1( i), IVINDEX), vertexStride);
+
+            px = VGATHER( mesh + 0, vertexIndex);
+            py = VGATHER( mesh + 1, vertexIndex);
+            pz = VGATHER( mesh + 2, vertexIndex);
+
+            nx = VGATHER( mesh + 3, vertexIndex);
+            ny = VGATHER( mesh + 4, vertexIndex);
+            nz = VGATHER( mesh + 5, vertexIndex);
+
+            tx = VGATHER( mesh + 6, vertexIndex);
+            ty = VGATHER( mesh + 7, vertexIndex);
+            tz = VGATHER( mesh + 8, vertexIndex);
+        }
+        else
+        {
+                //procedural grid, z = i / width and x = i % width per lane
+                //( exact in float while i + 0.5 and the quotient fit in 24 bits)
+            VEC bladeIndex = VCVTIF( IVADD( IVSET1( i), IVINDEX));
+            VEC gz = VFLOOR( VDIV( VADD( bladeIndex, VSET1( 0.5f)), gridWidth));
+            VEC gx = VSUB( bladeIndex, VMUL( gz, gridWidth));
+
+            px = VMUL( VADD( gridLeft, gx), gridSpacing);
+            py = batch->grid.heights ? VLOADU( batch->grid.heights + i) : zero;
+            pz = VMUL( VSUB( gridTop, gz), gridSpacing);
+
+            nx = zero;  ny = one;   nz = zero;
+            tx = one;   ty = zero;  tz = zero;
+        }
+
+        //tangent to local ( columns : tangent, normal x tangent, normal)
+        T[0][0] = tx;   T[0][1] = ty;   T[0][2] = tz;
+        T[1][0] = VSUB( VMUL( ny, tz), VMUL( nz, ty));
+        T[1][1] = VSUB( VMUL( nz, tx), VMUL( nx, tz));
+        T[1][2] = VSUB( VMUL( nx, ty), VMUL( ny, tx));
+        T[2][0] = nx;   T[2][1] = ny;   T[2][2] = nz;
+
+        //facing rotation around Z
+        VEC fs = VLOADU( batch->facingSin + i);
+        VEC fc = VLOADU( batch->facingCos + i);
+
+        F[0][0] = fc;               F[0][1] = fs;   F[0][2] = zero;
+        F[1][0] = VSUB( zero, fs);  F[1][1] = fc;   F[1][2] = zero;
+        F[2][0] = zero;             F[2][1] = zero; F[2][2] = one;
+
+        //F * bend rotation around -X
+        VEC bs = VLOADU( batch->bendSin + i);
+        VEC bc = VSQRT( VSUB( one, VMUL( bs, bs)));
+
+        FB[0][0] = fc;                  FB[0][1] = fs;                  FB[0][2] = zero;
+        FB[1][0] = VMUL( F[1][0], bc);  FB[1][1] = VMUL( fc, bc);       FB[1][2] = VSUB( zero, bs);
+        FB[2][0] = VMUL( F[1][0], bs);  FB[2][1] = VMUL( fc, bs);       FB[2][2] = bc;
+
+        //ADD WIND ( uv without FMA so the texel choice matches the scalar path)
+        VEC red, green;
+        if( batch->windProcedural)
+        {
+            GrassSimdProceduralWind( batch, px, pz, &red, &green);
+        }
+        else
+        {
+            VEC u = VADD( VMUL( px, windScaleX), windParamX);
+            VEC v = VADD( VMUL( pz, windScaleY), windParamY);
+            u = VSUB( u, VFLOOR( u));
+            v = VSUB( v, VFLOOR( v));
+
+            GrassSimdSampleWind( batch, u, v, &red, &green);
+        }
+
+        VEC windSampleX = VMUL( VSUB( VMUL( red, two), one), windStrength);
+        VEC windSampleY = VMUL( VSUB( VMUL( green, two), one), windStrength);
+
+        VEC windLength = VSQRT( VADD( VMUL( windSampleX, windSampleX), VMUL( windSampleY, windSampleY)));
+        VEC dx = VDIV( windSampleX, windLength);
+        VEC dy = VDIV( windSampleY, windLength);
+
+        VEC ws, wc;
+        GrassSimdSinCos( VMUL( VSET1( 3.14159265f), windSampleX), &ws, &wc);
+        VEC wt = VSUB( one, wc);
+
+        W[0][0] = VFMADD( VMUL( dx, dx), wt, wc);   W[0][1] = VMUL( VMUL( dy, dx), wt);         W[0][2] = VMUL( VSUB( zero, dy), ws);
+        W[1][0] = W[0][1];                          W[1][1] = VFMADD( VMUL( dy, dy), wt, wc);   W[1][2] = VMUL( dx, ws);
+        W[2][0] = VMUL( dy, ws);                    W[2][1] = VMUL( VSUB( zero, dx), ws);       W[2][2] = wc;
+
+            //for base vertices, we don't want to bend or rotate base vertices
+        GrassSimdMat3Multiply( baseM, T, F);
+
+            //for vertices other than base  vertices, as we want them to move with wind
+        GrassSimdMat3Multiply( TW, T, W);
+        GrassSimdMat3Multiply( M, TW, FB);
+
+        VEC width = VLOADU( batch->width + i);
+        VEC height = VLOADU( batch->height + i);
+        VEC forward = VLOADU( batch->forward + i);
+
+        GRASS_VERTEX *out = batch->outVertices + (size_t)( i - batch->outFirstBlade) * verticesPerBlade;
+
+        for( int j = 0; j < segments; j++)
+        {
+            VEC (*R)[3] = (j == 0) ? baseM : M;     //don't bend base vertices
+
+            VEC t = VSET1( batch->segmentT[j]);
+            VEC segmentWidth = VMUL( width, VSUB( one, t));
+            VEC segmentHeight = VMUL( height, t);
+            VEC segmentForward = VMUL( VSET1( batch->segmentCurve[j]), forward);
+
+                //shared part of ( +/-width, forward, height) and normal ( 0, -1, forward)
+            VEC cx = VFMADD( R[2][0], segmentHeight, VFMADD( R[1][0], segmentForward, px));
+            VEC cy = VFMADD( R[2][1], segmentHeight, VFMADD( R[1][1], segmentForward, py));
+            VEC cz = VFMADD( R[2][2], segmentHeight, VFMADD( R[1][2], segmentForward, pz));
+
+            VEC wx = VMUL( R[0][0], segmentWidth);
+            VEC wy = VMUL( R[0][1], segmentWidth);
+            VEC wz = VMUL( R[0][2], segmentWidth);
+
+            VEC left[8], right[8];
+
+            left[0] = VADD( cx, wx);
+            left[1] = VADD( cy, wy);
+            left[2] = VADD( cz, wz);
+            left[3] = VFMADD( R[2][0], segmentForward, VSUB( zero, R[1][0]));
+            left[4] = VFMADD( R[2][1], segmentForward, VSUB( zero, R[1][1]));
+            left[5] = VFMADD( R[2][2], segmentForward, VSUB( zero, R[1][2]));
+            left[6] = zero;
+            left[7] = t;
+
+            right[0] = VSUB( cx, wx);
+            right[1] = VSUB( cy, wy);
+            right[2] = VSUB( cz, wz);
+            right[3] = left[3];
+            right[4] = left[4];
+            right[5] = left[5];
+            right[6] = one;
+            right[7] = t;
+
+            GrassSimdStoreVertices( left, out + 2 * j + 0, verticesPerBlade);
+            GrassSimdStoreVertices( right, out + 2 * j + 1, verticesPerBlade);
+        }
+    }
+
+    return( groupEnd - bladeBegin);
+}
+
+#endif
@@ -0,0 +1,542 @@
+/*
+ * Waving Grass Rendering : Stage Microbenchmarks
+ *
+ * Times each stage of the CPU grass pipeline on its own, over a sweep of grid
+ * sizes and blade segment counts, and reports ns/blade, bytes/blade and GB/s
+ * per stage, optionally as JSON so runs of different commits / machines can
+ * be diffed.
+ *
+ *  usage: GrassStageBench [-grid N] [-segments N,N,..] [-threads N] [-mintime ms]
+ *                         [-json file.json] [-label text]
+ *
+ *  -grid     : one grid size instead of the sweep MIN_MESH_SIZE, 2 x .. MAX_MESH_SIZE
+ *  -segments : segment counts of the segment dependent stages (default 3,6,12,24)
+ *  -threads  : worker threads of the simulate stages (default 1)
+ *  -mintime  : every measurement repeats the stage for at least this long (default 20 ms)
+ *  -json     : also write all results to 'file.json', '-' : stdout
+ *  -label    : free text stored in the JSON, e.g. the commit
+ *
+ *  stages ( bytes are the bytes a blade reads + writes, not counting caches)
+ *      mesh             CreateMesh(), VERTEX written
+ *      static_mat4      GrassField::resize() of the mat4 layout, static props written
+ *      static_compact   same for the compact layout
+ *      indices          GrassField::fillIndices(), indices written
+ *      simulate_mat4    GrassField::simulate() of the mat4 layout, static props + root read, vertices written
+ *      simulate_<simd>  same for the compact layout at every supported SIMD level
+ *      wind_float       getTexel() at every blade root, RGBA float map ( 16 byte texel)
+ *      wind_rg8         packed map, nearest ( 2 byte texel)
+ *      wind_bilinear    packed map, bilinear ( 4 x 2 byte texels)
+ *      wind_procedural  GrassSampleProceduralWind(), no texels
+ *      mat4_mul         MyMath.h / vmath mat4 * mat4, per matrix
+ *      mat4_vec4        mat4 * vec4, per vector
+ *      rotation_matrix  RotationMatrix(), per matrix
+ *      mat4_inverse     mymath::inverseMatrix(), per matrix
+ *
+ * Created By Vijaykumar Dangi
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+#include "GrassField.h"
+
+//macro
+#define  WIND_MAP_SIZE          512         //same as texture/Wind.bmp
+#define  MATH_ITEMS             1024        //matrices / vectors per math stage call, stays in L1 / L2
+#define  MAX_SEGMENT_COUNTS     16
+#define  MAX_STAGE_RESULTS      4096
+
+//global variable declaration
+FILE *gpLogFile = NULL;
+FILE *gpReportFile = NULL;      //table, stderr when the JSON goes to stdout
+
+//inputs of every stage, a stage function uses what it needs
+typedef struct STAGE_CONTEXT
+{
+    int gridSize;
+    VERTEX *meshVertexData;
+    GrassField *grassField;
+    GRASS_VERTEX *grassVertex;
+    size_t vertexCount;
+    unsigned int *indices;
+    size_t indexCount;
+    const GRASS_WIND_MAP *windMap;
+
+    vmath::mat4 *matrices;
+    vmath::vec4 *vectors;
+    float *angles;
+
+    volatile float sink;        //keeps results of the pure stages alive
+} STAGE_CONTEXT;
+
+typedef void (*STAGE_FUNCTION)( STAGE_CONTEXT *context);
+
+//one line of the report
+typedef struct STAGE_RESULT
+{
+    const char *stage;
+    int gridSize;           //0 : independent of the grid
+    int segments;           //0 : independent of the segment count
+    long long items;        //blades, or matrices / vectors of the math stages
+    double nsPerItem;
+    double bytesPerItem;
+} STAGE_RESULT;
+
+STAGE_RESULT gResults[ MAX_STAGE_RESULTS];
+int gResultCount = 0;
+
+//
+//TimeStage() :- mean ns per call of 'function', repeated for at least minMs after one warm up call
+//
+double TimeStage( STAGE_FUNCTION function, STAGE_CONTEXT *context, double minMs)
+{
+    //code
+    function( context);
+
+    long long calls = 0;
+    double elapsedMs = 0.0;
+
+    std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+    do
+    {
+        function( context);
+        calls++;
+
+        elapsedMs = std::chrono::duration<double, std::milli>( std::chrono::high_resolution_clock::now() - start).count();
+    } while( elapsedMs < minMs);
+
+    return( elapsedMs * 1.0e6 / calls);
+}
+
+//
+//AddResult() :- record and print one stage measurement
+//
+void AddResult( const char *stage, int gridSize, int segments, long long items, double nsPerCall, double bytesPerItem)
+{
+    //code
+    if( gResultCount >= MAX_STAGE_RESULTS)
+    {
+        return;
+    }
+
+    STAGE_RESULT *result = &gResults[ gResultCount++];
+    result->stage = stage;
+    result->gridSize = gridSize;
+    result->segments = segments;
+    result->items = items;
+    result->nsPerItem = nsPerCall / items;
+    result->bytesPerItem = bytesPerItem;
+
+        //bytes per ns is GB/s
+    fprintf( gpReportFile, "%-18s %6d %4d %10lld %12.2f %12.1f %10.2f\n", stage, gridSize, segments, items,
+        result->nsPerItem, bytesPerItem, bytesPerItem / result->nsPerItem);
+}
+
+/* ___________________________ stages _____________________________ */
+
+void StageMesh( STAGE_CONTEXT *context)
+{
+    //code
+    CreateMesh( 0, 0, context->gridSize, context->gridSize, MESH_MULTIPLICANT, MESH_AMPLITUDE, context->meshVertexData, HeightCalculate);
+}
+
+void StageStatic( STAGE_CONTEXT *context)
+{
+    //code
+    context->grassField->resize( context->gridSize, context->gridSize, context->meshVertexData);
+}
+
+void StageIndices( STAGE_CONTEXT *context)
+{
+    //code
+    context->grassField->fillIndices( context->indices, context->indexCount);
+}
+
+void StageSimulate( STAGE_CONTEXT *context)
+{
+    //code
+    context->grassField->simulate( 1.0f, context->windMap, context->grassVertex, context->vertexCount);
+}
+
+void StageWindTexel( STAGE_CONTEXT *context)
+{
+    //variable declarations
+    vmath::vec2 scale( 0.009f, 0.009f);
+    vmath::vec2 offset( 0.05f, 0.05f);
+    float sum = 0.0f;
+
+    //code
+    int bladeCount = context->gridSize * context->gridSize;
+    for( int i = 0; i < bladeCount; i++)
+    {
+        const float *position = context->meshVertexData[i].position;
+        vmath::vec4 color = getTexel( vmath::vec2( position[0], position[2]) * scale + offset, context->windMap);
+        sum += color[0] + color[1];
+    }
+
+    context->sink = sum;
+}
+
+void StageWindProcedural( STAGE_CONTEXT *context)
+{
+    //variable declarations
+    float red, green;
+    float sum = 0.0f;
+
+    //code
+    int bladeCount = context->gridSize * context->gridSize;
+    for( int i = 0; i < bladeCount; i++)
+    {
+        const float *position = context->meshVertexData[i].position;
+        GrassSampleProceduralWind( &context->windMap->model, position[0], position[2], 1.0f, &red, &green);
+        sum += red + green;
+    }
+
+    context->sink = sum;
+}
+
+void StageMatMul( STAGE_CONTEXT *context)
+{
+    //code
+        //chained so the compiler cannot hoist or drop any product
+    vmath::mat4 m = context->matrices[0];
+    for( int i = 1; i < MATH_ITEMS; i++)
+    {
+        m = context->matrices[i] * m;
+    }
+
+    context->sink = m[0][0];
+}
+
+void StageMatVec( STAGE_CONTEXT *context)
+{
+    //code
+    vmath::vec4 sum( 0.0f);
+    for( int i = 0; i < MATH_ITEMS; i++)
+    {
+        sum += context->matrices[i] * context->vectors[i];
+    }
+
+    context->sink = sum[0] + sum[1] + sum[2] + sum[3];
+}
+
+void StageRotation( STAGE_CONTEXT *context)
+{
+    //code
+    float sum = 0.0f;
+    for( int i = 0; i < MATH_ITEMS; i++)
+    {
+        vmath::mat4 m = RotationMatrix( context->angles[i], 0.6f, 0.8f, 0.0f);
+        sum += m[0][0] + m[1][2];
+    }
+
+    context->sink = sum;
+}
+
+void StageInverse( STAGE_CONTEXT *context)
+{
+    //code
+    float sum = 0.0f;
+    for( int i = 0; i < MATH_ITEMS; i++)
+    {
+        vmath::mat4 m = mymath::inverseMatrix( context->matrices[i]);
+        sum += m[0][0] + m[3][1];
+    }
+
+    context->sink = sum;
+}
+
+//
+//BenchMath() :- grid independent MyMath.h / vmath matrix operations
+//
+int BenchMath( STAGE_CONTEXT *context, double minMs)
+{
+    //code
+    context->matrices = (vmath::mat4 *) malloc( MATH_ITEMS * sizeof( vmath::mat4));
+    context->vectors = (vmath::vec4 *) malloc( MATH_ITEMS * sizeof( vmath::vec4));
+    context->angles = (float *) malloc( MATH_ITEMS * sizeof( float));
+    if( (context->matrices == NULL) || (context->vectors == NULL) || (context->angles == NULL))
+    {
+        fprintf( stderr, "malloc() Failed\n");
+        return(-1);
+    }
+
+        //rotations, well conditioned for the inverse and bounded under the chained product
+    for( int i = 0; i < MATH_ITEMS; i++)
+    {
+        context->angles[i] = GrassRandom( i, 0) * mymath::TWO_PI;
+        context->matrices[i] = RotationMatrix( context->angles[i], 0.0f, 0.6f, 0.8f);
+        context->vectors[i] = vmath::vec4( GrassRandom( i, 1), GrassRandom( i, 2), GrassRandom( i, 3), 1.0f);
+    }
+
+    AddResult( "mat4_mul", 0, 0, MATH_ITEMS, TimeStage( StageMatMul, context, minMs), 2 * sizeof( vmath::mat4));
+    AddResult( "mat4_vec4", 0, 0, MATH_ITEMS, TimeStage( StageMatVec, context, minMs), sizeof( vmath::mat4) + sizeof( vmath::vec4));
+    AddResult( "rotation_matrix", 0, 0, MATH_ITEMS, TimeStage( StageRotation, context, minMs), sizeof( float) + sizeof( vmath::mat4));
+    AddResult( "mat4_inverse", 0, 0, MATH_ITEMS, TimeStage( StageInverse, context, minMs), 2 * sizeof( vmath::mat4));
+
+    free( context->angles);
+    free( context->vectors);
+    free( context->matrices);
+
+    return(0);
+}
+
+//
+//BenchGrid() :- every grid dependent stage at gridSize x gridSize blades
+//
+int BenchGrid( STAGE_CONTEXT *context, int gridSize, const int *segmentCounts, int segmentCountCount, int threadCount, GRASS_WIND_MAP *windMaps, double minMs)
+{
+    //variable declarations
+    static const char *simulateNames[] = { "simulate_scalar", "simulate_avx2", "simulate_avx512" };
+    static const char *windNames[] = { "wind_float", "wind_rg8", "wind_bilinear", "wind_procedural" };
+    static const double windBytes[] = { 4 * sizeof( float), 2, 4 * 2, 0 };
+
+    //code
+    long long bladeCount = (long long)gridSize * gridSize;
+    context->gridSize = gridSize;
+
+    AddResult( "mesh", gridSize, 0, bladeCount, TimeStage( StageMesh, context, minMs), sizeof( VERTEX));
+
+    for( int layout = GRASS_LAYOUT_MAT4; layout <= GRASS_LAYOUT_COMPACT; layout++)
+    {
+        GrassField grassField( (GRASS_LAYOUT)layout);
+        context->grassField = &grassField;
+
+        AddResult( ( layout == GRASS_LAYOUT_MAT4) ? "static_mat4" : "static_compact", gridSize, 0, bladeCount,
+            TimeStage( StageStatic, context, minMs), (double)grassField.getStaticBytesPerBlade());
+    }
+
+    for( int w = 0; w < 4; w++)
+    {
+        context->windMap = &windMaps[w];
+        AddResult( windNames[w], gridSize, 0, bladeCount,
+            TimeStage( ( w == 3) ? StageWindProcedural : StageWindTexel, context, minMs), sizeof( float) * 2 + windBytes[w]);
+    }
+
+    for( int s = 0; s < segmentCountCount; s++)
+    {
+        int segments = segmentCounts[s];
+
+            //mesh roots, RGBA float wind like Main.cpp
+        context->windMap = &windMaps[0];
+
+        for( int layout = GRASS_LAYOUT_MAT4; layout <= GRASS_LAYOUT_COMPACT; layout++)
+        {
+            for( int level = GRASS_SIMD_SCALAR; level <= ( ( layout == GRASS_LAYOUT_MAT4) ? GRASS_SIMD_SCALAR : GrassSimdDetect()); level++)
+            {
+                GrassField grassField( (GRASS_LAYOUT)layout);
+                grassField.params.segments = segments;
+                grassField.setSimdLevel( (GRASS_SIMD_LEVEL)level);
+                grassField.setThreadCount( threadCount);
+
+                if( grassField.resize( gridSize, gridSize, context->meshVertexData) != 0)
+                {
+                    fprintf( stderr, "GrassField::resize() Failed\n");
+                    return(-1);
+                }
+                grassField.cull( NULL);
+
+                context->grassField = &grassField;
+                context->vertexCount = (size_t)grassField.getOutputVertexCount();
+
+                double bytes = grassField.getStaticBytesPerBlade() + sizeof( VERTEX) + 2.0 * segments * sizeof( GRASS_VERTEX);
+                AddResult( ( layout == GRASS_LAYOUT_MAT4) ? "simulate_mat4" : simulateNames[ level], gridSize, segments, bladeCount,
+                    TimeStage( StageSimulate, context, minMs), bytes);
+
+                if( layout == GRASS_LAYOUT_MAT4)
+                {
+                    context->indexCount = (size_t)grassField.getIndexCount();
+                    AddResult( "indices", gridSize, segments, bladeCount, TimeStage( StageIndices, context, minMs),
+                        (double)grassField.getIndicesPerBlade() * sizeof( unsigned int));
+                }
+            }
+        }
+    }
+
+    return(0);
+}
+
+//
+//WriteJson() :- all results, one object per line
+//
+int WriteJson( const char *fileName, const char *label, int threadCount, double minMs)
+{
+    //code
+    FILE *fp = ( strcmp( fileName, "-") == 0) ? stdout : fopen( fileName, "w");
+    if( fp == NULL)
+    {
+        fprintf( stderr, "Cannot write \"%s\"\n", fileName);
+        return(-1);
+    }
+
+    fprintf( fp, "{\n");
+    fprintf( fp, "  \"label\": \"%s\",\n", label);
+    fprintf( fp, "  \"simd\": \"%s\",\n", GrassSimdName( GrassSimdDetect()));
+    fprintf( fp, "  \"threads\": %d,\n", threadCount);
+    fprintf( fp, "  \"compiler\": \"%s\",\n", __VERSION__);
+    fprintf( fp, "  \"min_time_ms\": %g,\n", minMs);
+    fprintf( fp, "  \"results\": [\n");
+
+    for( int i = 0; i < gResultCount; i++)
+    {
+        const STAGE_RESULT *result = &gResults[i];
+        fprintf( fp, "    { \"stage\": \"%s\", \"grid\": %d, \"segments\": %d, \"items\": %lld, \"ns_per_item\": %.4f, \"bytes_per_item\": %.1f, \"gb_per_sec\": %.4f }%s\n",
+            result->stage, result->gridSize, result->segments, result->items, result->nsPerItem, result->bytesPerItem,
+            result->bytesPerItem / result->nsPerItem, ( i + 1 < gResultCount) ? "," : "");
+    }
+
+    fprintf( fp, "  ]\n");
+    fprintf( fp, "}\n");
+
+    if( fp != stdout)
+    {
+        fclose( fp);
+    }
+
+    return(0);
+}
+
+//
+//main()
+//
+int main( int argc, char *argv[])
+{
+    //variable declarations
+    int gridSize = 0;
+    int segmentCounts[ MAX_SEGMENT_COUNTS] = { 3, 6, 12, 24 };
+    int segmentCountCount = 4;
+    int threadCount = 1;
+    double minMs = 20.0;
+    const char *jsonFileName = NULL;
+    const char *label = "";
+
+    STAGE_CONTEXT context;
+    GRASS_WIND_MAP windMaps[4];
+
+    //code
+    for( int i = 1; i < argc; i++)
+    {
+        if( (strcmp( argv[i], "-grid") == 0) && (i + 1 < argc))
+        {
+            gridSize = atoi( argv[++i]);
+            gridSize = CLAMP( gridSize, MIN_MESH_SIZE, MAX_MESH_SIZE);
+        }
+        else if( (strcmp( argv[i], "-segments") == 0) && (i + 1 < argc))
+        {
+            segmentCountCount = 0;
+            for( char *token = strtok( argv[++i], ","); token && (segmentCountCount < MAX_SEGMENT_COUNTS); token = strtok( NULL, ","))
+            {
+                int segments = atoi( token);
+                segmentCounts[ segmentCountCount++] = CLAMP( segments, 2, GRASS_MAX_BLADE_SEGMENTS);
+            }
+        }
+        else if( (strcmp( argv[i], "-threads") == 0) && (i + 1 < argc))
+        {
+            threadCount = atoi( argv[++i]);
+        }
+        else if( (strcmp( argv[i], "-mintime") == 0) && (i + 1 < argc))
+        {
+            minMs = atof( argv[++i]);
+        }
+        else if( (strcmp( argv[i], "-json") == 0) && (i + 1 < argc))
+        {
+            jsonFileName = argv[++i];
+        }
+        else if( (strcmp( argv[i], "-label") == 0) && (i + 1 < argc))
+        {
+            label = argv[++i];
+        }
+        else
+        {
+            fprintf( stderr, "usage: %s [-grid N] [-segments N,N,..] [-threads N] [-mintime ms] [-json file.json] [-label text]\n", argv[0]);
+            return( 1);
+        }
+    }
+
+    if( segmentCountCount == 0)
+    {
+        segmentCounts[ segmentCountCount++] = 12;
+    }
+
+    int maxSegments = 0;
+    for( int s = 0; s < segmentCountCount; s++)
+    {
+        maxSegments = MAX( maxSegments, segmentCounts[s]);
+    }
+
+    int maxGrid = gridSize ? gridSize : MAX_MESH_SIZE;
+    size_t maxBlades = (size_t)maxGrid * maxGrid;
+
+    memset( &context, 0, sizeof( STAGE_CONTEXT));
+    context.meshVertexData = (VERTEX *) malloc( maxBlades * sizeof( VERTEX));
+    context.grassVertex = (GRASS_VERTEX *) malloc( maxBlades * 2 * maxSegments * sizeof( GRASS_VERTEX));
+    context.indices = (unsigned int *) malloc( maxBlades * 6 * ( maxSegments - 1) * sizeof( unsigned int));
+
+        //wind content does not change the cost, only its size : synthetic map of the size of texture/Wind.bmp
+    float *windTexels = (float *) malloc( (size_t)WIND_MAP_SIZE * WIND_MAP_SIZE * GRASS_COLOR_CHANNELS * sizeof( float));
+    unsigned char *packedWind = (unsigned char *) malloc( GrassGetPackedWindBytes( WIND_MAP_SIZE, WIND_MAP_SIZE));
+
+    if( (context.meshVertexData == NULL) || (context.grassVertex == NULL) || (context.indices == NULL) || (windTexels == NULL) || (packedWind == NULL))
+    {
+        fprintf( stderr, "malloc() Failed\n");
+        return( 1);
+    }
+
+    for( int i = 0; i < WIND_MAP_SIZE * WIND_MAP_SIZE; i++)
+    {
+        windTexels[ GRASS_COLOR_CHANNELS * i + 0] = GrassRandom( i, 0);
+        windTexels[ GRASS_COLOR_CHANNELS * i + 1] = GrassRandom( i, 1);
+        windTexels[ GRASS_COLOR_CHANNELS * i + 2] = 0.0f;
+        windTexels[ GRASS_COLOR_CHANNELS * i + 3] = 1.0f;
+    }
+
+    windMaps[0].width = WIND_MAP_SIZE;
+    windMaps[0].height = WIND_MAP_SIZE;
+    windMaps[0].texels = windTexels;
+
+    windMaps[1] = windMaps[0];
+    GrassPackWindMap( &windMaps[1], packedWind);
+
+    windMaps[2] = windMaps[1];
+    windMaps[2].bilinear = true;
+
+    windMaps[3].procedural = true;
+
+    gpReportFile = ( jsonFileName && (strcmp( jsonFileName, "-") == 0)) ? stderr : stdout;
+
+    fprintf( gpReportFile, "simd %s, threads %d, min time %g ms\n", GrassSimdName( GrassSimdDetect()), threadCount, minMs);
+    fprintf( gpReportFile, "%-18s %6s %4s %10s %12s %12s %10s\n", "stage", "grid", "seg", "items", "ns/item", "bytes/item", "GB/s");
+
+    if( BenchMath( &context, minMs) != 0)
+    {
+        return( 1);
+    }
+
+    for( int size = gridSize ? gridSize : MIN_MESH_SIZE; size <= maxGrid; size = MIN( size * 2, maxGrid))
+    {
+        if( BenchGrid( &context, size, segmentCounts, segmentCountCount, threadCount, windMaps, minMs) != 0)
+        {
+            return( 1);
+        }
+
+        if( size == maxGrid)
+        {
+            break;
+        }
+    }
+
+    if( jsonFileName && (WriteJson( jsonFileName, label, threadCount, minMs) != 0))
+    {
+        return( 1);
+    }
+
+    free( packedWind);
+    free( windTexels);
+    free( context.indices);
+    free( context.grassVertex);
+    free( context.meshVertexData);
+
+    return( 0);
+}
@@ -0,0 +1,292 @@
+/*
+ * Work stealing thread pool for the CPU grass path
+ *
+ * Created By Vijaykumar Dangi
+ */
+
+#include <string.h>
+#include <chrono>
+
+#include "GrassThreadPool.h"
+#include "GrassProfiler.h"
+
+
+//
+//GrassThreadPool()
+//
+GrassThreadPool::GrassThreadPool( int threadCount)
+{
+    //code
+    if( threadCount <= 0)
+    {
+        threadCount = (int) std::thread::hardware_concurrency();
+    }
+    if( threadCount < 1)
+    {
+        threadCount = 1;
+    }
+    if( threadCount > GRASS_MAX_THREADS)
+    {
+        threadCount = GRASS_MAX_THREADS;
+    }
+
+    this->threadCount = threadCount;
+    this->queues = new TASK_QUEUE[ threadCount];
+    this->workers = NULL;
+    this->wallMs = 0.0;
+
+    this->func = NULL;
+    this->context = NULL;
+    this->generation = 0;
+    this->activeWorkers = 0;
+    this->quit = false;
+
+    memset( this->stats, 0, sizeof( this->stats));
+    for( int i = 0; i < threadCount; i++)
+    {
+        this->queues[i].head.store( 0);
+        this->queues[i].tail.store( 0);
+    }
+
+        //thread 0 is the caller of run()
+    if( threadCount > 1)
+    {
+        this->workers = new std::thread[ threadCount - 1];
+        for( int i = 1; i < threadCount; i++)
+        {
+            this->workers[i - 1] = std::thread( &GrassThreadPool::workerMain, this, i);
+        }
+    }
+}
+
+//
+//~GrassThreadPool()
+//
+GrassThreadPool::~GrassThreadPool()
+{
+    //code
+    if( this->workers)
+    {
+        {
+            std::lock_guard<std::mutex> guard( this->jobLock);
+            this->quit = true;
+        }
+        this->jobStart.notify_all();
+
+        for( int i = 0; i < this->threadCount - 1; i++)
+        {
+            this->workers[i].join();
+        }
+
+        delete[] this->workers;
+        this->workers = NULL;
+    }
+
+    delete[] this->queues;
+    this->queues = NULL;
+}
+
+//
+//run()
+//
+void GrassThreadPool::run( int taskCount, GRASS_TASK_FUNC func, void *context)
+{
+    //code
+    std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+        //contiguous initial split keeps neighbouring tiles on the same thread
+    for( int i = 0; i < this->threadCount; i++)
+    {
+        this->queues[i].head.store( (int)( (long long)taskCount * i / this->threadCount), std::memory_order_relaxed);
+        this->queues[i].tail.store( (int)( (long long)taskCount * (i + 1) / this->threadCount), std::memory_order_relaxed);
+
+        this->stats[i].busyMs = 0.0;
+        this->stats[i].tasks = 0;
+        this->stats[i].stolen = 0;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard( this->jobLock);
+        this->func = func;
+        this->context = context;
+        this->activeWorkers = this->threadCount - 1;
+        this->generation++;
+    }
+    this->jobStart.notify_all();
+
+    execute( 0);
+
+    if( this->workers)
+    {
+        std::unique_lock<std::mutex> guard( this->jobLock);
+        while( this->activeWorkers > 0)
+        {
+            this->jobDone.wait( guard);
+        }
+    }
+
+    this->wallMs = std::chrono::duration<double, std::milli>( std::chrono::high_resolution_clock::now() - start).count();
+}
+
+//
+//getImbalance()
+//
+double GrassThreadPool::getImbalance( void) const
+{
+    //code
+    double maxMs = 0.0;
+    double sumMs = 0.0;
+
+    for( int i = 0; i < this->threadCount; i++)
+    {
+        sumMs += this->stats[i].busyMs;
+        if( this->stats[i].busyMs > maxMs)
+        {
+            maxMs = this->stats[i].busyMs;
+        }
+    }
+
+    if( sumMs <= 0.0)
+    {
+        return( 1.0);
+    }
+
+    return( maxMs * this->threadCount / sumMs);
+}
+
+//
+//workerMain()
+//
+void GrassThreadPool::workerMain( int thread)
+{
+    //variable declarations
+    unsigned int seenGeneration = 0;
+
+    //code
+    for(;;)
+    {
+        {
+            std::unique_lock<std::mutex> guard( this->jobLock);
+            while( !this->quit && ( this->generation == seenGeneration))
+            {
+                this->jobStart.wait( guard);
+            }
+
+            if( this->quit)
+            {
+                return;
+            }
+
+            seenGeneration = this->generation;
+        }
+
+        execute( thread);
+
+        {
+            std::lock_guard<std::mutex> guard( this->jobLock);
+            this->activeWorkers--;
+            if( this->activeWorkers == 0)
+            {
+                this->jobDone.notify_one();
+            }
+        }
+    }
+}
+
+//
+//execute() :- drain own queue, then steal until every queue is empty
+//
+void GrassThreadPool::execute( int thread)
+{
+    //variable declarations
+    GRASS_THREAD_STATS *threadStats = &this->stats[ thread];
+
+    //code
+    GRASS_PROFILE_SCOPE( "grass tasks");
+
+    for(;;)
+    {
+        bool stolen = false;
+
+        int task = popTask( thread);
+        if( task < 0)
+        {
+            task = stealTask( thread);
+            stolen = true;
+        }
+
+        if( task < 0)
+        {
+            break;
+        }
+
+        std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+        this->func( this->context, task);
+
+        threadStats->busyMs += std::chrono::duration<double, std::milli>( std::chrono::high_resolution_clock::now() - start).count();
+        threadStats->tasks++;
+        if( stolen)
+        {
+            threadStats->stolen++;
+        }
+    }
+}
+
+//
+//popTask() :- front of own queue, -1 when empty
+//
+int GrassThreadPool::popTask( int thread)
+{
+    //code
+    TASK_QUEUE *queue = &this->queues[ thread];
+    std::lock_guard<std::mutex> guard( queue->lock);
+
+    if( queue->head < queue->tail)
+    {
+        return( queue->head++);
+    }
+
+    return(-1);
+}
+
+//
+//stealTask() :- back of the fullest other queue, -1 when all are empty
+//
+int GrassThreadPool::stealTask( int thread)
+{
+    //code
+    for(;;)
+    {
+        int victim = -1;
+        int victimTasks = 0;
+
+            //unlocked peek, only used to pick a victim
+        for( int i = 1; i < this->threadCount; i++)
+        {
+            int other = (thread + i) % this->threadCount;
+            int remaining = this->queues[other].tail.load( std::memory_order_relaxed) - this->queues[other].head.load( std::memory_order_relaxed);
+
+            if( remaining > victimTasks)
+            {
+                victim = other;
+                victimTasks = remaining;
+            }
+        }
+
+        if( victim < 0)
+        {
+            return(-1);
+        }
+
+        TASK_QUEUE *queue = &this->queues[ victim];
+        std::lock_guard<std::mutex> guard( queue->lock);
+
+        if( queue->head < queue->tail)
+        {
+            return( --queue->tail);
+        }
+
+            //emptied meanwhile, look again
+    }
+}
@@ -0,0 +1,85 @@
+#ifndef __GRASS_THREAD_POOL_H__
+#define __GRASS_THREAD_POOL_H__
+
+/*
+ * Persistent worker threads for the CPU grass path.
+ *
+ * run() splits tasks [0, taskCount) into one contiguous queue per thread,
+ * each thread takes tasks from the front of its own queue and, when that is
+ * empty, steals single tasks from the back of the fullest other queue.
+ * The calling thread is thread 0, a pool of 1 thread starts no workers.
+ */
+
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+
+//macro
+#define  GRASS_MAX_THREADS  64
+
+//task callback, per thread counters are kept by the pool ( getStats())
+typedef void (*GRASS_TASK_FUNC)( void *context, int task);
+
+//per thread counters of the last run()
+typedef struct GRASS_THREAD_STATS
+{
+    double busyMs;      //time spent inside tasks
+    int tasks;          //tasks executed
+    int stolen;         //of 'tasks', taken from another thread's queue
+} GRASS_THREAD_STATS;
+
+
+class GrassThreadPool
+{
+    public:
+            //threadCount <= 0 : one thread per hardware thread
+        GrassThreadPool( int threadCount);
+        ~GrassThreadPool();
+
+            //execute func( context, task) for every task, return when all are done
+        void run( int taskCount, GRASS_TASK_FUNC func, void *context);
+
+        int getThreadCount( void) const                 { return( threadCount); }
+        const GRASS_THREAD_STATS *getStats( void) const { return( stats); }
+        double getWallMs( void) const                   { return( wallMs); }
+
+            //slowest thread busy time / mean busy time of the last run(), 1.0 = perfectly balanced
+        double getImbalance( void) const;
+
+    private:
+            //one per thread, padded so owners and thieves don't share cache lines
+        typedef struct TASK_QUEUE
+        {
+            std::mutex lock;        //taking a task, head / tail are atomic for the thieves' peek
+            std::atomic<int> head;
+            std::atomic<int> tail;
+            char padding[64];
+        } TASK_QUEUE;
+
+        int threadCount;
+        std::thread *workers;
+        TASK_QUEUE *queues;
+        GRASS_THREAD_STATS stats[ GRASS_MAX_THREADS];
+        double wallMs;
+
+            //current job, guarded by jobLock
+        std::mutex jobLock;
+        std::condition_variable jobStart;
+        std::condition_variable jobDone;
+        GRASS_TASK_FUNC func;
+        void *context;
+        unsigned int generation;
+        int activeWorkers;
+        bool quit;
+
+        void workerMain( int thread);
+        void execute( int thread);
+        int popTask( int thread);
+        int stealTask( int thread);
+
+        GrassThreadPool( const GrassThreadPool &);
+        GrassThreadPool& operator=( const GrassThreadPool &);
+};
+
+#endif
@@ -0,0 +1,108 @@
+#ifndef __GRASS_TYPES_H__
+#define __GRASS_TYPES_H__
+
+/*
+ * Plain vertex layouts shared by the grass generators.
+ *
+ * Kept free of vmath / MyMath so the SIMD translation units, which are
+ * compiled with their own instruction set flags, don't emit copies of the
+ * inline math templates.
+ */
+
+//macro
+#define  GRASS_COLOR_CHANNELS       4
+#define  GRASS_MAX_BLADE_SEGMENTS   64
+#define  GRASS_WIND_BLOCK_SHIFT     3           //packed wind map is stored in 8 x 8 texel blocks
+
+//per blade random draws, GrassRandom() stream ( same values in Grass.cl)
+#define  GRASS_RANDOM_FACING        0
+#define  GRASS_RANDOM_BEND          1
+#define  GRASS_RANDOM_WIDTH         2
+#define  GRASS_RANDOM_HEIGHT        3
+#define  GRASS_RANDOM_FORWARD       4
+#define  GRASS_RANDOM_STREAMS       5
+
+//Mesh data
+typedef struct VERTEX
+{
+    float position[3];
+    float normal[3];
+    float tangent[3];
+    float texcoord[2];
+}VERTEX;
+
+typedef struct GRASS_VERTEX
+{
+    float position[3];
+    float normal[3];
+    float texcoord[2];
+}GRASS_VERTEX;
+
+//procedural flat grid, same layout as CreateMesh() : blade (x, z) stands at
+//( (left + x) * spacing, heights[i] or 0, (top - z) * spacing), normal (0, 1, 0), tangent (1, 0, 0)
+typedef struct GRASS_GRID
+{
+    int   width;
+    int   height;
+    float left;             //grid units
+    float top;
+    float spacing;
+    const float *heights;   //optional root height per blade (width * height), NULL = flat at y 0
+}GRASS_GRID;
+
+//analytic wind, evaluated per blade from its root ( x, z) and time instead of sampling a texture
+//two octaves of gradient noise drifting along 'direction' plus gust fronts travelling along it
+//( same layout in Grass.cl)
+typedef struct GRASS_PROCEDURAL_WIND
+{
+    float direction[2];     //unit vector in world x, z
+    float strength;         //0 - 1 of the full texture range
+    float frequency;        //noise cells per world unit
+    float speed;            //world units per second the noise and the fronts travel
+    float gustFrequency;    //gust fronts per world unit along 'direction'
+}GRASS_PROCEDURAL_WIND;
+
+//visible tile as generated, blades of the tile are written row by row from output vertex 'firstVertex'
+//( same layout in Grass.cl)
+typedef struct GRASS_LOD_TILE
+{
+    int   x;                //tile rectangle in grid coordinates
+    int   z;
+    int   width;
+    int   height;
+    int   firstVertex;      //prefix sum of the vertices of the visible tiles before this one
+    int   level;            //LOD level
+    int   segments;         //segments per blade of 'level'
+    int   coarseSegments;   //segments of the next level, the blade shape is morphed towards it
+    float morph;            //0 : own shape, 1 : shape of coarseSegments
+}GRASS_LOD_TILE;
+
+//packed wind map texel ( x, y) : red / green bytes at 2 * GRASS_WIND_TEXEL_OFFSET( x, y, blockColumns)
+//( same layout in Grass.cl)
+#define  GRASS_WIND_TEXEL_OFFSET( x, y, blockColumns) \
+    ( ( ( ( (y) >> GRASS_WIND_BLOCK_SHIFT) * (blockColumns) + ( (x) >> GRASS_WIND_BLOCK_SHIFT)) << ( 2 * GRASS_WIND_BLOCK_SHIFT)) \
+      + ( ( (y) & ( (1 << GRASS_WIND_BLOCK_SHIFT) - 1)) << GRASS_WIND_BLOCK_SHIFT) + ( (x) & ( (1 << GRASS_WIND_BLOCK_SHIFT) - 1)))
+
+//integer hash, multiply / xor-shift finalizer ( bijective on 32 bits, constant shifts only so it vectorizes)
+//( same as grassHash() in Grass.cl)
+static inline unsigned int GrassHash( unsigned int x)
+{
+    //code
+    x = x ^ ( x >> 16);
+    x = x * 0x7feb352dU;
+    x = x ^ ( x >> 15);
+    x = x * 0x846ca68bU;
+    x = x ^ ( x >> 16);
+
+    return( x);
+}
+
+//random number in [0, 1) of draw 'stream' of blade 'blade' ( grid index z * width + x)
+//top 24 bits of the hash, exact in float so every backend gets the same value
+static inline float GrassRandom( unsigned int blade, unsigned int stream)
+{
+    //code
+    return( (float)( GrassHash( blade * GRASS_RANDOM_STREAMS + stream) >> 8) * ( 1.0f / 16777216.0f));
+}
+
+#endif
@@ -0,0 +1,294 @@
+/*
+ * Work group size autotuner of grass_kernel, see GrassWorkGroupTuner.h
+ *
+ * Created By Vijaykumar Dangi
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "GrassField.h"
+#include "GrassProfiler.h"
+#include "GrassProgramCache.h"
+#include "GrassWorkGroupTuner.h"
+
+//grass_kernel shapes tried after the driver choice, blades of a tile x tiles
+static const size_t gWorkGroupShapes[ GRASS_WORK_GROUP_CANDIDATES - 2][2] =
+{
+    { 64, 1}, { 128, 1}, { 256, 1}, { 64, 4}, { 32, 4}, { 16, 16}, { 8, 8}
+};
+
+//
+//WorkGroupKey() :- GrassDeviceHash() and the program build options ( FNV-1a), each variant of the kernel tunes on its own
+//
+static unsigned long long WorkGroupKey( cl_device_id device, const char *options)
+{
+    //variable declarations
+    unsigned long long hash = GrassDeviceHash( device);
+
+    //code
+    for( const char *c = options; *c != '\0'; c++)
+    {
+        hash ^= (unsigned char)*c;
+        hash *= 0x100000001b3ULL;
+    }
+
+    return( hash);
+}
+
+//
+//GrassWorkGroupClass()
+//
+int GrassWorkGroupClass( int gridWidth, int gridHeight)
+{
+    //variable declarations
+    int side = MAX( gridWidth, gridHeight);
+    int gridClass = 0;
+
+    //code
+    while( (1 << gridClass) < side)
+    {
+        gridClass++;
+    }
+
+    return( gridClass);
+}
+
+//
+//GrassLoadWorkGroup()
+//
+int GrassLoadWorkGroup( const char *fileName, cl_device_id device, const char *options, int gridClass, GRASS_WORK_GROUP *workGroup)
+{
+    //variable declarations
+    char line[ 256];
+    unsigned long long deviceHash = WorkGroupKey( device, options);
+    unsigned long long storedHash;
+    int storedClass, kernel;
+    unsigned long local0, local1;
+    float ms;
+
+    //code
+    FILE *fp = fopen( fileName, "r");
+    if( fp == NULL)
+    {
+        return(-1);
+    }
+
+    while( fgets( line, sizeof( line), fp) != NULL)
+    {
+            //entries without a kernel field are from before grass_segment_kernel, tuned again
+        if( (sscanf( line, "%llx %d %d %lu %lu %f", &storedHash, &storedClass, &kernel, &local0, &local1, &ms) == 6) &&
+            (storedHash == deviceHash) && (storedClass == gridClass))
+        {
+            workGroup->kernel = kernel;
+            workGroup->local[0] = local0;
+            workGroup->local[1] = local1;
+            workGroup->ms = ms;
+
+            fclose( fp);
+            return(0);
+        }
+    }
+
+    fclose( fp);
+
+    return(-1);
+}
+
+//
+//GrassStoreWorkGroup() :- other entries copied to a temporary file, then renamed over the profile
+//
+int GrassStoreWorkGroup( const char *fileName, cl_device_id device, const char *options, int gridClass, const GRASS_WORK_GROUP *workGroup)
+{
+    //variable declarations
+    char tempFileName[ 512 + 8];
+    char line[ 256];
+    unsigned long long deviceHash = WorkGroupKey( device, options);
+    unsigned long long storedHash;
+    int storedClass;
+
+    //code
+    snprintf( tempFileName, sizeof( tempFileName), "%s.tmp", fileName);
+
+    FILE *out = fopen( tempFileName, "w");
+    if( out == NULL)
+    {
+        return(-1);
+    }
+
+    FILE *in = fopen( fileName, "r");
+    if( in != NULL)
+    {
+        while( fgets( line, sizeof( line), in) != NULL)
+        {
+            if( (sscanf( line, "%llx %d", &storedHash, &storedClass) == 2) && (storedHash == deviceHash) && (storedClass == gridClass))
+            {
+                continue;
+            }
+            fputs( line, out);
+        }
+        fclose( in);
+    }
+
+    fprintf( out, "%016llx %d %d %lu %lu %.4f\n", deviceHash, gridClass, workGroup->kernel, (unsigned long)workGroup->local[0], (unsigned long)workGroup->local[1], workGroup->ms);
+
+    if( fclose( out) != 0)
+    {
+        remove( tempFileName);
+        return(-1);
+    }
+
+    remove( fileName);
+    if( rename( tempFileName, fileName) != 0)
+    {
+        remove( tempFileName);
+        return(-1);
+    }
+
+    return(0);
+}
+
+//
+//GrassWorkGroupRange()
+//
+const size_t *GrassWorkGroupRange( const GRASS_WORK_GROUP *workGroup, size_t tileCount, int segments, size_t globalWorkSize[2])
+{
+    //code
+    globalWorkSize[0] = GRASS_TILE_SIZE * GRASS_TILE_SIZE;
+    globalWorkSize[1] = tileCount;
+
+    if( (workGroup != NULL) && (workGroup->kernel == GRASS_KERNEL_SEGMENT))
+    {
+            //a multiple of GRASS_SEGMENT_GROUP whatever the segments, tiles are not padded ( local size 1)
+        globalWorkSize[0] *= segments;
+        return( workGroup->local);
+    }
+
+    if( (workGroup == NULL) || (workGroup->local[0] == 0))
+    {
+        return( NULL);
+    }
+
+        //blades of a tile are a power of two, every shape divides them, only the tiles need padding
+    globalWorkSize[1] = ( tileCount + workGroup->local[1] - 1) / workGroup->local[1] * workGroup->local[1];
+
+    return( workGroup->local);
+}
+
+//
+//TimeWorkGroup() :- average ms of 'repeats' kernels after one warm up kernel, -1 on error
+//
+static float TimeWorkGroup( cl_command_queue queue, cl_kernel kernel, const GRASS_WORK_GROUP *workGroup, size_t tileCount, int segments, int repeats, cl_int *result)
+{
+    //variable declarations
+    size_t globalWorkSize[2];
+    const size_t *localWorkSize = GrassWorkGroupRange( workGroup, tileCount, segments, globalWorkSize);
+    long long start = 0;
+
+    //code
+    for( int i = -1; i < repeats; i++)
+    {
+        if( i == 0)
+        {
+            *result = clFinish( queue);
+            if( CL_SUCCESS != *result)
+            {
+                return(-1.0f);
+            }
+            start = GrassProfileNow();
+        }
+
+        *result = clEnqueueNDRangeKernel( queue, kernel, 2, NULL, globalWorkSize, localWorkSize, 0, NULL, NULL);
+        if( CL_SUCCESS != *result)
+        {
+            clFinish( queue);
+            return(-1.0f);
+        }
+    }
+
+    *result = clFinish( queue);
+    if( CL_SUCCESS != *result)
+    {
+        return(-1.0f);
+    }
+
+    return( ( GrassProfileNow() - start) * 1.0e-6f / repeats);
+}
+
+//
+//GrassTuneWorkGroup()
+//
+cl_int GrassTuneWorkGroup( cl_command_queue queue, cl_kernel kernel, cl_kernel segmentKernel, cl_device_id device, size_t tileCount, int segments, int repeats, GRASS_WORK_GROUP_TUNING *tuning)
+{
+    //variable declarations
+    size_t kernelMax = 0;
+    size_t itemMax[3] = { 0, 0, 0};
+    cl_uint tiles = (cl_uint)tileCount;
+    cl_int result;
+
+    //code
+    memset( tuning, 0, sizeof( GRASS_WORK_GROUP_TUNING));
+    tuning->count = 1;      //candidate[0] : driver choice
+
+    result = clSetKernelArg( kernel, GRASS_KERNEL_ARG_TILE_COUNT, sizeof( cl_uint), (void *)&tiles);
+    if( (CL_SUCCESS == result) && (segmentKernel != NULL))
+    {
+        result = clSetKernelArg( segmentKernel, GRASS_KERNEL_ARG_TILE_COUNT, sizeof( cl_uint), (void *)&tiles);
+    }
+    if( CL_SUCCESS != result)
+    {
+        return( result);
+    }
+
+        //shapes the device or this kernel ( registers) cannot run are not tried
+    clGetKernelWorkGroupInfo( kernel, device, CL_KERNEL_WORK_GROUP_SIZE, sizeof( kernelMax), &kernelMax, NULL);
+    clGetDeviceInfo( device, CL_DEVICE_MAX_WORK_ITEM_SIZES, sizeof( itemMax), itemMax, NULL);
+
+    for( int i = 0; i < GRASS_WORK_GROUP_CANDIDATES - 2; i++)
+    {
+        size_t local0 = gWorkGroupShapes[i][0];
+        size_t local1 = gWorkGroupShapes[i][1];
+
+        if( (local0 * local1 <= kernelMax) && (local0 <= itemMax[0]) && (local1 <= itemMax[1]))
+        {
+            tuning->candidate[ tuning->count].local[0] = local0;
+            tuning->candidate[ tuning->count].local[1] = local1;
+            tuning->count++;
+        }
+    }
+
+        //its work group size is required by the kernel, tried only when the device can run it
+    if( segmentKernel != NULL)
+    {
+        kernelMax = 0;
+        clGetKernelWorkGroupInfo( segmentKernel, device, CL_KERNEL_WORK_GROUP_SIZE, sizeof( kernelMax), &kernelMax, NULL);
+
+        if( (GRASS_SEGMENT_GROUP <= kernelMax) && (GRASS_SEGMENT_GROUP <= itemMax[0]))
+        {
+            tuning->candidate[ tuning->count].kernel = GRASS_KERNEL_SEGMENT;
+            tuning->candidate[ tuning->count].local[0] = GRASS_SEGMENT_GROUP;
+            tuning->candidate[ tuning->count].local[1] = 1;
+            tuning->count++;
+        }
+    }
+
+    for( int i = 0; i < tuning->count; i++)
+    {
+        cl_kernel candidateKernel = ( tuning->candidate[i].kernel == GRASS_KERNEL_SEGMENT) ? segmentKernel : kernel;
+        tuning->candidate[i].ms = TimeWorkGroup( queue, candidateKernel, &tuning->candidate[i], tileCount, segments, repeats, &result);
+
+            //a shape the runtime still rejects is skipped, the driver choice has to run
+        if( (CL_SUCCESS != result) && (i == 0))
+        {
+            return( result);
+        }
+
+        if( (tuning->candidate[i].ms >= 0.0f) && (tuning->candidate[i].ms < tuning->candidate[ tuning->best].ms))
+        {
+            tuning->best = i;
+        }
+    }
+
+    return( CL_SUCCESS);
+}
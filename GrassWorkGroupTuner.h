@@ -0,0 +1,74 @@
+#ifndef __GRASS_WORK_GROUP_TUNER_H__
+#define __GRASS_WORK_GROUP_TUNER_H__
+
+/*
+ * Work group size autotuner of grass_kernel.
+ *
+ * grass_kernel runs on a 2D range, blades of a tile x tiles. Instead of a
+ * NULL local size ( driver choice) GrassTuneWorkGroup() times a few local
+ * shapes on the current tiles and keeps the fastest, the driver choice
+ * included so a tuned shape is never slower. Dimension 1 is padded up to
+ * the shape, the kernel drops the padded tiles against its tile count
+ * argument.
+ *
+ * grass_segment_kernel ( one work item per blade and segment, fixed
+ * GRASS_SEGMENT_GROUP x 1 work groups) is one more candidate, so small grids
+ * that leave the device idle with one item per blade switch to it only when
+ * it measures faster.
+ *
+ * Results are kept per device ( GrassDeviceHash()), build options ( kernel
+ * variant) and grid class in a small text profile, one
+ * "<device + options> <class> <kernel> <local 0> <local 1> <ms>" line per
+ * entry, so later starts load them instead of tuning again.
+ */
+
+#include <CL/opencl.h>
+
+//macro
+#define  GRASS_KERNEL_ARG_TILE_COUNT    14      //grass_kernel argument, tiles of the unpadded range
+#define  GRASS_WORK_GROUP_CANDIDATES    9       //driver choice + local shapes tried + grass_segment_kernel
+#define  GRASS_SEGMENT_GROUP            128     //local size 0 of grass_segment_kernel, same as Grass.cl
+
+    //kernel a GRASS_WORK_GROUP runs
+#define  GRASS_KERNEL_BLADE             0       //grass_kernel, one item per blade
+#define  GRASS_KERNEL_SEGMENT           1       //grass_segment_kernel, one item per ( blade, segment)
+
+//local work size of grass_kernel, 0 x 0 : NULL local size ( driver choice)
+typedef struct GRASS_WORK_GROUP
+{
+    int kernel;         //GRASS_KERNEL_*
+    size_t local[2];    //blades ( or blade segments) of a tile, tiles
+    float ms;           //kernel time when it was tuned, -1 : rejected by clEnqueueNDRangeKernel()
+} GRASS_WORK_GROUP;
+
+//every shape GrassTuneWorkGroup() timed
+typedef struct GRASS_WORK_GROUP_TUNING
+{
+    GRASS_WORK_GROUP candidate[ GRASS_WORK_GROUP_CANDIDATES];
+    int count;          //candidates within the kernel and device limits
+    int best;           //fastest of them
+} GRASS_WORK_GROUP_TUNING;
+
+
+//function declarations
+
+    //grid class a profile entry is kept for, log2 of the grid side rounded up
+int GrassWorkGroupClass( int gridWidth, int gridHeight);
+
+    //entry of 'device', program build 'options' and 'gridClass' in the profile, return 0 when found,
+    //-1 when not ( *workGroup untouched)
+int GrassLoadWorkGroup( const char *fileName, cl_device_id device, const char *options, int gridClass, GRASS_WORK_GROUP *workGroup);
+    //add or replace that entry, return 0 on success, -1 when the file cannot be written
+int GrassStoreWorkGroup( const char *fileName, cl_device_id device, const char *options, int gridClass, const GRASS_WORK_GROUP *workGroup);
+
+    //time every candidate on 'tileCount' tiles, 'repeats' kernels each, arguments other than
+    //GRASS_KERNEL_ARG_TILE_COUNT have to be set on both kernels and the output acquired.
+    //'segments' : most segments of a tile ( level 0), NULL 'segmentKernel' : grass_kernel only.
+    //Return CL_SUCCESS with tuning->candidate[ tuning->best] the fastest, else the error of the driver choice
+cl_int GrassTuneWorkGroup( cl_command_queue queue, cl_kernel kernel, cl_kernel segmentKernel, cl_device_id device, size_t tileCount, int segments, int repeats, GRASS_WORK_GROUP_TUNING *tuning);
+
+    //global size of 'tileCount' tiles of up to 'segments' segments padded to 'workGroup', return the
+    //local size for clEnqueueNDRangeKernel() ( NULL : driver choice)
+const size_t *GrassWorkGroupRange( const GRASS_WORK_GROUP *workGroup, size_t tileCount, int segments, size_t globalWorkSize[2]);
+
+#endif
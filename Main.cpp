@@ -15,6 +15,11 @@
 #include "ArcCamera.h"
 #include "Resource.h"
 #include "FreeType2DText.h"
+#include "GrassField.h"
+#include "GrassProfiler.h"
+#include "GrassProgramCache.h"
+#include "GrassWorkGroupTuner.h"
+#include "GrassOpenCL.h"
 
 //Library
 #pragma comment( lib, "User32.lib")
@@ -26,13 +31,20 @@
 #pragma comment( lib, "OpenCL.lib")
 
 //macro
-#define  MAX_MESH_SIZE          1024
-#define  MIN_MESH_SIZE          2
-#define  MESH_MULTIPLICANT      0.1f
-#define  MESH_AMPLITUDE         5.0f
 #define  GRASS_BLADE_SEGMENTS   12
 #define  MSAA_SAMPLES           4
 #define  COLOR_CHANNELS         4
+#define  MAX_GRASS_TILES        ( ( MAX_MESH_SIZE + GRASS_TILE_SIZE - 1) / GRASS_TILE_SIZE)
+#define  MAX_GRASS_DRAWS        ( MAX_GRASS_TILES * MAX_GRASS_TILES * ( GRASS_TILE_SIZE * GRASS_TILE_SIZE / GRASS_TEMPLATE_BLADES + 1))
+
+#define  OCL_COMMAND_WRITE_MESH     0       //enqueued commands timed with OpenCL events
+#define  OCL_COMMAND_WRITE_TILES    1
+#define  OCL_COMMAND_ACQUIRE        2
+#define  OCL_COMMAND_KERNEL         3
+#define  OCL_COMMAND_RELEASE        4
+#define  OCL_COMMAND_TYPES          5
+#define  OCL_MAX_PENDING_EVENTS     16
+#define  OCL_INTEROP_BUFFERS        3       //grass VBOs shared with OpenCL, the pipelined mode cycles through 2 or 3
 
 #define  USE_FREE_CAMERA  0
 #define  USE_ARC_CAMERA   1
@@ -69,41 +81,19 @@ GLuint program_alpha;
 GLuint program_light;
 
 //Mesh data
-typedef struct VERTEX
-{
-    float position[3];
-    float normal[3];
-    float tangent[3];
-    float texcoord[2];
-}VERTEX;
-
-typedef struct GRASS_VERTEX
-{
-    float position[3];
-    float normal[3];
-    float texcoord[2];
-}GRASS_VERTEX;
-
-typedef struct GRASS_STATIC_PROPERTIES
-{
-    vmath::mat4 tangentToLocalMatrix;
-    vmath::mat4 facingRotationMatrix;
-    vmath::mat4 bendRotationMatrix;
-    float width;
-    float height;
-    float forward;
-} GRASS_STATIC_PROPERTIES;
+GrassField grassField;
 
-VERTEX meshVertexData[MAX_MESH_SIZE * MAX_MESH_SIZE];
-GRASS_STATIC_PROPERTIES *grassStaticProps_cpu = NULL;
+//blade roots : procedural grid (default) or CreateMesh() vertices uploaded to OpenCL
+bool gbProceduralGrid = true;
+GRASS_GRID grassGrid;
+VERTEX *meshVertexData = NULL;
+int grassInputCapacity = 0;     //blades meshVertexData / meshVertexData_opencl_input can hold, 0 in procedural mode
 
 GLuint vbo_element_common;
 
 GLuint vao_grass_cpu;
 GLuint vbo_grassBuffer_cpu;
 
-GLuint vao_grass_opencl;
-GLuint vbo_grassBuffer_opencl;
 
 GLuint vao_quad;
 GLuint vbo_quad;
@@ -113,12 +103,57 @@ GLuint vbo_light;
 
 int grassVerticesCount = 0;
 int grassIndicesCount = 0;
+int grassBladeCapacity = 0;     //blades the grass VBOs / OpenCL input buffer can hold
+
+//grass index buffer : full (indices of every blade) or shared template drawn with base vertex
+enum GRASS_INDEX_MODE
+{
+    GRASS_INDEX_FULL = 0,
+    GRASS_INDEX_TEMPLATE
+};
+
+GRASS_INDEX_MODE grassIndexMode = GRASS_INDEX_TEMPLATE;
+GRASS_INDEX_MODE grassIndexBufferMode = GRASS_INDEX_FULL;   //mode vbo_element_common was last sized for
+int grassIndexCapacity = 0;     //blades vbo_element_common holds indices for
+
+//draws of the visible blades, rebuilt every frame after culling
+typedef struct GRASS_DRAW_LIST
+{
+    GLsizei counts[ MAX_GRASS_DRAWS];
+    GLint baseVertex[ MAX_GRASS_DRAWS];         //template : first vertex of the run, full : 0
+    const void *offsets[ MAX_GRASS_DRAWS];      //template : template of the run's LOD level, full : 0
+    int count;
+} GRASS_DRAW_LIST;
+
+GRASS_DRAW_LIST grassDraws;
+
+//frustum culling of grass tiles
+bool gbCullGrass = true;
+int grassVisibleBlades = 0;
+double grassCullMs = 0.0;       //cull + draw list
+double grassUpdateMs = 0.0;     //simulation of the visible blades, CPU or OpenCL
+
+//distance based blade LOD of the visible tiles ( template index mode only, full indices are at GRASS_BLADE_SEGMENTS)
+bool gbGrassLod = true;
+
+//time sliced updates of distant tiles ( template index mode only), 'K' cycles the per frame blade budget
+bool gbGrassSchedule = false;
+int grassBudgets[] = { 0, 262144, 131072, 65536, 32768};     //0 : no limit, period only
+int grassBudgetIndex = 0;
+
+//analytic wind ( GRASS_PROCEDURAL_WIND) instead of the distortion map, 'F2'
+bool gbProceduralWind = false;
+
+double grassResizeMs = 0.0;     //last grid resize hitch, total and index buffer part
+double grassIndexMs = 0.0;
 
 int currentMeshWidth = MIN_MESH_SIZE;
 int currentMeshHeight = MIN_MESH_SIZE;
 
 //wind distortion map (dudv map)
 IMAGE_DATA windDistortion_map;
+unsigned char *windDistortion_packed = NULL;    //red / green bytes in 8 x 8 texel blocks, read by both grass paths
+GRASS_WIND_MAP grassWindMap;
 
 GLuint grassBladeTexture;
 GLuint grassBladeAlphaTexture;
@@ -143,18 +178,74 @@ vmath::mat4 projection_matrix;
 
 //OpenCL Related Variables
 cl_int            clResult;
-cl_mem            cl_graphics_resource_mesh;
 cl_device_id      oclComputeDeviceId;
 cl_context        oclContext;
 cl_command_queue  oclCommandQueue;
 cl_program        oclGrassProgram;
 cl_kernel         oclGrassKernel;
+cl_kernel         oclGrassSegmentKernel = NULL;     //same arguments, one work item per ( blade, segment)
+GRASS_CL_DEVICE   oclDevice;                        //selected by -cldevice on the command line, else the first GPU
+char              oclDeviceSelector[ 128] = "";     //-cldevice <index | part of the name>
+bool              bOpenCLHostBuffers = false;       //no GL sharing ( CPU devices) : the kernel writes the mapped GL buffer in place
 
 cl_mem meshVertexData_opencl_input = NULL;
-cl_mem distortionMap_opencl_input = NULL;
+cl_mem distortionMap_opencl_input = NULL;     //packed wind map, devices without image support
+cl_mem distortionMap_opencl_image = NULL;     //same bytes as a CL_RG image, sampled with filtering hardware
+bool bOpenCLWindImage = false;
+cl_mem grassTiles_opencl_input = NULL;     //GRASS_LOD_TILE of the visible tiles, rewritten every frame
+
+//OpenCL event timestamps of every enqueue ( CL_QUEUE_PROFILING_ENABLE), 'F4' toggles collection
+typedef struct OCL_COMMAND_EVENT
+{
+    int command;        //OCL_COMMAND_*
+    cl_event event;
+    long long hostNs;   //GrassProfileNow() at enqueue, lines the device clock up with the host zones
+} OCL_COMMAND_EVENT;
+
+const char *oclCommandNames[ OCL_COMMAND_TYPES] = { "write mesh", "write tiles", "acquire GL", "grass_kernel", "release GL"};
+bool gbOpenCLProfiling = true;
+bool bOpenCLQueueProfiling = false;     //false when the queue could not be created with profiling
+OCL_COMMAND_EVENT oclPendingEvents[ OCL_MAX_PENDING_EVENTS];
+int oclPendingEventCount = 0;
+GRASS_PROFILE_STAT oclCommandWait[ OCL_COMMAND_TYPES];      //queued -> start, ms
+GRASS_PROFILE_STAT oclCommandTime[ OCL_COMMAND_TYPES];      //start -> end, ms
+
+//grass VBO shared with OpenCL, [0] only in the synchronous mode
+typedef struct OCL_INTEROP_BUFFER
+{
+    GLuint vao;
+    GLuint vbo;
+    cl_mem resource;            //clCreateFromGLBuffer() of vbo
+    cl_event written;           //release after the last kernel writing it, NULL : nothing in flight
+    GLsync drawn;               //fence after the last draw reading it, NULL : not drawn since
+    GRASS_DRAW_LIST draws;      //draws of the frame computed into it
+    GRASS_LOD_TILE tiles[ MAX_GRASS_TILES * MAX_GRASS_TILES];  //host copy the non blocking tile write reads from
+    long long enqueueNs;        //GrassProfileNow() when that frame was enqueued
+    bool valid;                 //holds a computed frame
+} OCL_INTEROP_BUFFER;
+
+OCL_INTEROP_BUFFER oclInterop[ OCL_INTEROP_BUFFERS];
+int oclPipelineDepth = 1;       //1 : clFinish() every frame, 2 / 3 : kernel of frame N + 1 runs while N is drawn, 'F5' cycles
+int oclComputeBuffer = 0;       //interop buffer the next kernel writes
+int oclDrawBuffer = 0;          //interop buffer Display() draws
+bool bGrassKernelArgsDirty = true;  //arguments other than the output and time need to be set again
+long long oclLastFrameNs = 0;
+
+//synchronous against pipelined, indexed by depth - 1
+GRASS_PROFILE_STAT oclFrameMs[ OCL_INTEROP_BUFFERS];        //UpdateGrassData() to UpdateGrassData()
+GRASS_PROFILE_STAT oclLatencyMs[ OCL_INTEROP_BUFFERS];      //kernel enqueue to the draw of its output
+GRASS_PROFILE_STAT oclHostWaitMs[ OCL_INTEROP_BUFFERS];     //host blocked on OpenCL / GL per frame
 
 const char grassOpenCLFileName[] = "Grass.cl";
+const char grassProgramCachePrefix[] = "GrassProgram";     //GrassProgram_<key>.bin next to the executable, delete to force a rebuild
 const char grassKernelName[] = "grass_kernel";
+const char grassSegmentKernelName[] = "grass_segment_kernel";
+const char grassKernelOptions[] = "-cl-fast-relaxed-math -D GRASS_KERNEL_FLOAT4";     //without the define : Matrix4x4 reference kernel
+char grassKernelBuildOptions[ 256];     //grassKernelOptions + the device dependent ones
+const char grassWorkGroupProfile[] = "GrassWorkGroup.txt";  //tuned local sizes per device and grid class, delete to tune again
+
+GRASS_WORK_GROUP oclWorkGroup;      //kernel and local size for oclWorkGroupClass
+int oclWorkGroupClass = -1;         //grid class oclWorkGroup was loaded or tuned for, -1 : none yet
 
 bool bOnGPU = false;
 bool bNeedToUpdateBuffers = true;
@@ -258,6 +349,13 @@ int WINAPI WinMain( HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR szCmdLin
     
     fprintf( gpLogFile, "Log File Opened\n");
 
+        //OpenCL device, "-cldevice 1" or "-cldevice cpu"
+    const char *deviceOption = strstr( szCmdLine, "-cldevice");
+    if( deviceOption != NULL)
+    {
+        sscanf( deviceOption + strlen( "-cldevice"), "%127s", oclDeviceSelector);
+    }
+
     //initialize window attributes
     wndclass.cbSize        = sizeof( WNDCLASSEX);
     wndclass.style         = CS_HREDRAW | CS_VREDRAW | CS_OWNDC;
@@ -324,6 +422,8 @@ int WINAPI WinMain( HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR szCmdLin
         {
             if( gbActiveWindow == true)
             {
+                GrassProfileBeginFrame();
+
                 Update();
                 Display();
 
@@ -482,16 +582,120 @@ LRESULT CALLBACK WndProc( HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam)
 #endif
 
                 case 'H':
-                    bOnGPU = true;
+                    {
+                        void ResetOpenCLPipeline( void);
+
+                        bOnGPU = true;
+                        ResetOpenCLPipeline();      //other vertex buffer, frames left in flight are stale
+                    }
                 break;
 
                 case 'P':
                     bOnGPU = false;
+                    grassField.invalidateSchedule();
                 break;
 
                 case 'L':
                     gbEnableLight = !gbEnableLight;
                 break;
+
+                case 'V':
+                    gbProceduralGrid = !gbProceduralGrid;
+                    bNeedToUpdateBuffers = true;
+                break;
+
+                case 'U':
+                    {
+                        void LogGrassCulling( void);
+
+                        LogGrassCulling();
+                        gbCullGrass = !gbCullGrass;
+                    }
+                break;
+
+                case 'O':
+                    {
+                        void LogGrassCulling( void);
+
+                        LogGrassCulling();
+                        gbGrassLod = !gbGrassLod;
+                    }
+                break;
+
+                case 'J':
+                    {
+                        void LogGrassCulling( void);
+
+                        LogGrassCulling();
+                        gbGrassSchedule = !gbGrassSchedule;
+                        grassField.resetScheduleStats();
+                    }
+                break;
+
+                case VK_F2:
+                    gbProceduralWind = !gbProceduralWind;
+                    bGrassKernelArgsDirty = true;
+                break;
+
+                case VK_F3:
+                    {
+                        void LogOpenCLCommandStats( void);
+                        void LogOpenCLPipelineStats( void);
+
+                            //last GRASS_PROFILE_CAPACITY timing zones, open the .json in chrome://tracing or Perfetto
+                        int zoneCount = GrassProfileWriteTrace( "GrassProfile.json");
+                        GrassProfileWriteCsv( "GrassProfile.csv");
+
+                        fprintf( gpLogFile, "Grass profile: %d zones written to GrassProfile.json / GrassProfile.csv\n", zoneCount);
+                        LogOpenCLCommandStats();
+                        LogOpenCLPipelineStats();
+                    }
+                break;
+
+                case VK_F4:
+                    gbOpenCLProfiling = !gbOpenCLProfiling;
+                break;
+
+                case VK_F5:
+                    {
+                        void ResetOpenCLPipeline( void);
+                        void LogOpenCLPipelineStats( void);
+
+                        LogOpenCLPipelineStats();
+                        ResetOpenCLPipeline();
+                        if( !bOpenCLHostBuffers)    //mapped GL buffers : synchronous only
+                        {
+                            oclPipelineDepth = ( oclPipelineDepth % OCL_INTEROP_BUFFERS) + 1;
+                        }
+                    }
+                break;
+
+                case 'K':
+                    grassBudgetIndex = ( grassBudgetIndex + 1) % ( sizeof( grassBudgets) / sizeof( grassBudgets[0]));
+                    grassField.schedule.bladeBudget = grassBudgets[ grassBudgetIndex];
+                    grassField.resetScheduleStats();
+                break;
+
+                case 'E':
+                    grassIndexMode = ( grassIndexMode == GRASS_INDEX_FULL) ? GRASS_INDEX_TEMPLATE : GRASS_INDEX_FULL;
+                    bNeedToUpdateBuffers = true;
+                break;
+
+                case 'T':
+                    {
+                        void LogGrassThreadStats( void);
+
+                        LogGrassThreadStats();
+
+                        int maxThreads = (int) std::thread::hardware_concurrency();
+                        int threads = grassField.getThreadCount() * 2;
+                        if( threads > maxThreads)
+                        {
+                            threads = ( grassField.getThreadCount() < maxThreads) ? maxThreads : 1;
+                        }
+                        grassField.setThreadCount( threads);
+                    }
+                break;
                 
                 default:
                 break;
@@ -862,13 +1066,7 @@ int Initialize( void)
 {
     //function declaration
     void Resize( int, int);
-    float HeightCalculate( float, float, float);
-    void CreateMesh(
-        int cx, int cz, int MeshWidth, int MeshHeight,
-        float multiplicant, float amplitude,
-        VERTEX **vertexData, int *vertexCount,
-        float (*heightFunc)(float, float, float)    //height function
-    );
+    int ReserveGrassBuffers( int);
 
     //variable declarations
     PIXELFORMATDESCRIPTOR pfd;
@@ -975,67 +1173,82 @@ int Initialize( void)
     fpOpenGLInfo = NULL;
 
     /* ___________________________________ OpenCL Context ___________________________________ */
-    cl_platform_id  oclPlatformID;
-    cl_device_id   *oclDeviceIDs;
-    cl_uint         deviceCount;
+    long long oclInitStart = GrassProfileNow();
+    GRASS_CL_DEVICE oclDevices[ GRASS_MAX_CL_DEVICES];
 
-        //get platform
-    clResult = clGetPlatformIDs( 1, &oclPlatformID, NULL);
-    if( CL_SUCCESS != clResult)
+        //every device of every platform, GPU first unless -cldevice names another one
+    int oclDeviceCount = GrassEnumerateDevices( oclDevices, GRASS_MAX_CL_DEVICES);
+    for( int i = 0; i < oclDeviceCount; i++)
     {
-        fprintf( gpLogFile, "OpenCL Error(%d): clGetPlatformIDs() Failed\n", __LINE__);
-        return(-1);
+        fprintf( gpLogFile, "OpenCL device %d : %s, %s ( %s)%s\n", i, GrassDeviceTypeName( oclDevices[i].type), oclDevices[i].name,
+            oclDevices[i].platformName, oclDevices[i].glSharing ? ", GL sharing" : "");
     }
 
-        //get supported device count
-    clResult = clGetDeviceIDs( oclPlatformID, CL_DEVICE_TYPE_GPU, 0, NULL, &deviceCount);
-    if( CL_SUCCESS != clResult)
-    {
-        fprintf( gpLogFile, "OpenCL Error(%d): clGetDeviceIDs() Failed\n", __LINE__);
-        return(-1);
-    }
-    else if( deviceCount < 1)
+    int oclDeviceIndex = GrassSelectDevice( oclDevices, oclDeviceCount, oclDeviceSelector, CL_DEVICE_TYPE_GPU);
+    if( oclDeviceIndex < 0)
     {
-        fprintf( gpLogFile, "OpenCL Error(%d): No device which support OpenCL\n", __LINE__);
+        fprintf( gpLogFile, "OpenCL Error(%d): No device which support OpenCL ( -cldevice \"%s\")\n", __LINE__, oclDeviceSelector);
         return(-1);
     }
 
-        //allocate memory
-    oclDeviceIDs = ( cl_device_id *) calloc( deviceCount, sizeof( cl_device_id));
+    oclDevice = oclDevices[ oclDeviceIndex];
+    oclComputeDeviceId = oclDevice.device;
 
-        //get devices
-    clResult = clGetDeviceIDs( oclPlatformID, CL_DEVICE_TYPE_GPU, deviceCount, oclDeviceIDs, NULL);
-    if( CL_SUCCESS != clResult)
+        //CPU runtimes have no GL sharing, their output goes through host memory
+    bOpenCLHostBuffers = !oclDevice.glSharing || ( oclDevice.type & CL_DEVICE_TYPE_CPU);
+
+    if( !bOpenCLHostBuffers)
     {
-        fprintf( gpLogFile, "OpenCL Error(%d): clGetDeviceIDs() Failed\n", __LINE__);
-        return(-1);
+        //Create OpenCL Context which is compatible with OpenGL Context
+        cl_context_properties context_properties[] =
+        {
+            CL_GL_CONTEXT_KHR, (cl_context_properties) wglGetCurrentContext(),
+            CL_WGL_HDC_KHR, (cl_context_properties) wglGetCurrentDC(),
+            CL_CONTEXT_PLATFORM, (cl_context_properties) oclDevice.platform,
+            0   //end of array
+        };
+
+        oclContext = clCreateContext( context_properties, 1, &oclComputeDeviceId, NULL, NULL, &clResult);
+        if( CL_SUCCESS != clResult)
+        {
+                //a device of another adapter than the GL context, still usable without sharing
+            fprintf( gpLogFile, "OpenCL: no GL sharing context (%d), host buffers\n", clResult);
+            bOpenCLHostBuffers = true;
+        }
     }
 
-        //get first device
-    oclComputeDeviceId = oclDeviceIDs[0];
+    if( bOpenCLHostBuffers)
+    {
+        cl_context_properties context_properties[] =
+        {
+            CL_CONTEXT_PLATFORM, (cl_context_properties) oclDevice.platform,
+            0   //end of array
+        };
+
+        oclContext = clCreateContext( context_properties, 1, &oclComputeDeviceId, NULL, NULL, &clResult);
+        if( CL_SUCCESS != clResult)
+        {
+            fprintf( gpLogFile, "OpenCL Error(%d): clCreateContext() Failed: %d\n", __LINE__, clResult);
+            return(-1);
+        }
 
-    free(oclDeviceIDs);
-    oclDeviceIDs = NULL;
+            //buffers go through glMapBuffer(), one frame at a time
+        oclPipelineDepth = 1;
+    }
 
+    fprintf( gpLogFile, "OpenCL on %s ( %s), %s\n", oclDevice.name, GrassDeviceTypeName( oclDevice.type),
+        bOpenCLHostBuffers ? "kernel writes the mapped GL buffer ( CL_MEM_USE_HOST_PTR)" : "GL sharing");
 
-    //Create OpenCL Context which is compatible with OpenGL Context
-    cl_context_properties context_properties[] =
-    {
-        CL_GL_CONTEXT_KHR, (cl_context_properties) wglGetCurrentContext(),
-        CL_WGL_HDC_KHR, (cl_context_properties) wglGetCurrentDC(),
-        CL_CONTEXT_PLATFORM, (cl_context_properties) oclPlatformID,
-        0   //end of array
-    };
+    //create command queue, with event timestamps when the device allows it
+    cl_queue_properties queueProperties[] = { CL_QUEUE_PROPERTIES, CL_QUEUE_PROFILING_ENABLE, 0};
 
-    oclContext = clCreateContext( context_properties, 1, &oclComputeDeviceId, NULL, NULL, &clResult);
+    oclCommandQueue = clCreateCommandQueueWithProperties( oclContext, oclComputeDeviceId, queueProperties, &clResult);
+    bOpenCLQueueProfiling = ( CL_SUCCESS == clResult);
     if( CL_SUCCESS != clResult)
     {
-        fprintf( gpLogFile, "OpenCL Error(%d): clCreateContext() Failed: %d\n", __LINE__, clResult);
-        return(-1);
+        fprintf( gpLogFile, "OpenCL: no queue profiling (%d), command timings disabled\n", clResult);
+        oclCommandQueue = clCreateCommandQueueWithProperties( oclContext, oclComputeDeviceId, 0, &clResult);
     }
-
-    //create command queue
-    oclCommandQueue = clCreateCommandQueueWithProperties( oclContext, oclComputeDeviceId, 0, &clResult);
     if( CL_SUCCESS != clResult)
     {
         fprintf( gpLogFile, "OpenCL Error(%d): clCreateCommandQueueWithProperties() Failed\n", __LINE__);
@@ -1050,25 +1263,29 @@ int Initialize( void)
         return(-1);
     }
 
-    size_t clSourceCodeSize = strlen( openclGrassKernelSourceCode) + 1;
+        //wind map through an image2d_t and the sampler when the device can, else the packed buffer
+    bOpenCLWindImage = GrassWindImageSupported( oclContext, oclComputeDeviceId);
+    snprintf( grassKernelBuildOptions, sizeof( grassKernelBuildOptions), "%s%s", grassKernelOptions, bOpenCLWindImage ? GRASS_WIND_IMAGE_OPTION : "");
+    fprintf( gpLogFile, "OpenCL wind map : %s\n", bOpenCLWindImage ? "CL_RG unorm8 image, linear filtering" : "packed buffer, no CL_RG image support");
 
-    //create OpenCL program
-    oclGrassProgram = clCreateProgramWithSource( oclContext, 1, (const char **)&openclGrassKernelSourceCode, &clSourceCodeSize, &clResult);
-    if( CL_SUCCESS != clResult)
-    {
-        fprintf( gpLogFile, "OpenCL Error(%d): clCreateProgramWithSource() Failed\n", __LINE__);
+    //create and build OpenCL program, from the binary cache when source, options, device and driver match
+    GRASS_PROGRAM_SOURCE programSource;
+    long long programStart = GrassProfileNow();
 
-        free( (void *)openclGrassKernelSourceCode);
-        openclGrassKernelSourceCode = NULL;
-        
-        return(-1);
-    }
+    oclGrassProgram = GrassBuildProgramCached( oclContext, oclComputeDeviceId, openclGrassKernelSourceCode, grassKernelBuildOptions, grassProgramCachePrefix, &programSource, &clResult);
+
+    long long programEnd = GrassProfileNow();
+    GrassProfileRecord( "opencl program", programStart, programEnd);
 
     free( (void *)openclGrassKernelSourceCode);
     openclGrassKernelSourceCode = NULL;
 
-    //build program
-    clResult = clBuildProgram( oclGrassProgram, 0, NULL, "-cl-fast-relaxed-math", NULL, NULL);
+    if( oclGrassProgram == NULL)
+    {
+        fprintf( gpLogFile, "OpenCL Error(%d): clCreateProgramWithSource() Failed (%d)\n", __LINE__, clResult);
+        return(-1);
+    }
+
     if( CL_SUCCESS != clResult)
     {
         fprintf( gpLogFile, "OpenCL Error(%d): clBuildProgram() Failed (%d)\n", __LINE__, clResult);
@@ -1101,6 +1318,17 @@ int Initialize( void)
         return(-1);
     }
 
+    oclGrassSegmentKernel = clCreateKernel( oclGrassProgram, grassSegmentKernelName, &clResult);
+    if( CL_SUCCESS != clResult)
+    {
+        fprintf( gpLogFile, "OpenCL Error(%d): clCreateKernel() Failed for %s\n", __LINE__, grassSegmentKernelName);
+        return(-1);
+    }
+
+        //cold ( source build) against warm ( cached binary) start
+    fprintf( gpLogFile, "OpenCL init %.1f ms, program from %s in %.1f ms\n",
+        ( GrassProfileNow() - oclInitStart) * 1.0e-6, GrassProgramSourceName( programSource), ( programEnd - programStart) * 1.0e-6);
+
 
     /** _______________________________ SHADERS ____________________________ **/
     //Simple program
@@ -1254,20 +1482,13 @@ int Initialize( void)
 
     /* _____________ Mesh Buffer ______________ */
 
-    int maxGrassVerticesCount = MAX_MESH_SIZE * MAX_MESH_SIZE * 2 * GRASS_BLADE_SEGMENTS;
-
-    int trianglePerGrassBlade = 2 * (GRASS_BLADE_SEGMENTS - 1);
-    int verticesPerTriangle = 3;
-    int maxGrassIndicesCount = MAX_MESH_SIZE * MAX_MESH_SIZE * trianglePerGrassBlade * verticesPerTriangle;
-
-    grassStaticProps_cpu = ( GRASS_STATIC_PROPERTIES *) calloc( maxGrassVerticesCount, sizeof( GRASS_STATIC_PROPERTIES));
+    grassField.params.segments = GRASS_BLADE_SEGMENTS;
+    grassField.setThreadCount( 0);      //one per hardware thread, 'T' cycles 1, 2, 4 ..
+    fprintf( gpLogFile, "Grass CPU kernel : %s, %d threads\n", GrassSimdName( grassField.getSimdLevel()), grassField.getThreadCount());
 
 
         //common buffer to both OpenCL and CPU vao
     glGenBuffers(1, &vbo_element_common);
-			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vbo_element_common);
-			glBufferData(GL_ELEMENT_ARRAY_BUFFER, maxGrassIndicesCount * sizeof(GLuint), NULL, GL_STATIC_DRAW);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
 
         //CPU VERTEX ARRAY AND BUFFER
@@ -1275,8 +1496,6 @@ int Initialize( void)
 	glBindVertexArray(vao_grass_cpu);
 		glGenBuffers(1, &vbo_grassBuffer_cpu);
 		glBindBuffer(GL_ARRAY_BUFFER, vbo_grassBuffer_cpu);
-			glBufferData(GL_ARRAY_BUFFER, maxGrassVerticesCount * sizeof(GRASS_VERTEX), NULL, GL_STATIC_DRAW);
-
 			glVertexAttribPointer(VJD_ATTRIBUTE_POSITION,   3, GL_FLOAT, GL_FALSE, sizeof(GRASS_VERTEX), (void*)offsetof(GRASS_VERTEX, position));
 			glVertexAttribPointer(VJD_ATTRIBUTE_NORMAL,     3, GL_FLOAT, GL_FALSE, sizeof(GRASS_VERTEX), (void*)offsetof(GRASS_VERTEX, normal));
 			glVertexAttribPointer(VJD_ATTRIBUTE_TEXTCOORD,  2, GL_FLOAT, GL_FALSE, sizeof(GRASS_VERTEX), (void*)offsetof(GRASS_VERTEX, texcoord));
@@ -1291,49 +1510,32 @@ int Initialize( void)
 	glBindVertexArray(0);
 
 
-	    //OpenCL VERTEX ARRAY AND BUFFER
-    glGenVertexArrays(1, &vao_grass_opencl);
-	glBindVertexArray(vao_grass_opencl);
-		glGenBuffers(1, &vbo_grassBuffer_opencl);
-		glBindBuffer(GL_ARRAY_BUFFER, vbo_grassBuffer_opencl);
-			glBufferData(GL_ARRAY_BUFFER, maxGrassVerticesCount * sizeof(GRASS_VERTEX), NULL, GL_STATIC_DRAW);
-
-			glVertexAttribPointer(VJD_ATTRIBUTE_POSITION,   3, GL_FLOAT, GL_FALSE, sizeof(GRASS_VERTEX), (void*)offsetof(GRASS_VERTEX, position));
-			glVertexAttribPointer(VJD_ATTRIBUTE_NORMAL,     3, GL_FLOAT, GL_FALSE, sizeof(GRASS_VERTEX), (void*)offsetof(GRASS_VERTEX, normal));
-			glVertexAttribPointer(VJD_ATTRIBUTE_TEXTCOORD,  2, GL_FLOAT, GL_FALSE, sizeof(GRASS_VERTEX), (void*)offsetof(GRASS_VERTEX, texcoord));
-
-			glEnableVertexAttribArray(VJD_ATTRIBUTE_POSITION);
-			glEnableVertexAttribArray(VJD_ATTRIBUTE_NORMAL);
-			glEnableVertexAttribArray(VJD_ATTRIBUTE_TEXTCOORD);
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-        //Create OpenCL graphics resource for OpenGL buffer
-        cl_graphics_resource_mesh = clCreateFromGLBuffer( oclContext, CL_MEM_WRITE_ONLY, vbo_grassBuffer_opencl, &clResult);
-        if( CL_SUCCESS != clResult)
-        {
-            fprintf( gpLogFile, "clCreateFromGLBuffer() Failed\n");
-            return(-1);
-        }
+	    //OpenCL VERTEX ARRAYS AND BUFFERS, one per interop buffer
+    for( int i = 0; i < OCL_INTEROP_BUFFERS; i++)
+    {
+        glGenVertexArrays(1, &oclInterop[i].vao);
+        glBindVertexArray(oclInterop[i].vao);
+            glGenBuffers(1, &oclInterop[i].vbo);
+            glBindBuffer(GL_ARRAY_BUFFER, oclInterop[i].vbo);
+                glVertexAttribPointer(VJD_ATTRIBUTE_POSITION,   3, GL_FLOAT, GL_FALSE, sizeof(GRASS_VERTEX), (void*)offsetof(GRASS_VERTEX, position));
+                glVertexAttribPointer(VJD_ATTRIBUTE_NORMAL,     3, GL_FLOAT, GL_FALSE, sizeof(GRASS_VERTEX), (void*)offsetof(GRASS_VERTEX, normal));
+                glVertexAttribPointer(VJD_ATTRIBUTE_TEXTCOORD,  2, GL_FLOAT, GL_FALSE, sizeof(GRASS_VERTEX), (void*)offsetof(GRASS_VERTEX, texcoord));
 
-            //element buffer is common for both cpu and gpu
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vbo_element_common);
-	glBindVertexArray(0);
+                glEnableVertexAttribArray(VJD_ATTRIBUTE_POSITION);
+                glEnableVertexAttribArray(VJD_ATTRIBUTE_NORMAL);
+                glEnableVertexAttribArray(VJD_ATTRIBUTE_TEXTCOORD);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
 
+                //element buffer is common for both cpu and gpu
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vbo_element_common);
+        glBindVertexArray(0);
+    }
 
 
-        //allocate memory device for kernel's 2nd parameter
-    size_t grassBufferSize = maxGrassVerticesCount * sizeof( VERTEX);
 
-    meshVertexData_opencl_input = clCreateBuffer( 
-                                        oclContext,           //opencl context
-                                        CL_MEM_READ_WRITE,    //flag
-                                        grassBufferSize,           //buffer size in bytes
-                                        NULL,                 //copy data from host to device
-                                        &clResult             //return error if any
-                                    );
-    if( CL_SUCCESS != clResult)
+        //buffer storage (and OpenCL graphics resource / kernel input) is sized by blade count, see ReserveGrassBuffers()
+    if( ReserveGrassBuffers( MIN_MESH_SIZE * MIN_MESH_SIZE) != 0)
     {
-        fprintf( gpLogFile, "clCreateBuffer() Failed\n");
         return(-1);
     }
 
@@ -1446,12 +1648,52 @@ int Initialize( void)
         return (-1);
     }
 
-    size_t imageBufferByteSize = windDistortion_map.width * windDistortion_map.height * COLOR_CHANNELS * sizeof(float);
-    distortionMap_opencl_input = clCreateBuffer(
+        //packed copy, 2 bytes per texel instead of 16, bilinearly sampled on CPU and GPU
+    size_t imageBufferByteSize = GrassGetPackedWindBytes( windDistortion_map.width, windDistortion_map.height);
+    windDistortion_packed = (unsigned char *) malloc( imageBufferByteSize);
+    if( windDistortion_packed == NULL)
+    {
+        fprintf( gpLogFile, "%s(%d): malloc() Failed\n", __FUNCTION__, __LINE__);
+        return(-1);
+    }
+
+    grassWindMap.width = windDistortion_map.width;
+    grassWindMap.height = windDistortion_map.height;
+    grassWindMap.texels = windDistortion_map.normalizeImageData;
+    grassWindMap.bilinear = true;
+    GrassPackWindMap( &grassWindMap, windDistortion_packed);
+
+        //uploaded once, as the image the kernel was built for or as the packed buffer
+    if( bOpenCLWindImage)
+    {
+        distortionMap_opencl_image = GrassCreateWindImage( oclContext, &grassWindMap, &clResult);
+        if( CL_SUCCESS != clResult)
+        {
+            fprintf( gpLogFile, "OpenCL Error( %d): GrassCreateWindImage() failed (%d)\n", __LINE__, clResult);
+            return(-1);
+        }
+    }
+    else
+    {
+        distortionMap_opencl_input = clCreateBuffer(
+                                        oclContext,
+                                        CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
+                                        imageBufferByteSize,
+                                        (void *)windDistortion_packed,
+                                        &clResult
+                                    );
+        if( CL_SUCCESS != clResult)
+        {
+            fprintf( gpLogFile, "OpenCL Error( %d): clCreateBuffer() failed\n", __LINE__);
+            return(-1);
+        }
+    }
+
+    grassTiles_opencl_input = clCreateBuffer(
                                     oclContext,
-                                    CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
-                                    imageBufferByteSize,
-                                    (void *)windDistortion_map.normalizeImageData,
+                                    CL_MEM_READ_ONLY,
+                                    MAX_GRASS_TILES * MAX_GRASS_TILES * sizeof( GRASS_LOD_TILE),
+                                    NULL,
                                     &clResult
                                 );
     if( CL_SUCCESS != clResult)
@@ -1537,83 +1779,6 @@ int Initialize( void)
 }
 
 
-//Simple noise function, http://answers.unity.com/answers/624136/view.html
-float random( vmath::vec3 coord)
-{
-    return( mymath::fract( sin( vmath::dot( coord, vmath::vec3( 12.9898, 78.233, 53.539)) ) * 43758.5453));
-}
-
-//
-//HeightCalculate
-//
-float HeightCalculate( float x, float z, float amplitude)
-{
-    //code
-    return( 0.0f);
-    //return( random( 0.1f* vmath::vec3( x/currentMeshWidth, 0.0f, z/currentMeshHeight)) * amplitude);
-}
-
-//
-//CreateMesh()
-//
-void CreateMesh(
-    int cx,
-    int cz,
-    int MeshWidth,
-    int MeshHeight,
-    float multiplicant,
-    float amplitude,
-    VERTEX *vertexData,
-    float (*heightFunc)(float, float, float)    //height function
-)
-{
-	//code
-    if( vertexData == NULL)
-        return;
-
-	int vertexCount = MeshWidth * MeshHeight;
-
-	int vertexPointer = 0;
-
-	int xStart = cx * (MeshWidth-1);
-	int zStart = cz * (MeshHeight-1);
-
-	float topLeftX = xStart - (MeshWidth -1) / 2;
-	float topLeftZ = zStart + (MeshHeight -1) / 2;
-
-    fprintf( gpLogFile, "[%f, %f], [%d, %d]\n", topLeftX, topLeftZ, MeshWidth, MeshHeight);
-
-    float increment = multiplicant;
-
-	for (int z = 0; z < MeshHeight; z++)
-	{
-		for (int x = 0; x < MeshWidth; x++)
-		{
-			float posX = (topLeftX + x) * multiplicant;
-			float posZ = (topLeftZ - z) * multiplicant;
-
-			vertexData[vertexPointer].position[0] = (float)posX;
-			vertexData[vertexPointer].position[1] = heightFunc( posX, posZ, amplitude);//0.0f;
-			vertexData[vertexPointer].position[2] = (float)posZ;
-
-            vertexData[vertexPointer].normal[0] = 0.0f;
-            vertexData[vertexPointer].normal[1] = 1.0f;
-            vertexData[vertexPointer].normal[2] = 0.0f;
-
-            vertexData[vertexPointer].texcoord[0] = (float)x / (float)MeshWidth;
-			vertexData[vertexPointer].texcoord[1] = (float)z / (float)MeshHeight;
-
-            vertexData[vertexPointer].tangent[0] = 1.0f;
-			vertexData[vertexPointer].tangent[1] = 0.0f;
-			vertexData[vertexPointer].tangent[2] = 0.0f;
-
-            //fprintf( gpLogFile, "[%f, %f, %f]\n", vertexData[vertexPointer].position[0], vertexData[vertexPointer].position[1], vertexData[vertexPointer].position[2]);
-
-            vertexPointer++;
-		}
-	}
-}
-
 //
 //Resize()
 //
@@ -1711,12 +1876,17 @@ void Display( void)
 {
     //function declaration
     void RenderWaterMark( void);
+    void DrawGrassBlades( const GRASS_DRAW_LIST *);
+    size_t GetGrassBufferBytes( int);
+    size_t GetGrassIndexBytes( void);
+    size_t GetGrassInputBytes( void);
+    double GetGrassCullSavedMs( void);
 
     //variable declarations
-    static unsigned int Time = GetTickCount();
+        //GetTickCount() steps in 10 - 16 ms
+    static double startTime = GrassProfileSeconds();
 
-    unsigned int timeNow = GetTickCount();
-    deltaTime = float( timeNow - Time) / 1000.0f;
+    deltaTime = float( GrassProfileSeconds() - startTime);
     //deltaTime += 0.01f;
 
     vmath::mat4 model_matrix = vmath::mat4::identity();
@@ -1727,8 +1897,11 @@ void Display( void)
     float fontSize;
 
     int polygonMode;
+    long long zoneStart;
 
     //code
+    GRASS_PROFILE_SCOPE( "Display");
+
     if( currentScene == INITIAL_SCENE)
     {
         glViewport( 0, 0, g_windowWidth, g_windowHeight);
@@ -1922,20 +2095,36 @@ void Display( void)
             glUniform1i( glGetUniformLocation( program_grass, "GrassBladeAlphaSample"), 1);
 
 
+            zoneStart = GrassProfileNow();
             if( bOnGPU)
             {
-                glBindVertexArray( vao_grass_opencl);
-                    glDrawElements( GL_TRIANGLES, grassIndicesCount, GL_UNSIGNED_INT, 0);
-                glBindVertexArray( 0);
+                    //output of an earlier kernel in the pipelined mode, its own draw list
+                OCL_INTEROP_BUFFER *source = &oclInterop[ oclDrawBuffer];
+                if( source->valid)
+                {
+                    glBindVertexArray( source->vao);
+                        DrawGrassBlades( &source->draws);
+                    glBindVertexArray( 0);
+
+                        //OpenCL waits on it before writing this buffer again
+                    if( source->drawn)
+                    {
+                        glDeleteSync( source->drawn);
+                    }
+                    source->drawn = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+                    GrassProfileStatAdd( &oclLatencyMs[ oclPipelineDepth - 1], ( GrassProfileNow() - source->enqueueNs) * 1.0e-6f);
+                }
             }
             else
             {
                 glBindVertexArray( vao_grass_cpu);
                     glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, vbo_element_common);
-                    glDrawElements( GL_TRIANGLES, grassIndicesCount, GL_UNSIGNED_INT, 0);
+                    DrawGrassBlades( &grassDraws);
                     // glDrawArrays( GL_LINES, 0, grassVerticesCount);
                 glBindVertexArray( 0);
             }
+            GrassProfileRecord( "grass draw", zoneStart, GrassProfileNow());
 
             glActiveTexture( GL_TEXTURE0);
             glBindTexture( GL_TEXTURE_2D, 0);
@@ -1946,6 +2135,8 @@ void Display( void)
 
         if( gbEnableMSAA)
         {
+            GRASS_PROFILE_SCOPE( "MSAA blit");
+
             glBindFramebuffer( GL_FRAMEBUFFER, 0);
 
                 //copy (filter) data from MSAA frambuffer to default framebuffer
@@ -1972,6 +2163,7 @@ void Display( void)
         glPolygonMode( GL_FRONT_AND_BACK, GL_FILL);
 
         //HDR display
+        zoneStart = GrassProfileNow();
         glUseProgram( program_hdr_display);
             glUniform1f( glGetUniformLocation( program_hdr_display, "exposure"), 0.5f);
 
@@ -1985,6 +2177,7 @@ void Display( void)
 
             glBindTexture( GL_TEXTURE_2D, 0);
         glUseProgram( 0);
+        GrassProfileRecord( "HDR pass", zoneStart, GrassProfileNow());
 
 
         glPolygonMode( GL_FRONT_AND_BACK, polygonMode);
@@ -1993,6 +2186,7 @@ void Display( void)
 
         //--------------------------------------------------------------------------------------------------------------------------------------------------------------//
 
+        zoneStart = GrassProfileNow();
         glDisable( GL_DEPTH_TEST);
             fontSize = FontGetSize( NotoSerifBoldFreeTypeFont);
 
@@ -2005,7 +2199,7 @@ void Display( void)
 
             if( bOnGPU)
             {
-                sprintf( stringMessage, "(GPU) %s (OpenCL)", glGetString( GL_RENDERER));
+                sprintf( stringMessage, "(%s) %s (OpenCL%s)", GrassDeviceTypeName( oclDevice.type), oclDevice.name, bOpenCLHostBuffers ? ", host buffers" : "");
             }
             else
             {
@@ -2048,6 +2242,95 @@ void Display( void)
             FontCursorPrintSingleLineText2D_FreeType( NotoSerifBoldFreeTypeFont, stringMessage, g_windowWidth, g_windowHeight);
 
 
+            if( !bOnGPU)
+            {
+                FontSetCursor_FreeType( NotoSerifBoldFreeTypeFont, 50.0f, g_windowHeight - 15.2 * fontSize * 0.8f);
+                sprintf( stringMessage, "CPU Threads:  %d ( %.2f ms, imbalance %.2f)",
+                    grassField.getThreadCount(), grassField.getSimulateMs(), grassField.getLoadImbalance());
+                FontCursorPrintSingleLineText2D_FreeType( NotoSerifBoldFreeTypeFont, stringMessage, g_windowWidth, g_windowHeight);
+            }
+
+            FontSetCursor_FreeType( NotoSerifBoldFreeTypeFont, 50.0f, g_windowHeight - 14.0 * fontSize * 0.8f);
+            sprintf( stringMessage, "Grass Memory:  %.1f MB used / %.1f MB reserved",
+                (GetGrassBufferBytes( grassVerticesCount) + grassField.getUsedBytes() + GetGrassIndexBytes() + GetGrassInputBytes()) / (1024.0 * 1024.0),
+                (GetGrassBufferBytes( grassBladeCapacity) + grassField.getReservedBytes() + GetGrassIndexBytes() + GetGrassInputBytes()) / (1024.0 * 1024.0));
+            FontCursorPrintSingleLineText2D_FreeType( NotoSerifBoldFreeTypeFont, stringMessage, g_windowWidth, g_windowHeight);
+
+            FontSetCursor_FreeType( NotoSerifBoldFreeTypeFont, 50.0f, g_windowHeight - 16.4 * fontSize * 0.8f);
+            sprintf( stringMessage, "Indices (E):  %s, %.2f MB, resize %.1f ms ( index %.1f ms)",
+                ( grassIndexMode == GRASS_INDEX_TEMPLATE) ? "template" : "full",
+                GetGrassIndexBytes() / (1024.0 * 1024.0), grassResizeMs, grassIndexMs);
+            FontCursorPrintSingleLineText2D_FreeType( NotoSerifBoldFreeTypeFont, stringMessage, g_windowWidth, g_windowHeight);
+
+            FontSetCursor_FreeType( NotoSerifBoldFreeTypeFont, 50.0f, g_windowHeight - 17.6 * fontSize * 0.8f);
+            sprintf( stringMessage, "Roots (V):  %s, input %.2f MB",
+                gbProceduralGrid ? "procedural grid" : "mesh", GetGrassInputBytes() / (1024.0 * 1024.0));
+            FontCursorPrintSingleLineText2D_FreeType( NotoSerifBoldFreeTypeFont, stringMessage, g_windowWidth, g_windowHeight);
+
+            FontSetCursor_FreeType( NotoSerifBoldFreeTypeFont, 50.0f, g_windowHeight - 18.8 * fontSize * 0.8f);
+            sprintf( stringMessage, "Culling (U):  %s, visible %d / %d blades ( %.1f%%), cull %.2f ms, saved ~%.1f ms",
+                gbCullGrass ? "on" : "off", grassVisibleBlades, grassField.getBladeCount(),
+                100.0 * grassVisibleBlades / MAX( grassField.getBladeCount(), 1), grassCullMs, GetGrassCullSavedMs());
+            FontCursorPrintSingleLineText2D_FreeType( NotoSerifBoldFreeTypeFont, stringMessage, g_windowWidth, g_windowHeight);
+
+            FontSetCursor_FreeType( NotoSerifBoldFreeTypeFont, 50.0f, g_windowHeight - 20.0 * fontSize * 0.8f);
+            sprintf( stringMessage, "LOD (O):  %s, output %d / %d vertices ( %.1f%%)",
+                ( gbGrassLod && ( grassIndexMode == GRASS_INDEX_TEMPLATE)) ? "on" : "off",
+                grassField.getOutputVertexCount(), grassVisibleBlades * GRASS_BLADE_SEGMENTS * 2,
+                100.0 * grassField.getOutputVertexCount() / MAX( grassVisibleBlades * GRASS_BLADE_SEGMENTS * 2, 1));
+            FontCursorPrintSingleLineText2D_FreeType( NotoSerifBoldFreeTypeFont, stringMessage, g_windowWidth, g_windowHeight);
+
+            FontSetCursor_FreeType( NotoSerifBoldFreeTypeFont, 50.0f, g_windowHeight - 21.2 * fontSize * 0.8f);
+            sprintf( stringMessage, "Time Slicing (J, K):  %s, budget %d, regenerated %d / %d blades ( %.2fx, mean %.2fx)",
+                grassField.schedule.enabled ? "on" : "off", grassField.schedule.bladeBudget, grassField.getUpdateBladeCount(), grassVisibleBlades,
+                grassField.getAmortization(), grassField.getMeanAmortization());
+            FontCursorPrintSingleLineText2D_FreeType( NotoSerifBoldFreeTypeFont, stringMessage, g_windowWidth, g_windowHeight);
+
+            FontSetCursor_FreeType( NotoSerifBoldFreeTypeFont, 50.0f, g_windowHeight - 22.4 * fontSize * 0.8f);
+            sprintf( stringMessage, "Wind (F2):  %s",
+                gbProceduralWind ? "procedural, no texture" : "distortion map, RG8 bilinear");
+            FontCursorPrintSingleLineText2D_FreeType( NotoSerifBoldFreeTypeFont, stringMessage, g_windowWidth, g_windowHeight);
+
+                //device time of each enqueued command, rolling over the last GRASS_PROFILE_STAT_WINDOW frames
+            float line = 23.6f;
+            if( bOnGPU)
+            {
+                float avgFrame, avgLatency, avgWait, unused;
+
+                if( ( GrassProfileStatSummary( &oclFrameMs[ oclPipelineDepth - 1], &unused, &avgFrame, &unused) > 0) &&
+                    ( GrassProfileStatSummary( &oclLatencyMs[ oclPipelineDepth - 1], &unused, &avgLatency, &unused) > 0) &&
+                    ( GrassProfileStatSummary( &oclHostWaitMs[ oclPipelineDepth - 1], &unused, &avgWait, &unused) > 0))
+                {
+                    FontSetCursor_FreeType( NotoSerifBoldFreeTypeFont, 50.0f, g_windowHeight - line * fontSize * 0.8f);
+                    sprintf( stringMessage, "OpenCL Pipeline (F5):  %s, depth %d, frame %.2f ms, latency %.2f ms, host wait %.2f ms",
+                        ( oclPipelineDepth == 1) ? "synchronous" : "pipelined", oclPipelineDepth, avgFrame, avgLatency, avgWait);
+                    FontCursorPrintSingleLineText2D_FreeType( NotoSerifBoldFreeTypeFont, stringMessage, g_windowWidth, g_windowHeight);
+
+                    line += 1.2f;
+                }
+            }
+
+            if( bOnGPU && gbOpenCLProfiling && bOpenCLQueueProfiling)
+            {
+                float minMs, avgMs, p99Ms, minWait, avgWait, p99Wait;
+
+                for( int i = 0; i < OCL_COMMAND_TYPES; i++)
+                {
+                    if( GrassProfileStatSummary( &oclCommandTime[i], &minMs, &avgMs, &p99Ms) == 0)
+                    {
+                        continue;
+                    }
+                    GrassProfileStatSummary( &oclCommandWait[i], &minWait, &avgWait, &p99Wait);
+
+                    FontSetCursor_FreeType( NotoSerifBoldFreeTypeFont, 50.0f, g_windowHeight - line * fontSize * 0.8f);
+                    sprintf( stringMessage, "OpenCL %s (F4):  %.3f / %.3f / %.3f ms ( min / avg / p99), wait %.3f ms",
+                        oclCommandNames[i], minMs, avgMs, p99Ms, avgWait);
+                    FontCursorPrintSingleLineText2D_FreeType( NotoSerifBoldFreeTypeFont, stringMessage, g_windowWidth, g_windowHeight);
+
+                    line += 1.2f;
+                }
+            }
+
             glGetIntegerv( GL_POLYGON_MODE, &polygonMode);
             switch( polygonMode)
             {
@@ -2083,6 +2366,7 @@ void Display( void)
             FontCursorPrintSingleLineText2D_FreeType( NotoSerifBoldFreeTypeFont, stringMessage, g_windowWidth, g_windowHeight);
 
         glEnable( GL_DEPTH_TEST);
+        GrassProfileRecord( "HUD text", zoneStart, GrassProfileNow());
 
 
 
@@ -2311,7 +2595,9 @@ void Display( void)
 
     RenderWaterMark();
 
+    zoneStart = GrassProfileNow();
     SwapBuffers( ghdc);
+    GrassProfileRecord( "swap buffers", zoneStart, GrassProfileNow());
 }
 
 
@@ -2355,46 +2641,6 @@ void RenderWaterMark( void)
 }
 
 
-//
-//RotationMatrix()
-//
-vmath::mat4 RotationMatrix( float angleInRadians, float x, float y, float z)
-{
-    //code
-    float s = sinf( angleInRadians);
-    float c = cosf( angleInRadians);
-    float t = 1.0 - c;
-
-    return( vmath::mat4(
-                vmath::vec4( x*x*t + c  , y*x*t + z*s, x*z*t - y*s, 0.0f),
-                vmath::vec4( x*y*t - z*s, y*y*t + c  , y*z*t + x*s, 0.0f),
-                vmath::vec4( x*z*t + y*s, y*z*t - x*s, z*z*t + c  , 0.0f),
-                vmath::vec4( 0.0f, 0.0f, 0.0f, 1.0f)
-            )
-    );
-}
-
-
-//
-//getTexel() :- Return color from specified texcoord location
-//
-vmath::vec4 getTexel( vmath::vec2 uv, IMAGE_DATA *texture)
-{
-    //code
-    int x = floor( mymath::fract(uv[0]) * ( texture->width ));
-    int y = floor( mymath::fract(uv[1]) * ( texture->height));
-
-    vmath::vec4 sample = vmath::vec4( 0.0f);
-
-    sample[0] = texture->normalizeImageData[ COLOR_CHANNELS * ( y * windDistortion_map.width + x) + 0]; //red
-    sample[1] = texture->normalizeImageData[ COLOR_CHANNELS * ( y * windDistortion_map.width + x) + 1]; //green
-    sample[2] = texture->normalizeImageData[ COLOR_CHANNELS * ( y * windDistortion_map.width + x) + 2]; //blue
-    sample[3] = texture->normalizeImageData[ COLOR_CHANNELS * ( y * windDistortion_map.width + x) + 3]; //alpha
-
-    return( sample);
-}
-
-
 //
 //Update()
 //
@@ -2405,6 +2651,8 @@ void Update( void)
     void UpdateGrassData( void);
 
     //code
+    GRASS_PROFILE_SCOPE( "Update");
+
 #if USE_ARC_CAMERA
     g_arcCamera.updateAngleAroundPoint( 0.1f);
 #endif
@@ -2466,241 +2714,1015 @@ void UpdateKeyboardState( void)
 }
 
 //
-//UpdateGrassData()
+//GetGrassBufferBytes() :- bytes of grass VBOs for 'bladeCount' blades
 //
-void UpdateGrassData( void)
+size_t GetGrassBufferBytes( int bladeCount)
 {
-    //variable declarations
-    static const float grassBladeHeight = 0.83f;
-    static const float grassBladeHeightRandom = 0.26f;
-    static const float grassBladeWidth = 0.03f;
-    static const float grassBladeWidthRandom = 0.01f;
-    static const float grassBendRotationRandom = 0.4f;
-    static const float grassBladeForwardAmount = 0.515f;
-    static const float grassBladeCurvatureAmount = 1.18f;
+    //code
+    size_t bytesPerBlade = ( 1 + OCL_INTEROP_BUFFERS) * (2 * GRASS_BLADE_SEGMENTS * sizeof( GRASS_VERTEX));     //CPU and OpenCL VBOs
 
-    static const vmath::vec2 windFrequency = { 0.05f, 0.05f};
-    static const vmath::vec2 windScale = { 0.009f, 0.009f};
-    static const vmath::vec2 windOffset = { 0.0f, 0.0f};
-    static const float windStrength = 0.345f;
+    return( bytesPerBlade * bladeCount);
+}
 
-    int verticesPerBlade = 2 * GRASS_BLADE_SEGMENTS;
+//
+//GetGrassInputBytes() :- bytes of mesh vertex input, host array and OpenCL copy
+//
+size_t GetGrassInputBytes( void)
+{
+    //code
+    return( 2 * (size_t)grassInputCapacity * sizeof( VERTEX));
+}
+
+//
+//ReserveGrassInput() :- mesh vertex input for 'bladeCount' blades, released in procedural mode
+//
+int ReserveGrassInput( int bladeCount)
+{
+    //code
+    int newCapacity = gbProceduralGrid ? 0 : GrassReserveCapacity( grassInputCapacity, bladeCount);
+    if( newCapacity == grassInputCapacity)
+    {
+        return(0);
+    }
+
+    if( meshVertexData_opencl_input)
+    {
+        clReleaseMemObject( meshVertexData_opencl_input);
+        meshVertexData_opencl_input = NULL;
+    }
+
+    if( meshVertexData)
+    {
+        free( meshVertexData);
+        meshVertexData = NULL;
+    }
+
+    grassInputCapacity = 0;
+
+    if( newCapacity == 0)
+    {
+        return(0);
+    }
+
+    meshVertexData = (VERTEX *) malloc( (size_t)newCapacity * sizeof( VERTEX));
+    if( meshVertexData == NULL)
+    {
+        fprintf( gpLogFile, "malloc() Failed for mesh vertex data\n");
+        return(-1);
+    }
+
+    //allocate memory device for kernel's 2nd parameter
+    meshVertexData_opencl_input = clCreateBuffer(
+                                        oclContext,                             //opencl context
+                                        CL_MEM_READ_WRITE,                      //flag
+                                        (size_t)newCapacity * sizeof( VERTEX),  //buffer size in bytes
+                                        NULL,                                   //copy data from host to device
+                                        &clResult                               //return error if any
+                                    );
+    if( CL_SUCCESS != clResult)
+    {
+        fprintf( gpLogFile, "clCreateBuffer() Failed\n");
+        return(-1);
+    }
+
+    grassInputCapacity = newCapacity;
+
+    return(0);
+}
+
+//
+//GetGrassIndexBytes() :- bytes of vbo_element_common
+//
+size_t GetGrassIndexBytes( void)
+{
+    //code
+    if( (grassIndexBufferMode == GRASS_INDEX_TEMPLATE) && (grassIndexCapacity > 0))
+    {
+        return( (size_t)grassField.getIndexTemplateCount( grassIndexCapacity) * sizeof( GLuint));     //one template per LOD level
+    }
+
+    return( (size_t)grassIndexCapacity * 6 * (GRASS_BLADE_SEGMENTS - 1) * sizeof( GLuint));
+}
+
+//
+//ReserveGrassIndices() :- fill vbo_element_common for 'bladeCount' blades in grassIndexMode
+//
+int ReserveGrassIndices( int bladeCount)
+{
+    //code
+    if( grassIndexMode != grassIndexBufferMode)
+    {
+        grassIndexCapacity = 0;
+        grassIndexBufferMode = grassIndexMode;
+    }
+
+    glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, vbo_element_common);
+
+    if( grassIndexMode == GRASS_INDEX_TEMPLATE)
+    {
+            //template is constant, only built when switching to this mode
+        if( grassIndexCapacity != GRASS_TEMPLATE_BLADES)
+        {
+            grassIndexCapacity = GRASS_TEMPLATE_BLADES;
+
+            glBufferData( GL_ELEMENT_ARRAY_BUFFER, GetGrassIndexBytes(), NULL, GL_STATIC_DRAW);
+            GLuint *indexBufferPtr = (GLuint *) glMapBuffer( GL_ELEMENT_ARRAY_BUFFER, GL_WRITE_ONLY);
+            if( indexBufferPtr == NULL)
+            {
+                fprintf( gpLogFile, "glMapBuffer() Failed for grass index template\n");
+                return(-1);
+            }
+
+                grassField.fillIndexTemplate( indexBufferPtr, GRASS_TEMPLATE_BLADES);
+
+            glUnmapBuffer( GL_ELEMENT_ARRAY_BUFFER);
+            indexBufferPtr = NULL;
+        }
+
+        grassIndicesCount = grassField.getIndexCount();
+    }
+    else
+    {
+        int newCapacity = GrassReserveCapacity( grassIndexCapacity, bladeCount);
+        if( newCapacity != grassIndexCapacity)
+        {
+            grassIndexCapacity = newCapacity;
+            glBufferData( GL_ELEMENT_ARRAY_BUFFER, GetGrassIndexBytes(), NULL, GL_STATIC_DRAW);
+        }
+
+        GLuint *indexBufferPtr = (GLuint *) glMapBuffer( GL_ELEMENT_ARRAY_BUFFER, GL_WRITE_ONLY);
+        if( indexBufferPtr == NULL)
+        {
+            fprintf( gpLogFile, "glMapBuffer() Failed for grass indices\n");
+            return(-1);
+        }
+
+            grassIndicesCount = grassField.fillIndices( indexBufferPtr, grassField.getIndexCount());
+
+        glUnmapBuffer( GL_ELEMENT_ARRAY_BUFFER);
+        indexBufferPtr = NULL;
+    }
+
+    glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    return(0);
+}
+
+//
+//UpdateGrassDraws() :- draw list of the blades left visible by the last GrassField::cull()
+//
+void UpdateGrassDraws( void)
+{
+    //variable declarations
+    static int grassDrawFirstIndex[ MAX_GRASS_DRAWS];
+
+    //code
+    if( grassIndexMode == GRASS_INDEX_TEMPLATE)
+    {
+        grassDraws.count = grassField.fillTemplateDraws( GRASS_TEMPLATE_BLADES, grassDraws.counts, grassDrawFirstIndex, grassDraws.baseVertex, MAX_GRASS_DRAWS);
+
+        for( int i = 0; i < grassDraws.count; i++)
+        {
+            grassDraws.offsets[i] = (const void *)( (size_t)grassDrawFirstIndex[i] * sizeof( GLuint));
+        }
+    }
+    else
+    {
+            //visible blades are packed at level 0, one draw over the first indices
+        grassDraws.count = ( grassField.getOutputIndexCount() > 0) ? 1 : 0;
+        grassDraws.counts[0] = grassField.getOutputIndexCount();
+        grassDraws.offsets[0] = NULL;
+        grassDraws.baseVertex[0] = 0;
+    }
+}
+
+//
+//DrawGrassBlades() :- vertex array with vbo_element_common must be bound
+//
+void DrawGrassBlades( const GRASS_DRAW_LIST *draws)
+{
+    //code
+    glMultiDrawElementsBaseVertex( GL_TRIANGLES, draws->counts, GL_UNSIGNED_INT, draws->offsets, draws->count, draws->baseVertex);
+}
+
+//
+//CopyGrassDraws()
+//
+void CopyGrassDraws( GRASS_DRAW_LIST *destination, const GRASS_DRAW_LIST *source)
+{
+    //code
+    memcpy( destination->counts, source->counts, source->count * sizeof( GLsizei));
+    memcpy( destination->baseVertex, source->baseVertex, source->count * sizeof( GLint));
+    memcpy( destination->offsets, source->offsets, source->count * sizeof( const void *));
+    destination->count = source->count;
+}
+
+//
+//ReserveGrassBuffers() :- size grass VBOs for 'bladeCount' blades (indices : ReserveGrassIndices(), input : ReserveGrassInput())
+//
+int ReserveGrassBuffers( int bladeCount)
+{
+    //function declaration
+    void ResetOpenCLPipeline( void);
+
+    //code
+    int newCapacity = GrassReserveCapacity( grassBladeCapacity, bladeCount);
+    if( newCapacity == grassBladeCapacity)
+    {
+        return(0);
+    }
+
+    size_t vertexBufferSize = (size_t)newCapacity * 2 * GRASS_BLADE_SEGMENTS * sizeof( GRASS_VERTEX);
+
+        //OpenCL has to drop its view of the GL buffers before the GL storage is reallocated
+    ResetOpenCLPipeline();
+
+    for( int i = 0; i < OCL_INTEROP_BUFFERS; i++)
+    {
+        if( oclInterop[i].resource)
+        {
+            clReleaseMemObject( oclInterop[i].resource);
+            oclInterop[i].resource = NULL;
+        }
+    }
+
+    glBindBuffer( GL_ARRAY_BUFFER, vbo_grassBuffer_cpu);
+        glBufferData( GL_ARRAY_BUFFER, vertexBufferSize, NULL, GL_STATIC_DRAW);
+    for( int i = 0; i < OCL_INTEROP_BUFFERS; i++)
+    {
+        glBindBuffer( GL_ARRAY_BUFFER, oclInterop[i].vbo);
+            glBufferData( GL_ARRAY_BUFFER, vertexBufferSize, NULL, GL_STATIC_DRAW);
+    }
+    glBindBuffer( GL_ARRAY_BUFFER, 0);
+
+    glFinish();
+
+    //Create OpenCL graphics resources for the OpenGL buffers, host buffers wrap the mapped buffer every frame
+    for( int i = 0; ( i < OCL_INTEROP_BUFFERS) && !bOpenCLHostBuffers; i++)
+    {
+        oclInterop[i].resource = clCreateFromGLBuffer( oclContext, CL_MEM_WRITE_ONLY, oclInterop[i].vbo, &clResult);
+        if( CL_SUCCESS != clResult)
+        {
+            fprintf( gpLogFile, "clCreateFromGLBuffer() Failed\n");
+            return(-1);
+        }
+    }
+
+    grassBladeCapacity = newCapacity;
+    grassField.invalidateSchedule();    //new buffers, nothing to keep
+
+    fprintf( gpLogFile, "Grass buffers reserved for %d blades (%.2f MB)\n", grassBladeCapacity, GetGrassBufferBytes( grassBladeCapacity) / (1024.0 * 1024.0));
+
+    return(0);
+}
+
+//
+//OpenCLCommandEvent() :- event argument of the next enqueue, NULL when the command is not timed
+//
+cl_event *OpenCLCommandEvent( int command)
+{
+    //code
+    if( !gbOpenCLProfiling || !bOpenCLQueueProfiling || ( oclPendingEventCount == OCL_MAX_PENDING_EVENTS))
+    {
+        return( NULL);
+    }
+
+    OCL_COMMAND_EVENT *pending = &oclPendingEvents[ oclPendingEventCount++];
+    pending->command = command;
+    pending->event = NULL;
+    pending->hostNs = GrassProfileNow();
+
+    return( &pending->event);
+}
+
+//
+//CollectOpenCLCommandEvents() :- queued / submit / start / end of every completed timed command
+//                                into the rolling stats and the trace, the rest stays pending
+//
+void CollectOpenCLCommandEvents( void)
+{
+    //variable declarations
+    cl_ulong queued, submit, start, end;
+    cl_int status;
+    int stillPending = 0;
+
+    //code
+    for( int i = 0; i < oclPendingEventCount; i++)
+    {
+        OCL_COMMAND_EVENT *pending = &oclPendingEvents[i];
+
+            //enqueue failed, no event
+        if( pending->event == NULL)
+        {
+            continue;
+        }
+
+            //pipelined mode does not wait for the last frame
+        if( ( clGetEventInfo( pending->event, CL_EVENT_COMMAND_EXECUTION_STATUS, sizeof( cl_int), &status, NULL) == CL_SUCCESS) && ( status > CL_COMPLETE))
+        {
+            oclPendingEvents[ stillPending++] = *pending;
+            continue;
+        }
+
+        if( ( clGetEventProfilingInfo( pending->event, CL_PROFILING_COMMAND_QUEUED, sizeof( cl_ulong), &queued, NULL) == CL_SUCCESS) &&
+            ( clGetEventProfilingInfo( pending->event, CL_PROFILING_COMMAND_SUBMIT, sizeof( cl_ulong), &submit, NULL) == CL_SUCCESS) &&
+            ( clGetEventProfilingInfo( pending->event, CL_PROFILING_COMMAND_START, sizeof( cl_ulong), &start, NULL) == CL_SUCCESS) &&
+            ( clGetEventProfilingInfo( pending->event, CL_PROFILING_COMMAND_END, sizeof( cl_ulong), &end, NULL) == CL_SUCCESS))
+        {
+            GrassProfileStatAdd( &oclCommandWait[ pending->command], ( start - queued) * 1.0e-6f);
+            GrassProfileStatAdd( &oclCommandTime[ pending->command], ( end - start) * 1.0e-6f);
+
+                //device timestamps have their own origin, CL_PROFILING_COMMAND_QUEUED is the enqueue on the host
+            long long deviceToHost = pending->hostNs - (long long)queued;
+            GrassProfileRecordTrack( oclCommandNames[ pending->command], (long long)start + deviceToHost, (long long)end + deviceToHost, GRASS_PROFILE_TRACK_OPENCL);
+        }
+
+        clReleaseEvent( pending->event);
+    }
+
+    oclPendingEventCount = stillPending;
+}
+
+//
+//LogOpenCLCommandStats()
+//
+void LogOpenCLCommandStats( void)
+{
+    //variable declarations
+    float minMs, avgMs, p99Ms;
+    float minWait, avgWait, p99Wait;
+
+    //code
+    for( int i = 0; i < OCL_COMMAND_TYPES; i++)
+    {
+        int samples = GrassProfileStatSummary( &oclCommandTime[i], &minMs, &avgMs, &p99Ms);
+        if( samples == 0)
+        {
+            continue;
+        }
+        GrassProfileStatSummary( &oclCommandWait[i], &minWait, &avgWait, &p99Wait);
+
+        fprintf( gpLogFile, "OpenCL %-12s ( last %3d): run %.3f / %.3f / %.3f ms, wait %.3f / %.3f / %.3f ms ( min / avg / p99)\n",
+            oclCommandNames[i], samples, minMs, avgMs, p99Ms, minWait, avgWait, p99Wait);
+    }
+}
+
+//
+//LogOpenCLPipelineStats() :- synchronous against pipelined OpenCL, every depth run so far
+//
+void LogOpenCLPipelineStats( void)
+{
+    //variable declarations
+    float minMs, avgMs, p99Ms;
+    float minLatency, avgLatency, p99Latency;
+    float minWait, avgWait, p99Wait;
+
+    //code
+    for( int i = 0; i < OCL_INTEROP_BUFFERS; i++)
+    {
+        int samples = GrassProfileStatSummary( &oclFrameMs[i], &minMs, &avgMs, &p99Ms);
+        if( ( samples == 0) || ( GrassProfileStatSummary( &oclLatencyMs[i], &minLatency, &avgLatency, &p99Latency) == 0))
+        {
+            continue;
+        }
+        GrassProfileStatSummary( &oclHostWaitMs[i], &minWait, &avgWait, &p99Wait);
+
+        fprintf( gpLogFile, "OpenCL %s ( depth %d, last %3d): frame %.3f / %.3f ms ( %.1f fps), latency %.3f / %.3f ms, host wait %.3f / %.3f ms ( avg / p99)\n",
+            ( i == 0) ? "synchronous" : "pipelined  ", i + 1, samples, avgMs, p99Ms, 1000.0f / avgMs, avgLatency, p99Latency, avgWait, p99Wait);
+    }
+}
+
+//
+//SetGrassKernelArg() :- one argument of grass_kernel and grass_segment_kernel, the work group profile picks the kernel
+//
+cl_int SetGrassKernelArg( cl_uint index, size_t size, const void *value)
+{
+    //code
+    cl_int result = clSetKernelArg( oclGrassKernel, index, size, value);
+    if( (CL_SUCCESS == result) && oclGrassSegmentKernel)
+    {
+        result = clSetKernelArg( oclGrassSegmentKernel, index, size, value);
+    }
+
+    return( result);
+}
+
+//
+//SetGrassKernelArgs() :- grass_kernel arguments that only change with the grid, roots or wind source
+//
+int SetGrassKernelArgs( void)
+{
+    //variable declarations
+    unsigned int mesh_width = currentMeshWidth;
+    unsigned int mesh_height = currentMeshHeight;
+
+    //code
+        //no mesh input in procedural mode, the kernel builds roots from gridParams
+    clResult = SetGrassKernelArg( 1, sizeof( cl_mem), gbProceduralGrid ? NULL : (void *)&meshVertexData_opencl_input);
+    if( CL_SUCCESS != clResult)
+    {
+        fprintf( gpLogFile, "clSetKernelArg() for 1 failed\n");
+        return(-1);
+    }
+
+    clResult = SetGrassKernelArg( 2, sizeof( cl_uint), (void *)&mesh_width);
+    if( CL_SUCCESS != clResult)
+    {
+        fprintf( gpLogFile, "clSetKernelArg() for 2 failed\n");
+        return(-1);
+    }
+
+    clResult = SetGrassKernelArg( 3, sizeof( cl_uint), (void *)&mesh_height);
+    if( CL_SUCCESS != clResult)
+    {
+        fprintf( gpLogFile, "clSetKernelArg() for 3 failed\n");
+        return(-1);
+    }
+
+    clResult = SetGrassKernelArg( 4, sizeof( cl_mem), (void *)&grassTiles_opencl_input);
+    if( CL_SUCCESS != clResult)
+    {
+        fprintf( gpLogFile, "clSetKernelArg() for 4 failed\n");
+        return(-1);
+    }
+
+    clResult = SetGrassKernelArg( 5, sizeof( cl_mem), (void *)&distortionMap_opencl_input);
+    if( CL_SUCCESS != clResult)
+    {
+        fprintf( gpLogFile, "clSetKernelArg() for 5 failed\n");
+        return(-1);
+    }
+
+    clResult = SetGrassKernelArg( 6, sizeof( cl_int), (void *)&windDistortion_map.width);
+    if( CL_SUCCESS != clResult)
+    {
+        fprintf( gpLogFile, "clSetKernelArg() for 6 failed\n");
+        return(-1);
+    }
+
+    clResult = SetGrassKernelArg( 7, sizeof( cl_int), (void *)&windDistortion_map.height);
+    if( CL_SUCCESS != clResult)
+    {
+        fprintf( gpLogFile, "clSetKernelArg() for 7 failed\n");
+        return(-1);
+    }
+
+    cl_uint rootSource = gbProceduralGrid ? 1 : 0;      //GRASS_ROOTS_GRID / GRASS_ROOTS_MESH in Grass.cl
+    clResult = SetGrassKernelArg( 9, sizeof( cl_uint), (void *)&rootSource);
+    if( CL_SUCCESS != clResult)
+    {
+        fprintf( gpLogFile, "clSetKernelArg() for 9 failed\n");
+        return(-1);
+    }
+
+    cl_float4 gridParams;
+    gridParams.s[0] = grassGrid.left;
+    gridParams.s[1] = grassGrid.top;
+    gridParams.s[2] = grassGrid.spacing;
+    gridParams.s[3] = 0.0f;
+    clResult = SetGrassKernelArg( 10, sizeof( cl_float4), (void *)&gridParams);
+    if( CL_SUCCESS != clResult)
+    {
+        fprintf( gpLogFile, "clSetKernelArg() for 10 failed\n");
+        return(-1);
+    }
+
+        //flat field, no height buffer
+    clResult = SetGrassKernelArg( 11, sizeof( cl_mem), NULL);
+    if( CL_SUCCESS != clResult)
+    {
+        fprintf( gpLogFile, "clSetKernelArg() for 11 failed\n");
+        return(-1);
+    }
+
+    cl_uint windSource = gbProceduralWind ? 1 : 0;     //GRASS_WIND_PROCEDURAL : GRASS_WIND_TEXTURE
+    clResult = SetGrassKernelArg( 12, sizeof( cl_uint), (void *)&windSource);
+    if( CL_SUCCESS != clResult)
+    {
+        fprintf( gpLogFile, "clSetKernelArg() for 12 failed\n");
+        return(-1);
+    }
+
+    clResult = SetGrassKernelArg( 13, sizeof( GRASS_PROCEDURAL_WIND), (void *)&grassWindMap.model);
+    if( CL_SUCCESS != clResult)
+    {
+        fprintf( gpLogFile, "clSetKernelArg() for 13 failed\n");
+        return(-1);
+    }
+
+        //argument 5 is then NULL, the kernel samples the image
+    if( bOpenCLWindImage)
+    {
+        clResult = SetGrassKernelArg( GRASS_KERNEL_ARG_WIND_IMAGE, sizeof( cl_mem), (void *)&distortionMap_opencl_image);
+        if( CL_SUCCESS != clResult)
+        {
+            fprintf( gpLogFile, "clSetKernelArg() for %d failed\n", GRASS_KERNEL_ARG_WIND_IMAGE);
+            return(-1);
+        }
+    }
+
+    bGrassKernelArgsDirty = false;
+
+    return(0);
+}
+
+//
+//SelectGrassWorkGroup() :- kernel and local size for 'gridClass' from the profile, else tuned on
+//                          the 'tileCount' tiles about to be generated and stored for the next start
+//
+void SelectGrassWorkGroup( int gridClass, size_t tileCount)
+{
+    //variable declarations
+    GRASS_WORK_GROUP_TUNING tuning;
+
+    //code
+    oclWorkGroupClass = gridClass;
+    memset( &oclWorkGroup, 0, sizeof( GRASS_WORK_GROUP));
+
+    if( GrassLoadWorkGroup( grassWorkGroupProfile, oclComputeDeviceId, grassKernelBuildOptions, gridClass, &oclWorkGroup) == 0)
+    {
+        fprintf( gpLogFile, "%s work group %d x %d from %s ( grid class %d)\n",
+            ( oclWorkGroup.kernel == GRASS_KERNEL_SEGMENT) ? grassSegmentKernelName : grassKernelName,
+            (int)oclWorkGroup.local[0], (int)oclWorkGroup.local[1], grassWorkGroupProfile, gridClass);
+        return;
+    }
+
+    long long tuneStart = GrassProfileNow();
+
+    clResult = GrassTuneWorkGroup( oclCommandQueue, oclGrassKernel, oclGrassSegmentKernel, oclComputeDeviceId, tileCount, grassField.params.segments, 10, &tuning);
+    if( CL_SUCCESS != clResult)
+    {
+        fprintf( gpLogFile, "GrassTuneWorkGroup() failed (%d), driver choice\n", clResult);
+        return;
+    }
+
+    GrassProfileRecord( "opencl work group tuning", tuneStart, GrassProfileNow());
+
+    oclWorkGroup = tuning.candidate[ tuning.best];
+    GrassStoreWorkGroup( grassWorkGroupProfile, oclComputeDeviceId, grassKernelBuildOptions, gridClass, &oclWorkGroup);
+
+    for( int i = 0; i < tuning.count; i++)
+    {
+        fprintf( gpLogFile, "%-20s work group %4d x %-3d : %.3f ms%s\n", ( tuning.candidate[i].kernel == GRASS_KERNEL_SEGMENT) ? grassSegmentKernelName : grassKernelName,
+            (int)tuning.candidate[i].local[0], (int)tuning.candidate[i].local[1], tuning.candidate[i].ms, ( i == tuning.best) ? "  best" : "");
+    }
+    fprintf( gpLogFile, "grass_kernel work group tuned on %d tiles ( grid class %d) in %.1f ms\n", (int)tileCount, gridClass, ( GrassProfileNow() - tuneStart) * 1.0e-6);
+}
+
+//
+//ResetOpenCLPipeline() :- wait for every frame in flight and forget them ( buffers or draw lists change)
+//
+void ResetOpenCLPipeline( void)
+{
+    //code
+    if( oclCommandQueue)
+    {
+        clFinish( oclCommandQueue);
+    }
+
+    for( int i = 0; i < OCL_INTEROP_BUFFERS; i++)
+    {
+        if( oclInterop[i].written)
+        {
+            clReleaseEvent( oclInterop[i].written);
+            oclInterop[i].written = NULL;
+        }
+
+        if( oclInterop[i].drawn)
+        {
+            glDeleteSync( oclInterop[i].drawn);
+            oclInterop[i].drawn = NULL;
+        }
+
+        oclInterop[i].valid = false;
+    }
+
+    oclComputeBuffer = 0;
+    oclDrawBuffer = 0;
+    oclLastFrameNs = 0;
+    grassField.invalidateSchedule();    //other frames in the buffers
+}
+
+//
+//AbortOpenCLFrame() :- error in the OpenCL part of UpdateGrassData(), host buffers give the mapped GL buffer back
+//
+void AbortOpenCLFrame( OCL_INTEROP_BUFFER *target)
+{
+    //code
+    if( bOpenCLHostBuffers && target->resource)
+    {
+            //commands already enqueued may still use the mapped memory
+        clFinish( oclCommandQueue);
+        clReleaseMemObject( target->resource);
+        target->resource = NULL;
+
+        glBindBuffer( GL_ARRAY_BUFFER, target->vbo);
+        glUnmapBuffer( GL_ARRAY_BUFFER);
+        glBindBuffer( GL_ARRAY_BUFFER, 0);
+    }
+
+    DestroyWindow( ghwnd);
+}
+
+//
+//UpdateGrassData()
+//
+void UpdateGrassData( void)
+{
+    //function declaration
+    int ReserveGrassBuffers( int);
+    int ReserveGrassIndices( int);
+    int ReserveGrassInput( int);
+    size_t GetGrassBufferBytes( int);
+    size_t GetGrassIndexBytes( void);
+    size_t GetGrassInputBytes( void);
+    void UpdateGrassDraws( void);
+    cl_event *OpenCLCommandEvent( int);
+    void CollectOpenCLCommandEvents( void);
+    int SetGrassKernelArgs( void);
+    void ResetOpenCLPipeline( void);
+    void CopyGrassDraws( GRASS_DRAW_LIST *, const GRASS_DRAW_LIST *);
+    void AbortOpenCLFrame( OCL_INTEROP_BUFFER *);
+
+    //variable declarations
+    vmath::mat4 cullViewMatrix = vmath::mat4::identity();
+    long long zoneStart;
 
     //code
+    GRASS_PROFILE_SCOPE( "UpdateGrassData");
 
     /****
      *   This initial update of vertices buffer and index buffer require whenever mesh size changes.
      ****/
     if( bNeedToUpdateBuffers)
     {
+        std::chrono::high_resolution_clock::time_point resizeStart = std::chrono::high_resolution_clock::now();
+
+            //frames in flight were laid out for the old grid / index mode
+        ResetOpenCLPipeline();
+
         grassVerticesCount = currentMeshWidth * currentMeshHeight;
 
-        CreateMesh( 0, 0, currentMeshWidth, currentMeshHeight, MESH_MULTIPLICANT, MESH_AMPLITUDE, meshVertexData, HeightCalculate);
-
-        //fill opencl buffer
-        int bufferSize = grassVerticesCount * sizeof(VERTEX);
-        clResult = clEnqueueWriteBuffer(
-            oclCommandQueue,
-            meshVertexData_opencl_input,
-            CL_FALSE,
-            0,
-            bufferSize,
-            meshVertexData,
-            0,
-            NULL, NULL
-        );
-        if( clResult != CL_SUCCESS)
+        if( ReserveGrassBuffers( grassVerticesCount) != 0)
         {
-            fprintf( gpLogFile, "OpenCL Error: clEnqueueWriteBuffer() Failed: %d\n", clResult);
             DestroyWindow( ghwnd);
             return;
         }
-        
-        //Update Index Buffer
-        //glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, grassMeshBuffer.vbo_element);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vbo_element_common);
-        GLuint *indexBufferPtr = (GLuint *) glMapBuffer( GL_ELEMENT_ARRAY_BUFFER, GL_WRITE_ONLY);
 
-        int indexPointer = 0;
-        for( int i = 0; i < grassVerticesCount; i++)
+        if( ReserveGrassInput( grassVerticesCount) != 0)
         {
-            for( int j = 0; j < GRASS_BLADE_SEGMENTS - 1; j++)
-            {
-                indexBufferPtr[indexPointer++] = (i * verticesPerBlade) + (2 * j + 0);
-                indexBufferPtr[indexPointer++] = (i * verticesPerBlade) + (2 * j + 2);
-                indexBufferPtr[indexPointer++] = (i * verticesPerBlade) + (2 * j + 3);
-
-                indexBufferPtr[indexPointer++] = (i * verticesPerBlade) + (2 * j + 0);
-                indexBufferPtr[indexPointer++] = (i * verticesPerBlade) + (2 * j + 3);
-                indexBufferPtr[indexPointer++] = (i * verticesPerBlade) + (2 * j + 1);
-            }
+            DestroyWindow( ghwnd);
+            return;
         }
-        grassIndicesCount = indexPointer;
 
+        int resizeResult = 0;
 
-        glUnmapBuffer( GL_ELEMENT_ARRAY_BUFFER);
-        indexBufferPtr = NULL;
-            //glBufferData(GL_ELEMENT_ARRAY_BUFFER, grassMeshBuffer.elementCount * sizeof(GLuint), grassIndexBuffer, GL_STATIC_DRAW);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        zoneStart = GrassProfileNow();
+        if( gbProceduralGrid)
+        {
+                //roots are computed from the blade index, nothing to upload
+            CreateGrid( 0, 0, currentMeshWidth, currentMeshHeight, MESH_MULTIPLICANT, &grassGrid);
+            GrassProfileRecord( "mesh rebuild", zoneStart, GrassProfileNow());
 
+            //Update grass static properties        //static means the properties which are not changing
+            resizeResult = grassField.resize( &grassGrid);
+        }
+        else
+        {
+            CreateMesh( 0, 0, currentMeshWidth, currentMeshHeight, MESH_MULTIPLICANT, MESH_AMPLITUDE, meshVertexData, HeightCalculate);
+
+            //fill opencl buffer
+            size_t bufferSize = (size_t)grassVerticesCount * sizeof(VERTEX);
+            clResult = clEnqueueWriteBuffer(
+                oclCommandQueue,
+                meshVertexData_opencl_input,
+                CL_FALSE,
+                0,
+                bufferSize,
+                meshVertexData,
+                0,
+                NULL, OpenCLCommandEvent( OCL_COMMAND_WRITE_MESH)
+            );
+            if( clResult != CL_SUCCESS)
+            {
+                fprintf( gpLogFile, "OpenCL Error: clEnqueueWriteBuffer() Failed: %d\n", clResult);
+                DestroyWindow( ghwnd);
+                return;
+            }
+            GrassProfileRecord( "mesh rebuild", zoneStart, GrassProfileNow());
 
+            //Update grass static properties        //static means the properties which are not changing
+            resizeResult = grassField.resize( currentMeshWidth, currentMeshHeight, meshVertexData);
+        }
 
-        //Update grass static properties        //static means the properties which are not changing
-        Vector3f pos, normal, tangent;
-        float angle;
-        for (int i = 0; i < grassVerticesCount; i++)
+        if( resizeResult != 0)
         {
-            pos = *((Vector3f *) &meshVertexData[i].position);
-            normal = *((Vector3f *) &meshVertexData[i].normal);
-            tangent = *((Vector3f *) &meshVertexData[i].tangent);
-            
-            Vector3f biNormal = normal.cross(tangent);
+            fprintf( gpLogFile, "GrassField::resize() Failed\n");
+            DestroyWindow( ghwnd);
+            return;
+        }
 
-            grassStaticProps_cpu[i].tangentToLocalMatrix = vmath::mat4(
-                vmath::vec4( tangent.x,  tangent.y,  tangent.z,  0.0f),
-                vmath::vec4( biNormal.x, biNormal.y, biNormal.z, 0.0f),
-                vmath::vec4( normal.x,   normal.y,   normal.z,   0.0f),
-                vmath::vec4( 0.0f, 0.0f, 0.0f, 1.0f)
-            );
+        //Update Index Buffer
+        std::chrono::high_resolution_clock::time_point indexStart = std::chrono::high_resolution_clock::now();
+        zoneStart = GrassProfileNow();
 
-            //random rotation of vertex but consistent between frames
-            angle = random( vmath::vec3( pos.x, pos.y, pos.z)) * mymath::TWO_PI;
-            grassStaticProps_cpu[i].facingRotationMatrix = RotationMatrix( angle, 0.0f, 0.0f, 1.0f);//vmath::rotate( vmath::degrees( angle), 0.0f, 0.0f, 1.0f);
+        if( ReserveGrassIndices( grassVerticesCount) != 0)
+        {
+            DestroyWindow( ghwnd);
+            return;
+        }
 
-            //rotate grass along X-axis
-            angle = random( vmath::vec3( pos.z, pos.z, pos.x)) * grassBendRotationRandom * mymath::PI * 0.5f;
-            grassStaticProps_cpu[i].bendRotationMatrix = RotationMatrix( angle, -1.0f, 0.0f, 0.0f);
-            
-            //blade width and height
-            grassStaticProps_cpu[i].width  = ( random( vmath::vec3( pos.x, pos.z, pos.y)) * 2.0f - 1.0f) * grassBladeWidthRandom + grassBladeWidth;
-            grassStaticProps_cpu[i].height = ( random( vmath::vec3( pos.z, pos.y, pos.x)) * 2.0f - 1.0f) * grassBladeHeightRandom + grassBladeHeight;
+            //include the upload, otherwise the driver defers it to the first draw
+        glFinish();
+        GrassProfileRecord( "index build", zoneStart, GrassProfileNow());
 
-            //for curvature of grass we add Y-offset in each vertex. ( Y-offset in tangent space)
-            grassStaticProps_cpu[i].forward = random( vmath::vec3( pos.y, pos.y, pos.z)) * grassBladeForwardAmount;
+        std::chrono::high_resolution_clock::time_point resizeEnd = std::chrono::high_resolution_clock::now();
+        grassIndexMs = std::chrono::duration<double, std::milli>( resizeEnd - indexStart).count();
+        grassResizeMs = std::chrono::duration<double, std::milli>( resizeEnd - resizeStart).count();
 
-        }
+        fprintf( gpLogFile, "Grass memory [%d x %d]: used %.2f MB, reserved %.2f MB\n",
+            currentMeshWidth, currentMeshHeight,
+            (GetGrassBufferBytes( grassVerticesCount) + grassField.getUsedBytes() + GetGrassIndexBytes() + GetGrassInputBytes()) / (1024.0 * 1024.0),
+            (GetGrassBufferBytes( grassBladeCapacity) + grassField.getReservedBytes() + GetGrassIndexBytes() + GetGrassInputBytes()) / (1024.0 * 1024.0));
+
+        fprintf( gpLogFile, "Grass roots [%d x %d]: %s, input %.2f MB\n",
+            currentMeshWidth, currentMeshHeight,
+            gbProceduralGrid ? "procedural grid" : "mesh",
+            GetGrassInputBytes() / (1024.0 * 1024.0));
+
+        fprintf( gpLogFile, "Grass indices [%d x %d]: %s, %.2f MB, index update %.3f ms, resize %.3f ms\n",
+            currentMeshWidth, currentMeshHeight,
+            ( grassIndexMode == GRASS_INDEX_TEMPLATE) ? "template" : "full",
+            GetGrassIndexBytes() / (1024.0 * 1024.0), grassIndexMs, grassResizeMs);
 
         bNeedToUpdateBuffers = false;
+        bGrassKernelArgsDirty = true;
+    }
+
+    /****
+     *   Frustum culling : only tiles in view are simulated and drawn ( grass model matrix is identity)
+     ****/
+    std::chrono::high_resolution_clock::time_point cullStart = std::chrono::high_resolution_clock::now();
+
+#if USE_FREE_CAMERA
+    cullViewMatrix = g_camera->getViewMatrix();
+#endif
+
+#if USE_ARC_CAMERA
+    cullViewMatrix = g_arcCamera.getViewMatrix();
+#endif
+
+    vmath::mat4 viewProjection = projection_matrix * cullViewMatrix;
+
+        //camera position from the rigid view matrix : -transpose( rotation) * translation
+    vmath::vec3 eye;
+    for( int k = 0; k < 3; k++)
+    {
+        eye[k] = -( cullViewMatrix[k][0] * cullViewMatrix[3][0] + cullViewMatrix[k][1] * cullViewMatrix[3][1] + cullViewMatrix[k][2] * cullViewMatrix[3][2]);
     }
 
+        //full indices only cover level 0 packed in visible order
+    bool templateIndices = ( grassIndexMode == GRASS_INDEX_TEMPLATE);
+    grassField.lod.levels = ( gbGrassLod && templateIndices) ? GRASS_LOD_LEVELS : 1;
+        //skipped tiles keep the vertices of an earlier frame, only one buffer has them in the pipelined mode
+    grassField.schedule.enabled = gbGrassSchedule && templateIndices && !( bOnGPU && ( oclPipelineDepth > 1));
+
+    grassVisibleBlades = grassField.cull( gbCullGrass ? &viewProjection : NULL, templateIndices ? &eye : NULL);
+    grassField.scheduleUpdates( 0.5f * g_windowHeight * projection_matrix[1][1]);
+    UpdateGrassDraws();
 
+    std::chrono::high_resolution_clock::time_point updateStart = std::chrono::high_resolution_clock::now();
+    grassCullMs = std::chrono::duration<double, std::milli>( updateStart - cullStart).count();
 
     if( bOnGPU )
     {
-        unsigned int mesh_width = currentMeshWidth;
-        unsigned int mesh_height = currentMeshHeight;
-        unsigned int grassBladeSegment = GRASS_BLADE_SEGMENTS;
-        
-        //Set Parameter of kernel
-        clResult = clSetKernelArg( oclGrassKernel, 0, sizeof( cl_mem), (void *) &cl_graphics_resource_mesh);
-        if( CL_SUCCESS != clResult)
-        {
-            fprintf( gpLogFile, "clSetKernelArg() for 0 failed\n");
-            DestroyWindow( ghwnd);
-        }
+        int updateTileCount = grassField.getUpdateTileCount();
+        OCL_INTEROP_BUFFER *target = &oclInterop[ oclComputeBuffer];
+        long long hostWaitNs = 0;
 
-        clResult = clSetKernelArg( oclGrassKernel, 1, sizeof( cl_mem), (void *)&meshVertexData_opencl_input);
-        if( CL_SUCCESS != clResult)
+        zoneStart = GrassProfileNow();
+        if( oclLastFrameNs != 0)
         {
-            fprintf( gpLogFile, "clSetKernelArg() for 1 failed\n");
-            DestroyWindow( ghwnd);
+            GrassProfileStatAdd( &oclFrameMs[ oclPipelineDepth - 1], ( zoneStart - oclLastFrameNs) * 1.0e-6f);
         }
+        oclLastFrameNs = zoneStart;
 
-        clResult = clSetKernelArg( oclGrassKernel, 2, sizeof( cl_uint), (void *)&mesh_width);
-        if( CL_SUCCESS != clResult)
+        if( bGrassKernelArgsDirty && ( SetGrassKernelArgs() != 0))
         {
-            fprintf( gpLogFile, "clSetKernelArg() for 2 failed\n");
             DestroyWindow( ghwnd);
+            return;
         }
 
-        clResult = clSetKernelArg( oclGrassKernel, 3, sizeof( cl_uint), (void *)&mesh_height);
-        if( CL_SUCCESS != clResult)
+            //GL has to be done reading the buffer before OpenCL writes it, drawn one or more frames ago
+        if( target->drawn)
         {
-            fprintf( gpLogFile, "clSetKernelArg() for 3 failed\n");
-            DestroyWindow( ghwnd);
+            long long waitStart = GrassProfileNow();
+            glClientWaitSync( target->drawn, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+            glDeleteSync( target->drawn);
+            target->drawn = NULL;
+            hostWaitNs += GrassProfileNow() - waitStart;
         }
 
-        clResult = clSetKernelArg( oclGrassKernel, 4, sizeof( cl_uint), (void *)&grassBladeSegment);
-        if( CL_SUCCESS != clResult)
+        if( target->written)
         {
-            fprintf( gpLogFile, "clSetKernelArg() for 4 failed\n");
-            DestroyWindow( ghwnd);
+            clReleaseEvent( target->written);
+            target->written = NULL;
         }
 
-        clResult = clSetKernelArg( oclGrassKernel, 5, sizeof( cl_mem), (void *)&distortionMap_opencl_input);
-        if( CL_SUCCESS != clResult)
+            //output offsets of the tiles regenerated this frame, from a copy the next cull cannot touch before the write is done
+        if( updateTileCount > 0)
         {
-            fprintf( gpLogFile, "clSetKernelArg() for 5 failed\n");
-            DestroyWindow( ghwnd);
+            memcpy( target->tiles, grassField.getUpdateTiles(), updateTileCount * sizeof( GRASS_LOD_TILE));
+
+            clResult = clEnqueueWriteBuffer( oclCommandQueue, grassTiles_opencl_input, CL_FALSE, 0, updateTileCount * sizeof( GRASS_LOD_TILE), target->tiles, 0, NULL, OpenCLCommandEvent( OCL_COMMAND_WRITE_TILES));
+            if( CL_SUCCESS != clResult)
+            {
+                fprintf( gpLogFile, "clEnqueueWriteBuffer() failed for grass tiles\n");
+                AbortOpenCLFrame( target);
+                return;
+            }
         }
 
-        clResult = clSetKernelArg( oclGrassKernel, 6, sizeof( cl_int), (void *)&windDistortion_map.width);
-        if( CL_SUCCESS != clResult)
+            //no sharing : the kernel writes the mapped GL buffer through a buffer on the same memory, like the CPU path
+        if( bOpenCLHostBuffers)
         {
-            fprintf( gpLogFile, "clSetKernelArg() for 6 failed\n");
-            DestroyWindow( ghwnd);
+            size_t vertexBufferSize = (size_t)grassBladeCapacity * 2 * GRASS_BLADE_SEGMENTS * sizeof( GRASS_VERTEX);
+
+            glBindBuffer( GL_ARRAY_BUFFER, target->vbo);
+            void *grassVertex = glMapBuffer( GL_ARRAY_BUFFER, GL_WRITE_ONLY);
+            if( grassVertex == NULL)
+            {
+                fprintf( gpLogFile, "glMapBuffer() failed for the grass buffer\n");
+                glBindBuffer( GL_ARRAY_BUFFER, 0);
+                DestroyWindow( ghwnd);
+                return;
+            }
+
+            target->resource = clCreateBuffer( oclContext, CL_MEM_WRITE_ONLY | CL_MEM_USE_HOST_PTR, vertexBufferSize, grassVertex, &clResult);
+            if( CL_SUCCESS != clResult)
+            {
+                fprintf( gpLogFile, "clCreateBuffer() failed for the mapped grass buffer\n");
+                target->resource = NULL;
+                glUnmapBuffer( GL_ARRAY_BUFFER);
+                glBindBuffer( GL_ARRAY_BUFFER, 0);
+                DestroyWindow( ghwnd);
+                return;
+            }
+            glBindBuffer( GL_ARRAY_BUFFER, 0);
         }
 
-        clResult = clSetKernelArg( oclGrassKernel, 7, sizeof( cl_int), (void *)&windDistortion_map.height);
+            //only the output buffer and the time change every frame, the rest is set by SetGrassKernelArgs()
+        clResult = SetGrassKernelArg( 0, sizeof( cl_mem), (void *) &target->resource);
         if( CL_SUCCESS != clResult)
         {
-            fprintf( gpLogFile, "clSetKernelArg() for 7 failed\n");
-            DestroyWindow( ghwnd);
+            fprintf( gpLogFile, "clSetKernelArg() for 0 failed\n");
+            AbortOpenCLFrame( target);
+            return;
         }
 
         float t = 0.8f * deltaTime;
-        clResult = clSetKernelArg( oclGrassKernel, 8, sizeof( cl_float), (void *)&t);
+        clResult = SetGrassKernelArg( 8, sizeof( cl_float), (void *)&t);
         if( CL_SUCCESS != clResult)
         {
             fprintf( gpLogFile, "clSetKernelArg() for 8 failed\n");
-            DestroyWindow( ghwnd);
+            AbortOpenCLFrame( target);
+            return;
         }
 
         //map resource
-        clResult = clEnqueueAcquireGLObjects( oclCommandQueue, 1, &cl_graphics_resource_mesh, 0, NULL, NULL);
+        clResult = bOpenCLHostBuffers ? CL_SUCCESS : clEnqueueAcquireGLObjects( oclCommandQueue, 1, &target->resource, 0, NULL, OpenCLCommandEvent( OCL_COMMAND_ACQUIRE));
         if( CL_SUCCESS != clResult)
         {
             fprintf( gpLogFile, "clEnqueueAcquireGLObjects() Failed\n");
-            DestroyWindow( ghwnd);
+            AbortOpenCLFrame( target);
+            return;
         }
 
-        //run kernel
-        size_t globalWorkSize[2];
-        globalWorkSize[0] = mesh_width;
-        globalWorkSize[1] = mesh_height;
-
-        clResult = clEnqueueNDRangeKernel(
-            oclCommandQueue,
-            oclGrassKernel,
-            2,              //Work Dimension
-            NULL,           //global_work_offset
-            globalWorkSize, //global work size
-            NULL,           //local work size
-            0,
-            NULL,
-            NULL
-        );
-        if( CL_SUCCESS != clResult)
+        //run kernel, blades ( or blade segments) of a tile x update tiles
+        if( updateTileCount > 0)
         {
-            fprintf( gpLogFile, "clEnqueueNDRangeKernel() failed\n");
-            DestroyWindow( ghwnd);
+            void SelectGrassWorkGroup( int gridClass, size_t tileCount);
+
+            int gridClass = GrassWorkGroupClass( currentMeshWidth, currentMeshHeight);
+            if( gridClass != oclWorkGroupClass)
+            {
+                SelectGrassWorkGroup( gridClass, updateTileCount);
+            }
+
+            cl_uint tileCount = updateTileCount;
+            clResult = SetGrassKernelArg( GRASS_KERNEL_ARG_TILE_COUNT, sizeof( cl_uint), (void *)&tileCount);
+            if( CL_SUCCESS != clResult)
+            {
+                fprintf( gpLogFile, "clSetKernelArg() for %d failed\n", GRASS_KERNEL_ARG_TILE_COUNT);
+                AbortOpenCLFrame( target);
+                return;
+            }
+
+                //tiles padded up to the work group, the kernel skips the padding
+            size_t globalWorkSize[2];
+            const size_t *localWorkSize = GrassWorkGroupRange( &oclWorkGroup, updateTileCount, grassField.params.segments, globalWorkSize);
+
+            clResult = clEnqueueNDRangeKernel(
+                oclCommandQueue,
+                ( oclWorkGroup.kernel == GRASS_KERNEL_SEGMENT) ? oclGrassSegmentKernel : oclGrassKernel,
+                2,                  //Work Dimension
+                NULL,               //global_work_offset
+                globalWorkSize,     //global work size
+                localWorkSize,      //local work size, NULL : driver choice
+                0,
+                NULL,
+                OpenCLCommandEvent( OCL_COMMAND_KERNEL)
+            );
+            if( CL_SUCCESS != clResult)
+            {
+                fprintf( gpLogFile, "clEnqueueNDRangeKernel() failed\n");
+                AbortOpenCLFrame( target);
+                return;
+            }
         }
 
-        //unmape / release resource
-        clResult = clEnqueueReleaseGLObjects( oclCommandQueue, 1, &cl_graphics_resource_mesh, 0, NULL, NULL);
+        //unmape / release resource, its event tells when the buffer can be drawn
+        cl_event *releaseEvent = OpenCLCommandEvent( OCL_COMMAND_RELEASE);
+        if( bOpenCLHostBuffers)
+        {
+                //map / unmap makes the kernel output visible in the host memory, no copy when it is that memory already
+            void *mapped = clEnqueueMapBuffer( oclCommandQueue, target->resource, CL_FALSE, CL_MAP_READ, 0, (size_t)grassBladeCapacity * 2 * GRASS_BLADE_SEGMENTS * sizeof( GRASS_VERTEX),
+                                0, NULL, NULL, &clResult);
+            if( CL_SUCCESS == clResult)
+            {
+                clResult = clEnqueueUnmapMemObject( oclCommandQueue, target->resource, mapped, 0, NULL, ( releaseEvent != NULL) ? releaseEvent : &target->written);
+            }
+        }
+        else
+        {
+            clResult = clEnqueueReleaseGLObjects( oclCommandQueue, 1, &target->resource, 0, NULL, ( releaseEvent != NULL) ? releaseEvent : &target->written);
+        }
         if( CL_SUCCESS != clResult)
         {
             fprintf( gpLogFile, "clEnqueueReleaseGLObjects() failed\n");
-            DestroyWindow( ghwnd);
+            AbortOpenCLFrame( target);
+            return;
+        }
+        else if( releaseEvent != NULL)
+        {
+            target->written = *releaseEvent;
+            clRetainEvent( target->written);
         }
 
-        clResult = clFinish( oclCommandQueue);
-        if( CL_SUCCESS != clResult)
+        CopyGrassDraws( &target->draws, &grassDraws);
+        target->enqueueNs = zoneStart;
+        target->valid = true;
+
+        GrassProfileRecord( "opencl enqueue", zoneStart, GrassProfileNow());
+
+        zoneStart = GrassProfileNow();
+        if( oclPipelineDepth == 1)
         {
-            fprintf( gpLogFile, "clFinish() failed\n");
-            DestroyWindow( ghwnd);
+            clResult = clFinish( oclCommandQueue);
+            if( CL_SUCCESS != clResult)
+            {
+                fprintf( gpLogFile, "clFinish() failed\n");
+                AbortOpenCLFrame( target);
+                return;
+            }
+            GrassProfileRecord( "opencl finish", zoneStart, GrassProfileNow());
+
+            oclDrawBuffer = oclComputeBuffer;
+
+                //kernel done, the GL buffer gets its storage back
+            if( bOpenCLHostBuffers)
+            {
+                clReleaseMemObject( target->resource);
+                target->resource = NULL;
+
+                glBindBuffer( GL_ARRAY_BUFFER, target->vbo);
+                glUnmapBuffer( GL_ARRAY_BUFFER);
+                glBindBuffer( GL_ARRAY_BUFFER, 0);
+            }
+        }
+        else
+        {
+                //submit without waiting, draw the oldest frame in flight ( the one just enqueued while the pipeline fills)
+            clFlush( oclCommandQueue);
+
+            int drawBuffer = ( oclComputeBuffer + 1) % oclPipelineDepth;
+            oclDrawBuffer = oclInterop[ drawBuffer].valid ? drawBuffer : oclComputeBuffer;
+            oclComputeBuffer = drawBuffer;
+
+                //enqueued a frame or more ago, normally complete by now
+            if( oclInterop[ oclDrawBuffer].written)
+            {
+                clWaitForEvents( 1, &oclInterop[ oclDrawBuffer].written);
+            }
+            GrassProfileRecord( "opencl wait", zoneStart, GrassProfileNow());
         }
+        hostWaitNs += GrassProfileNow() - zoneStart;
+
+        CollectOpenCLCommandEvents();
+
+        GrassProfileStatAdd( &oclHostWaitMs[ oclPipelineDepth - 1], hostWaitNs * 1.0e-6f);
 
+        grassUpdateMs = std::chrono::duration<double, std::milli>( std::chrono::high_resolution_clock::now() - updateStart).count();
 
         // glBindBuffer(GL_ARRAY_BUFFER, vbo_grassBuffer_opencl);
         // GRASS_VERTEX *grassVertex = (GRASS_VERTEX *) glMapBuffer( GL_ARRAY_BUFFER, GL_READ_ONLY);  //get pointer from buffer so we can update data into it
@@ -2736,113 +3758,21 @@ void UpdateGrassData( void)
     }
     else
     {
-        int i, j;
-        float t;
-        float segmentHeight, segmentWidth, segmentForward;
-        Vector3f pos;
-
-        vmath::vec4 tangentPoint;
-        vmath::vec4 localPosition;
-        vmath::vec4 tangentNormal;
-        vmath::vec4 localNormal;
-
-        vmath::mat4 transformationMatrix;
-        vmath::mat4 baseTransformationMatrix;
-        vmath::mat4 windRotationMatrix;
-
-        vmath::vec2 uv;
-        vmath::vec4 color;
-        vmath::vec2 windSample;
-        vmath::vec3 windDirection;
-
-        vmath::vec2 windParam = windOffset + windFrequency * deltaTime;
-        int index;
-
+        zoneStart = GrassProfileNow();
         glBindBuffer(GL_ARRAY_BUFFER, vbo_grassBuffer_cpu);
         GRASS_VERTEX *grassVertex = (GRASS_VERTEX *) glMapBuffer( GL_ARRAY_BUFFER, GL_WRITE_ONLY);  //get pointer from buffer so we can update data into it
+        GrassProfileRecord( "map buffer", zoneStart, GrassProfileNow());
 
-            for (i = 0; i < grassVerticesCount; i++)        // grass position
-            {
-                pos = *((Vector3f *) &meshVertexData[i].position);
-
-                // //ADD WIND
-                uv = vmath::vec2( pos.x, pos.z) * windScale + windParam;
-                color = getTexel( uv, &windDistortion_map);
-
-                windSample = ( (vmath::vec2( color[0], color[1]) * 2.0f) - 1.0f) * windStrength;
-                    //normalize vector representing direction
-                // vmath::vec3 wind = vmath::normalize( vmath::vec3( 0.0f, windSample[0], 0.0f));
-                windDirection = vmath::normalize( vmath::vec3( windSample[0], windSample[1], 0.0f));
-                    //construct matrix to rotate above vector
-                windRotationMatrix = RotationMatrix( mymath::PI * windSample[0], windDirection[0], windDirection[1], windDirection[2]);
-
-                    //for base vertices, we don't want to bend or rotate base vertices
-                baseTransformationMatrix = grassStaticProps_cpu[i].tangentToLocalMatrix * grassStaticProps_cpu[i].facingRotationMatrix;
-
-                    //for vertices other than base  vertices, as we want them to move with wind
-                transformationMatrix = grassStaticProps_cpu[i].tangentToLocalMatrix * windRotationMatrix * grassStaticProps_cpu[i].facingRotationMatrix * grassStaticProps_cpu[i].bendRotationMatrix;
-
-
-                for( j = 0; j < GRASS_BLADE_SEGMENTS; j++)      //vertices of single grass blade
-                {
-                    index = verticesPerBlade * i + 2*j;
-
-                    t = (float)j / (float)(GRASS_BLADE_SEGMENTS - 1);
-
-                    segmentWidth = grassStaticProps_cpu[i].width * ( 1 - t);
-                    segmentHeight = grassStaticProps_cpu[i].height * t;
-                    // segmentForward = grassStaticProps[i].forward * t;
-                    segmentForward = powf( t, 2.0f * grassBladeCurvatureAmount) * grassStaticProps_cpu[i].forward;
-
-                    tangentNormal = vmath::vec4( 0.0f, -1.0f, segmentForward, 0.0f);
-                    localNormal = ((j == 0) ? baseTransformationMatrix : transformationMatrix) * tangentNormal;
-
-                        //////////////////////////////////////////
-                    tangentPoint = vmath::vec4( segmentWidth, segmentForward, segmentHeight, 0.0f);
-                    localPosition = ((j == 0) ? baseTransformationMatrix : transformationMatrix) * tangentPoint;    //don't bend base vertices
-                    localPosition[0] += pos.x;
-                    localPosition[1] += pos.y;
-                    localPosition[2] += pos.z;
-
-                    //memcpy( grassVertex[index + 0].position, &localPosition[0], sizeof(float) * 3);
-                    grassVertex[index + 0].position[0] = localPosition[0];
-                    grassVertex[index + 0].position[1] = localPosition[1];
-                    grassVertex[index + 0].position[2] = localPosition[2];
-
-                    // memcpy( grassVertex[index + 0].normal, &localNormal[0], sizeof(float) * 3);
-                    grassVertex[index + 0].normal[0] = localNormal[0];
-                    grassVertex[index + 0].normal[1] = localNormal[1];
-                    grassVertex[index + 0].normal[2] = localNormal[2];
-
-                    grassVertex[index + 0].texcoord[0] = 0.0f;
-                    grassVertex[index + 0].texcoord[1] = t;
-
-
-                        //////////////////////////////////////////
-                    tangentPoint = vmath::vec4( -segmentWidth, segmentForward, segmentHeight, 0.0f);
-                    localPosition = ((j == 0) ? baseTransformationMatrix : transformationMatrix) * tangentPoint;    //don't bend base vertices
-                    localPosition[0] += pos.x;
-                    localPosition[1] += pos.y;
-                    localPosition[2] += pos.z;
-
-                    // memcpy( grassVertex[index + 1].position, &localPosition[0], sizeof(float) * 3);
-                    grassVertex[index + 1].position[0] = localPosition[0];
-                    grassVertex[index + 1].position[1] = localPosition[1];
-                    grassVertex[index + 1].position[2] = localPosition[2];
-
-                    // memcpy( grassVertex[index + 1].normal, &localNormal[0], sizeof(float) * 3);
-                    grassVertex[index + 1].normal[0] = localNormal[0];
-                    grassVertex[index + 1].normal[1] = localNormal[1];
-                    grassVertex[index + 1].normal[2] = localNormal[2];
-
-                    grassVertex[index + 1].texcoord[0] = 1.0f;
-                    grassVertex[index + 1].texcoord[1] = t;
-                }
-            }
+            grassWindMap.procedural = gbProceduralWind;
+            grassField.simulate( deltaTime, &grassWindMap, grassVertex, grassField.getVertexCount());
 
+        zoneStart = GrassProfileNow();
         glUnmapBuffer( GL_ARRAY_BUFFER);
         grassVertex = NULL;
         glBindBuffer(GL_ARRAY_BUFFER, 0);
+        GrassProfileRecord( "unmap buffer", zoneStart, GrassProfileNow());
+
+        grassUpdateMs = std::chrono::duration<double, std::milli>( std::chrono::high_resolution_clock::now() - updateStart).count();
 
 
         // glBindBuffer(GL_ARRAY_BUFFER, vbo_grassBuffer_cpu);
@@ -2866,6 +3796,68 @@ void UpdateGrassData( void)
     }
 }
 
+//
+//GetGrassCullSavedMs() :- estimated update time of the culled blades, at the cost per blade of the visible ones
+//
+double GetGrassCullSavedMs( void)
+{
+    //code
+    if( grassVisibleBlades <= 0)
+    {
+        return( 0.0);
+    }
+
+    return( grassUpdateMs * ( grassField.getBladeCount() - grassVisibleBlades) / grassVisibleBlades - grassCullMs);
+}
+
+//
+//LogGrassCulling() :- visible blades of the last frame
+//
+void LogGrassCulling( void)
+{
+    //function declaration
+    double GetGrassCullSavedMs( void);
+
+    //code
+    fprintf( gpLogFile, "Grass culling [%d x %d] %s: visible %d / %d blades ( %d / %d tiles, %d draws), cull %.3f ms, update %.3f ms, saved ~%.3f ms\n",
+        currentMeshWidth, currentMeshHeight, gbCullGrass ? "on" : "off",
+        grassVisibleBlades, grassField.getBladeCount(), grassField.getVisibleTileCount(), grassField.getTileCount(),
+        grassDraws.count, grassCullMs, grassUpdateMs, GetGrassCullSavedMs());
+
+    fprintf( gpLogFile, "Grass LOD %s: output %d vertices / %d at full detail, blades per level",
+        gbGrassLod ? "on" : "off", grassField.getOutputVertexCount(), grassVisibleBlades * GRASS_BLADE_SEGMENTS * 2);
+    for( int level = 0; level < GRASS_LOD_LEVELS; level++)
+    {
+        fprintf( gpLogFile, " %d ( %d seg)", grassField.getLevelBladeCount( level), grassField.getLevelSegments( level));
+    }
+    fprintf( gpLogFile, "\n");
+
+    fprintf( gpLogFile, "Grass time slicing %s: budget %d blades, regenerated %d / %d visible blades, amortization %.2f ( mean %.2f)\n",
+        grassField.schedule.enabled ? "on" : "off", grassField.schedule.bladeBudget, grassField.getUpdateBladeCount(), grassVisibleBlades,
+        grassField.getAmortization(), grassField.getMeanAmortization());
+}
+
+//
+//LogGrassThreadStats() :- per thread time of the last CPU grass update
+//
+void LogGrassThreadStats( void)
+{
+    //code
+    const GRASS_THREAD_STATS *stats = grassField.getThreadStats();
+    if( stats == NULL)
+    {
+        return;
+    }
+
+    fprintf( gpLogFile, "Grass CPU [%d x %d] %d threads: %.3f ms, load imbalance %.3f\n",
+        currentMeshWidth, currentMeshHeight, grassField.getThreadCount(), grassField.getSimulateMs(), grassField.getLoadImbalance());
+
+    for( int i = 0; i < grassField.getThreadCount(); i++)
+    {
+        fprintf( gpLogFile, "    thread %2d: %.3f ms busy, %d tiles (%d stolen)\n", i, stats[i].busyMs, stats[i].tasks, stats[i].stolen);
+    }
+}
+
 //
 //Uninitialize()
 //
@@ -2874,6 +3866,9 @@ void Uninitialize( void)
     //code
     PlaySoundA( NULL, NULL, NULL);
 
+    LogGrassThreadStats();
+    grassField.setThreadCount( 1);      //join workers before exit
+
     if( gbFullScreen == true)
     {
         SetWindowLong( ghwnd, GWL_STYLE, style | WS_OVERLAPPEDWINDOW);
@@ -2894,16 +3889,55 @@ void Uninitialize( void)
         distortionMap_opencl_input = NULL;
     }
 
+    if( distortionMap_opencl_image)
+    {
+        clReleaseMemObject( distortionMap_opencl_image);
+        distortionMap_opencl_image = NULL;
+    }
+
+    if( grassTiles_opencl_input)
+    {
+        clReleaseMemObject( grassTiles_opencl_input);
+        grassTiles_opencl_input = NULL;
+    }
+
     if( meshVertexData_opencl_input)
     {
         clReleaseMemObject( meshVertexData_opencl_input);
         meshVertexData_opencl_input = NULL;
     }
 
-    if( cl_graphics_resource_mesh)
+    if( meshVertexData)
+    {
+        free( meshVertexData);
+        meshVertexData = NULL;
+    }
+
+    for( int i = 0; i < OCL_INTEROP_BUFFERS; i++)
+    {
+        if( oclInterop[i].written)
+        {
+            clReleaseEvent( oclInterop[i].written);
+            oclInterop[i].written = NULL;
+        }
+
+        if( oclInterop[i].drawn)
+        {
+            glDeleteSync( oclInterop[i].drawn);
+            oclInterop[i].drawn = NULL;
+        }
+
+        if( oclInterop[i].resource)
+        {
+            clReleaseMemObject( oclInterop[i].resource);
+            oclInterop[i].resource = NULL;
+        }
+    }
+
+    if( oclGrassSegmentKernel)
     {
-        clReleaseMemObject( cl_graphics_resource_mesh);
-        cl_graphics_resource_mesh = NULL;
+        clReleaseKernel( oclGrassSegmentKernel);
+        oclGrassSegmentKernel = NULL;
     }
 
     if( oclGrassKernel)
@@ -2918,6 +3952,15 @@ void Uninitialize( void)
         oclGrassProgram = NULL;
     }
 
+    for( int i = 0; i < oclPendingEventCount; i++)
+    {
+        if( oclPendingEvents[i].event)
+        {
+            clReleaseEvent( oclPendingEvents[i].event);
+        }
+    }
+    oclPendingEventCount = 0;
+
     if( oclCommandQueue)
     {
         clReleaseCommandQueue( oclCommandQueue);
@@ -2964,17 +4007,14 @@ void Uninitialize( void)
     }
 
     //Buffers
-    if( grassStaticProps_cpu)
-    {
-        free( grassStaticProps_cpu);
-        grassStaticProps_cpu = NULL;
-    }
-
     DELETE_VERTEX_ARRAY( vao_light);
     DELETE_BUFFER( vbo_light);
 
-    DELETE_VERTEX_ARRAY(vao_grass_opencl)
-    DELETE_BUFFER(vbo_grassBuffer_opencl);
+    for( int i = 0; i < OCL_INTEROP_BUFFERS; i++)
+    {
+        DELETE_VERTEX_ARRAY( oclInterop[i].vao);
+        DELETE_BUFFER( oclInterop[i].vbo);
+    }
 
     DELETE_VERTEX_ARRAY( vao_grass_cpu);
     DELETE_BUFFER( vbo_grassBuffer_cpu);
@@ -2993,6 +4033,13 @@ void Uninitialize( void)
     //Texture
     windDistortion_map.Delete();
 
+    if( windDistortion_packed)
+    {
+        free( windDistortion_packed);
+        windDistortion_packed = NULL;
+    }
+    grassWindMap = GRASS_WIND_MAP();
+
     //Framebuffer
     sceneFramebuffer.Delete();
     msaaFramebuffer.Delete();
@@ -19,7 +19,15 @@ else goto BUILD
     LoadShaders.cpp ^
     TextureLoading.cpp ^
     Geometry.cpp ^
-    FreeType2DText.cpp
+    FreeType2DText.cpp ^
+    GrassField.cpp ^
+    GrassThreadPool.cpp ^
+    GrassProfiler.cpp ^
+    GrassProgramCache.cpp ^
+    GrassWorkGroupTuner.cpp ^
+    GrassOpenCL.cpp ^
+    GrassSimdAVX2.cpp ^
+    GrassSimdAVX512.cpp
 
 :LINK
     LINK.exe ^
@@ -32,6 +40,14 @@ else goto BUILD
     TextureLoading.obj ^
     Geometry.obj ^
     FreeType2DText.obj ^
+    GrassField.obj ^
+    GrassThreadPool.obj ^
+    GrassProfiler.obj ^
+    GrassProgramCache.obj ^
+    GrassWorkGroupTuner.obj ^
+    GrassOpenCL.obj ^
+    GrassSimdAVX2.obj ^
+    GrassSimdAVX512.obj ^
     Resource.res ^
     user32.lib ^
     gdi32.lib
@@ -51,7 +67,15 @@ else goto BUILD
     LoadShaders.cpp ^
     TextureLoading.cpp ^
     Geometry.cpp ^
-    FreeType2DText.cpp
+    FreeType2DText.cpp ^
+    GrassField.cpp ^
+    GrassThreadPool.cpp ^
+    GrassProfiler.cpp ^
+    GrassProgramCache.cpp ^
+    GrassWorkGroupTuner.cpp ^
+    GrassOpenCL.cpp ^
+    GrassSimdAVX2.cpp ^
+    GrassSimdAVX512.cpp
 
 
 :LINKx64
@@ -66,6 +90,14 @@ else goto BUILD
     TextureLoading.obj ^
     Geometry.obj ^
     FreeType2DText.obj ^
+    GrassField.obj ^
+    GrassThreadPool.obj ^
+    GrassProfiler.obj ^
+    GrassProgramCache.obj ^
+    GrassWorkGroupTuner.obj ^
+    GrassOpenCL.obj ^
+    GrassSimdAVX2.obj ^
+    GrassSimdAVX512.obj ^
     Resource.res ^
     user32.lib ^
     gdi32.lib
@@ -81,6 +113,14 @@ else goto BUILD
     TextureLoading.obj ^
     Geometry.obj ^
     FreeType2DText.obj ^
+    GrassField.obj ^
+    GrassThreadPool.obj ^
+    GrassProfiler.obj ^
+    GrassProgramCache.obj ^
+    GrassWorkGroupTuner.obj ^
+    GrassOpenCL.obj ^
+    GrassSimdAVX2.obj ^
+    GrassSimdAVX512.obj ^
     Resource.res
 
     goto EXIT
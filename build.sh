@@ -0,0 +1,63 @@
+#!/bin/sh
+# Headless tools (Linux / macOS). The renderer itself is built with build.bat.
+
+CXX=${CXX:-g++}
+CXXFLAGS=${CXXFLAGS:-"-O2 -g"}
+
+if [ "$1" = "clean" ]; then
+    rm -f GrassBench GrassStageBench *.o GrassProfile.json GrassProfile.csv
+    exit 0
+fi
+
+# OpenCL backend of GrassBench ( -backend compare) when the headers and an
+# ICD loader are there, grass_kernel then runs on a CPU device such as PoCL.
+# OPENCL_CFLAGS / OPENCL_LIBS override the defaults.
+OPENCL_CFLAGS=${OPENCL_CFLAGS:-""}
+OPENCL_LIBS=${OPENCL_LIBS:-"-lOpenCL"}
+if printf '#include <CL/opencl.h>\nint main(){ return( clFinish( 0)); }\n' | \
+    $CXX $OPENCL_CFLAGS -DCL_TARGET_OPENCL_VERSION=200 -x c++ - $OPENCL_LIBS -o /dev/null 2>/dev/null; then
+    BENCHFLAGS="$OPENCL_CFLAGS -DGRASS_BENCH_OPENCL -DCL_TARGET_OPENCL_VERSION=200"
+    BENCHLIBS="$OPENCL_LIBS"
+    BENCHSRCS="GrassProgramCache.cpp GrassWorkGroupTuner.cpp GrassOpenCL.cpp"
+else
+    echo "build.sh: no OpenCL headers / library, GrassBench is built without the OpenCL backend"
+fi
+
+# SIMD kernels get their instruction set per file, the rest stays baseline
+# and picks a kernel at run time (GrassSimdDetect). No mul + add contraction,
+# the wind texel lookup has to round like the scalar path.
+case `uname -m` in
+    x86_64|i?86|amd64)
+        AVX2FLAGS="-mavx2 -mfma -ffp-contract=off"
+        AVX512FLAGS="-mavx512f -mavx2 -mfma -ffp-contract=off"
+        ;;
+esac
+
+$CXX $CXXFLAGS $AVX2FLAGS -c GrassSimdAVX2.cpp -o GrassSimdAVX2.o || exit 1
+$CXX $CXXFLAGS $AVX512FLAGS -c GrassSimdAVX512.cpp -o GrassSimdAVX512.o || exit 1
+
+$CXX $CXXFLAGS $BENCHFLAGS -o GrassBench \
+    GrassBench.cpp \
+    $BENCHSRCS \
+    GrassField.cpp \
+    GrassThreadPool.cpp \
+    GrassProfiler.cpp \
+    GrassSimdAVX2.o \
+    GrassSimdAVX512.o \
+    $BENCHLIBS -lm -pthread || exit 1
+
+$CXX $CXXFLAGS -o GrassStageBench \
+    GrassStageBench.cpp \
+    GrassField.cpp \
+    GrassThreadPool.cpp \
+    GrassProfiler.cpp \
+    GrassSimdAVX2.o \
+    GrassSimdAVX512.o \
+    -lm -pthread || exit 1
+
+# ./build.sh test : every backend against the mat4 reference, fails on a difference
+if [ "$1" = "test" ]; then
+    ./GrassBench -backend compare -grid 128 -frames 10 || exit 1
+    ./GrassBench -backend compare -grid 100 -frames 10 -roots grid -windmap procedural || exit 1
+    ./GrassBench -grid 128 -frames 10 -threads all -trace GrassProfile.json || exit 1
+fi